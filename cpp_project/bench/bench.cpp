@@ -0,0 +1,525 @@
+// Benchmark suite: micro benchmarks of the board, cards, decks and rules plus
+// complete headless games. Prints one JSON object per benchmark (JSON Lines):
+//   {"name":"board/turnFaceUp","iterations":1048576,"ns_per_op":2.13}
+//
+// Usage: bench [--filter SUBSTRING] [--min-time MS]
+// Build with every source except src/main.cpp, e.g.
+//   g++ -std=c++17 -O2 -Iinclude bench/bench.cpp src/[!m]*.cpp -o bench -pthread
+
+#include "BatchEnv.h"
+#include "Board.h"
+#include "Card.h"
+#include "CardDeck.h"
+#include "RubisDeck.h"
+#include "Game.h"
+#include "GameEngine.h"
+#include "GameServer.h"
+#include "Matchmaker.h"
+#include "MoveLog.h"
+#include "Position.h"
+#include "ReplayArchive.h"
+#include "ReplayQuery.h"
+#include "Rules.h"
+#include "SpectatorRing.h"
+#include "Table.h"
+#include "TimerWheel.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static std::string filter;
+static double minTimeMs = 200.0;
+
+// Keeps the compiler from optimizing away benchmarked results
+template <typename T>
+static void doNotOptimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// Runs fn(iterations) with growing iteration counts until it lasts minTimeMs
+template <typename Fn>
+static void bench(const std::string& name, Fn fn) {
+    if (!filter.empty() && name.find(filter) == std::string::npos) return;
+
+    uint64_t iterations = 1;
+    double elapsedNs = 0;
+    while (true) {
+        auto start = std::chrono::steady_clock::now();
+        fn(iterations);
+        elapsedNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        if (elapsedNs >= minTimeMs * 1e6 || iterations >= (1ull << 40)) break;
+        iterations *= elapsedNs < minTimeMs * 1e5 ? 10 : 2;
+    }
+    std::cout << "{\"name\":\"" << name << "\",\"iterations\":" << iterations
+              << ",\"ns_per_op\":" << elapsedNs / iterations << "}\n";
+}
+
+// xorshift: cheap and deterministic move choices for headless games
+struct Random {
+    uint64_t state;
+    explicit Random(uint64_t seed) : state(seed ? seed : 1) {}
+    uint32_t next(uint32_t bound) {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return static_cast<uint32_t>(state % bound);
+    }
+};
+
+static bool pickRandom(const Game& game, Random& rng, bool wantFaceUp, Letter& l, Number& n) {
+    int candidates[24];
+    int count = 0;
+    for (int pos = 0; pos < 25; ++pos) {
+        if (pos == 12) continue;
+        Letter pl = static_cast<Letter>(pos / 5);
+        Number pn = static_cast<Number>(pos % 5);
+        if (game.getBoard().isFaceUp(pl, pn) == wantFaceUp && !game.isBlocked(pl, pn)) candidates[count++] = pos;
+    }
+    if (count == 0) return false;
+    int pos = candidates[rng.next(count)];
+    l = static_cast<Letter>(pos / 5);
+    n = static_cast<Number>(pos % 5);
+    return true;
+}
+
+// Plays a complete game with random legal moves; returns the number of picks
+template <typename Policy>
+static int playHeadless(int nPlayers, Random& rng) {
+    CardDeck& cardDeck = CardDeck::make_CardDeck();
+    RubisDeck& rubisDeck = RubisDeck::make_RubisDeck();
+    cardDeck.shuffle();
+    rubisDeck.shuffle();
+
+    Game game(cardDeck);
+    Rules rules;
+    for (int i = 0; i < nPlayers; ++i) game.addPlayer(Player("P", static_cast<Side>(i)));
+
+    GameEngine<Policy> engine(game, rules, rubisDeck);
+    int picks = 0;
+    while (!engine.isGameOver()) {
+        engine.startRound();
+        while (!engine.isRoundOver()) {
+            Letter l;
+            Number n;
+            if (engine.isAwaitingTarget()) {
+                FaceAnimal animal = (FaceAnimal)*game.getCurrentCard();
+                if (!pickRandom(game, rng, rules.getPower(animal) == AnimalPower::TurnDown, l, n)) {
+                    l = Letter::C;
+                    n = Number::Three;
+                }
+                engine.target(l, n);
+            } else {
+                if (!pickRandom(game, rng, false, l, n)) break;
+                engine.pick(l, n);
+                ++picks;
+            }
+        }
+        engine.finishRound();
+    }
+    return picks;
+}
+
+int main(int argc, char* argv[]) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--filter" && i + 1 < argc) filter = argv[++i];
+        else if (arg == "--min-time" && i + 1 < argc) minTimeMs = std::stod(argv[++i]);
+        else {
+            std::cerr << "Usage: bench [--filter SUBSTRING] [--min-time MS]\n";
+            return 1;
+        }
+    }
+
+    CardDeck& cardDeck = CardDeck::make_CardDeck();
+    RubisDeck& rubisDeck = RubisDeck::make_RubisDeck();
+
+    // -------------------
+    // Board
+    // -------------------
+    cardDeck.shuffle();
+    Board board(cardDeck);
+
+    bench("board/turnFaceUp", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            int pos = static_cast<int>(i % 24);
+            if (pos >= 12) ++pos;
+            doNotOptimize(board.turnFaceUp(static_cast<Letter>(pos / 5), static_cast<Number>(pos % 5)));
+        }
+    });
+
+    bench("board/isFaceUp", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            int pos = static_cast<int>(i % 24);
+            if (pos >= 12) ++pos;
+            doNotOptimize(board.isFaceUp(static_cast<Letter>(pos / 5), static_cast<Number>(pos % 5)));
+        }
+    });
+
+    bench("board/swapCards", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            board.swapCards(Letter::A, Number::One, Letter::A, Number::Two);
+        }
+        doNotOptimize(board.getCard(Letter::A, Number::One));
+    });
+
+    bench("board/allFacesDown", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            board.allFacesDown();
+            doNotOptimize(board);
+        }
+    });
+
+    bench("board/sightMask", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            Side side = static_cast<Side>(i & 3);
+            board.turnFaceUp(sightMask(side));
+            board.turnFaceDown(sightMask(side));
+        }
+        doNotOptimize(board.getFaceUpMask());
+    });
+
+    bench("board/render", [&](uint64_t iters) {
+        for (int pos = 0; pos < 25; pos += 2) {
+            if (pos != 12) board.turnFaceUp(static_cast<Letter>(pos / 5), static_cast<Number>(pos % 5));
+        }
+        std::ostringstream out;
+        for (uint64_t i = 0; i < iters; ++i) {
+            out.str(std::string());
+            out << board;
+        }
+        doNotOptimize(out.tellp());
+    });
+
+    // -------------------
+    // Card
+    // -------------------
+    const Card* card = board.getCard(Letter::B, Number::Two);
+    bench("card/row", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            std::string row = (*card)(static_cast<int>(i % 3));
+            doNotOptimize(row[1]);
+        }
+    });
+
+    // -------------------
+    // Position parsing: 1M moves as typed, mostly valid, with holes and malformed input mixed in
+    // -------------------
+    {
+        static const char* const kOddMoves[] = {"C3", " c 3", "Z9", "A", "", "AA1", "6B", "F1", "A6", "b 44", "\t"};
+        std::string text;
+        std::vector<std::pair<size_t, size_t>> tokens;
+        Random moveRng(99);
+        for (int i = 0; i < (1 << 20); ++i) {
+            std::string move;
+            uint32_t kind = moveRng.next(8);
+            if (kind < 6) {
+                // Valid in every spelling: "B4", "b4", " b 4 "
+                move = std::string(1, static_cast<char>((kind & 1 ? 'a' : 'A') + moveRng.next(5))) +
+                       static_cast<char>('1' + moveRng.next(5));
+                if (kind >= 4) move = " " + move.substr(0, 1) + " " + move.substr(1) + " ";
+            } else {
+                move = kOddMoves[moveRng.next(sizeof(kOddMoves) / sizeof(kOddMoves[0]))];
+            }
+            tokens.emplace_back(text.size(), move.size());
+            text += move;
+        }
+        bench("position/parseMixed", [&](uint64_t iters) {
+            uint64_t ok = 0;
+            for (uint64_t i = 0; i < iters; ++i) {
+                const auto& token = tokens[i & (tokens.size() - 1)];
+                Letter l;
+                Number n;
+                ok += parsePosition(std::string_view(text).substr(token.first, token.second), l, n) ==
+                      PositionStatus::Ok;
+            }
+            doNotOptimize(ok);
+        });
+    }
+
+    // -------------------
+    // Decks
+    // -------------------
+    bench("deck/shuffleCards", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            cardDeck.shuffle();
+            doNotOptimize(cardDeck);
+        }
+    });
+
+    bench("deck/shuffleRubis", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            rubisDeck.shuffle();
+            doNotOptimize(rubisDeck);
+        }
+    });
+
+    // -------------------
+    // Rules
+    // -------------------
+    cardDeck.shuffle();
+    Game game(cardDeck);
+    game.addPlayer(Player("A", Side::top));
+    game.addPlayer(Player("B", Side::bottom));
+    game.addPlayer(Player("C", Side::left));
+    game.addPlayer(Player("D", Side::right));
+    game.setCurrentCard(game.getCard(Letter::A, Number::One));
+    game.setCurrentCard(game.getCard(Letter::A, Number::Two));
+    Rules rules;
+
+    bench("rules/isValid", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) doNotOptimize(rules.isValid(game));
+    });
+
+    bench("rules/roundOver", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) doNotOptimize(rules.roundOver(game));
+    });
+
+    // -------------------
+    // Complete headless games
+    // -------------------
+    Random rng(12345);
+    bench("game/base2", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) doNotOptimize(playHeadless<BasePolicy>(2, rng));
+    });
+    bench("game/base4", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) doNotOptimize(playHeadless<BasePolicy>(4, rng));
+    });
+    bench("game/base8", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) doNotOptimize(playHeadless<BasePolicy>(8, rng));
+    });
+    bench("game/expert4", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) doNotOptimize(playHeadless<ExpertRulesPolicy>(4, rng));
+    });
+    bench("game/turnEffects4", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) doNotOptimize(playHeadless<RulePolicy<false, true, false>>(4, rng));
+    });
+
+    // -------------------
+    // Batched environment (ns per game step)
+    // -------------------
+    BatchEnv env(4096, 4, 7);
+    std::vector<uint8_t> actions(env.size()), dones(env.size());
+    std::vector<float> rewards(env.size() * env.seats());
+    bench("env/step4096x4", [&](uint64_t iters) {
+        uint64_t steps = (iters + env.size() - 1) / env.size();
+        for (uint64_t s = 0; s < steps; ++s) {
+            for (int g = 0; g < env.size(); ++g) actions[g] = static_cast<uint8_t>(rng.next(25));
+            env.step(actions.data(), rewards.data(), dones.data());
+            env.resetDone();
+        }
+        doNotOptimize(rewards[0]);
+    });
+
+    // -------------------
+    // Matchmaking (ns per join, 2-4 seat tables over every mode)
+    // -------------------
+    const int kJoinThreads = 4;
+    const int kClientsPerThread = 4096; // fds cycle: each was seated long before its turn comes again
+    Matchmaker matchmaker(4, 4096, kJoinThreads * kClientsPerThread);
+    std::atomic<uint64_t> formed(0);
+    auto joins = [&](int thread, uint64_t count) {
+        for (uint64_t i = 0; i < count; ++i) {
+            Ticket ticket{};
+            ticket.shard = thread;
+            ticket.fd = thread * kClientsPerThread + static_cast<int>(i % kClientsPerThread);
+            int bucket = static_cast<int>((i / kClientsPerThread) % 9); // one bucket per lap
+            matchmaker.join(bucket % 3, 2 + bucket / 3, ticket, [&](const Ticket*, int) {
+                formed.fetch_add(1, std::memory_order_relaxed);
+            });
+        }
+    };
+    bench("matchmaker/join", [&](uint64_t iters) { joins(0, iters); });
+    bench("matchmaker/join4threads", [&](uint64_t iters) {
+        std::vector<std::thread> threads;
+        for (int t = 0; t < kJoinThreads; ++t) threads.emplace_back(joins, t, iters / kJoinThreads);
+        for (std::thread& thread : threads) thread.join();
+    });
+    doNotOptimize(formed.load());
+
+    // -------------------
+    // Timer wheel, about 1M deadlines pending up to an hour out (10 ms ticks)
+    // -------------------
+    const size_t kPendingTimers = 1 << 20;
+    std::vector<TimerNode> timerNodes(kPendingTimers);
+    uint64_t wheelNow = 0;
+    TimerWheel wheel(wheelNow, 10);
+    for (TimerNode& node : timerNodes) wheel.schedule(node, 1000 + rng.next(3600000));
+    bench("timers/reschedule", [&](uint64_t iters) {
+        for (uint64_t i = 0; i < iters; ++i) {
+            wheel.schedule(timerNodes[i % kPendingTimers], wheelNow + 1000 + rng.next(3600000));
+        }
+    });
+    bench("timers/tick", [&](uint64_t iters) {
+        uint64_t fired = 0;
+        for (uint64_t i = 0; i < iters; ++i) {
+            wheelNow += 10;
+            wheel.advance(wheelNow, [&](TimerNode& node) {
+                ++fired;
+                wheel.schedule(node, wheelNow + 1000 + rng.next(3600000));
+            });
+        }
+        doNotOptimize(fired);
+    });
+
+    // -------------------
+    // Spectators: a delta frame published once, then taken by each of 500
+    // readers keeping up with the table (ns per delta)
+    // -------------------
+    SpectatorRing spectatorRing(4096);
+    std::vector<uint64_t> spectatorCursors(500, 0);
+    bench("spectator/fanout500", [&](uint64_t iters) {
+        uint8_t frame[16] = {20};
+        size_t taken = 0;
+        for (uint64_t i = 0; i < iters; ++i) {
+            frame[1] = static_cast<uint8_t>(i);
+            spectatorRing.publish(frame, sizeof(frame));
+            for (uint64_t& cursor : spectatorCursors) {
+                iovec parts[2];
+                int count = spectatorRing.read(cursor, parts);
+                for (int k = 0; k < count; ++k) taken += parts[k].iov_len;
+                cursor = spectatorRing.getHead();
+            }
+        }
+        doNotOptimize(taken);
+    });
+
+    // -------------------
+    // Replay queries: 1M synthetic four-seat games of 64 events, built into
+    // columns, then scanned with a filter and with a filter plus group-by,
+    // each over every thread (ns per event)
+    // -------------------
+    const char* kQueryArchive = "/tmp/memoarr_bench.marc";
+    if (filter.empty() || std::string("query/columns64M query/filter64M query/groupBy64M").find(filter) != std::string::npos) {
+        const int kGames = 1 << 20;
+        const int kEventsPerGame = 64;
+        ::unlink(kQueryArchive);
+        {
+            ReplayArchiveWriter writer(kQueryArchive);
+            Replay replay(4, 2);
+            for (int g = 0; g < kGames; ++g) {
+                replay.clear(4, 2);
+                for (int e = 0; e < kEventsPerGame; ++e) {
+                    bool award = e % 8 == 7;
+                    uint8_t card = static_cast<uint8_t>(rng.next(25));
+                    uint8_t flags = ReplayEvent::makeFlags(award || rng.next(3) != 0,
+                                                           award ? ReplayEffect::Award : ReplayEffect::None);
+                    replay.addEvent({static_cast<uint8_t>(1 + e / 8), static_cast<uint8_t>(rng.next(4)),
+                                     award ? kReplayNoPosition : card, card, flags, kReplayNoPosition});
+                }
+                writer.append(replay);
+            }
+        }
+        const uint64_t kEvents = static_cast<uint64_t>(kGames) * kEventsPerGame;
+        auto report = [&](const char* name, std::chrono::steady_clock::time_point start) {
+            double elapsedNs =
+                std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "{\"name\":\"" << name << "\",\"iterations\":" << kEvents
+                      << ",\"ns_per_op\":" << elapsedNs / kEvents << "}\n";
+        };
+        ReplayArchive archive(kQueryArchive);
+        auto start = std::chrono::steady_clock::now();
+        EventColumns table = EventColumns::fromArchive(archive);
+        report("query/columns64M", start);
+
+        // Elimination rate on the third reveal of a Walrus
+        start = std::chrono::steady_clock::now();
+        doNotOptimize(EventQuery().where(EventColumn::Animal, 4).where(EventColumn::Reveal, 3).run(table)[0].count);
+        report("query/filter64M", start);
+
+        // Rounds won by seat
+        start = std::chrono::steady_clock::now();
+        doNotOptimize(EventQuery().where(EventColumn::Effect, 6).groupBy(EventColumn::Seat).run(table).size());
+        report("query/groupBy64M", start);
+        ::unlink(kQueryArchive);
+    }
+
+    // -------------------
+    // Move log: appends with a sync per 4096 (one busy poll), and a server
+    // recovering 1M four-seat tables a few moves into their game (ns per table),
+    // then checkpointing them and recovering from the checkpoint alone
+    // -------------------
+    const char* kLogPath = "/tmp/memoarr_bench.wal";
+    ::unlink(kLogPath);
+    {
+        MoveLog log(kLogPath, 0, 1);
+        bench("wal/appendMove", [&](uint64_t iters) {
+            for (uint64_t i = 0; i < iters; ++i) {
+                log.appendMove(static_cast<uint32_t>(i), static_cast<int>(i & 3), static_cast<int>(i % 25));
+                if (i % 4096 == 4095) log.commit();
+            }
+            log.commit();
+        });
+    }
+    ::unlink(kLogPath);
+    if (filter.empty() || std::string("wal/recover1M wal/checkpoint1M wal/recoverCheckpoint1M").find(filter) != std::string::npos) {
+        const int kTables = 1 << 20;
+        {
+            MoveLog log(kLogPath, 0, 1);
+            CardDeck& cardDeck = CardDeck::make_CardDeck();
+            RubisDeck& rubisDeck = RubisDeck::make_RubisDeck();
+            const char* names[4] = {"Ann", "Bob", "Cy", "Dan"};
+            for (int t = 0; t < kTables; ++t) {
+                Table table(t, 0, 4, cardDeck, rubisDeck);
+                uint8_t deal[Table::kDealSize];
+                table.getDeal(deal);
+                log.appendOpen(static_cast<uint32_t>(t), 0, 4, deal);
+                for (int seat = 0; seat < 4; ++seat) {
+                    table.join(names[seat], -1);
+                    log.appendJoin(static_cast<uint32_t>(t), seat, names[seat]);
+                }
+                for (int move = 0; move < 12; ++move) {
+                    Letter l;
+                    Number n;
+                    if (!pickRandom(table.getGame(), rng, false, l, n)) break;
+                    int seat = table.getTurn();
+                    TableUpdate update;
+                    table.act(seat, l, n, update);
+                    log.appendMove(static_cast<uint32_t>(t), seat, update.position);
+                }
+                if (t % 4096 == 4095) log.commit();
+            }
+        }
+        ServerOptions options;
+        options.address = "unix:/tmp/memoarr_bench.sock";
+        options.wal = kLogPath;
+        options.checkpointInterval = 1;
+        std::string checkpointPath = std::string(kLogPath) + ".ckpt";
+        ::unlink(checkpointPath.c_str());
+        auto report = [&](const char* name, std::chrono::steady_clock::time_point start) {
+            double elapsedNs =
+                std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+            std::cout << "{\"name\":\"" << name << "\",\"iterations\":" << kTables
+                      << ",\"ns_per_op\":" << elapsedNs / kTables << "}\n";
+        };
+        auto start = std::chrono::steady_clock::now();
+        {
+            GameServer server(options);
+            report("wal/recover1M", start);
+            doNotOptimize(server.getTableCount());
+
+            // Slices of tables between polls until the checkpoint is synced and the log cut
+            std::this_thread::sleep_for(std::chrono::milliseconds(1100));
+            start = std::chrono::steady_clock::now();
+            struct stat st{};
+            while (::stat(kLogPath, &st) == 0 && st.st_size > static_cast<off_t>(sizeof(LogHeader))) server.poll(0);
+            report("wal/checkpoint1M", start);
+        }
+        start = std::chrono::steady_clock::now();
+        {
+            GameServer server(options);
+            report("wal/recoverCheckpoint1M", start);
+            doNotOptimize(server.getTableCount());
+        }
+        ::unlink(kLogPath);
+        ::unlink(checkpointPath.c_str());
+    }
+
+    return 0;
+}
@@ -0,0 +1,665 @@
+// Load generator for a running game server (`game --server ADDRESS`): threads of
+// binary bots (Wire.h) open connections to it and play whole games, expert
+// targets included, until the duration is up. Tables arrive at --rate games per
+// second (Poisson arrivals, open loop: a slow server builds a backlog instead
+// of slowing the arrivals down), or with --rate 0 --tables N stay busy back to
+// back to find the saturation point. The move round trip is measured from a
+// pick or target to the mover's own Delta and recorded in an HDR histogram
+// (log-linear buckets, under 1% error from nanoseconds to hours). A seat left
+// without a legal pick waits for the server's turn timeout (a stall), so run
+// the server with a short --turn-timeout. Prints one JSON object; --histogram
+// FILE also writes the percentile distribution in HdrHistogram's .hgrm format.
+//   {"name":"load","threads":4,"mode":"mixed","seats":4,"rate":0,"tables":512,"seconds":10.0,
+//    "connections":2048,"games":3100,"games_per_s":310,"moves":151000,"moves_per_s":15100,
+//    "rejected":40,"aborted":0,"stalls":0,"backlog_max":0,"rtt_us":{"p50":48.1,"p90":95.0,"p99":180.2,...}}
+//
+// Usage: load_gen --server unix:PATH|HOST:PORT [--threads N] [--rate GAMES_PER_S]
+//                 [--tables N] [--duration S] [--mode base|expert_display|expert_rules|mixed]
+//                 [--seats N] [--bot random|memory] [--seed N] [--histogram FILE]
+// Build with every source except src/main.cpp, e.g.
+//   g++ -std=c++17 -O2 -Iinclude bench/load_gen.cpp src/[!m]*.cpp -o load_gen -pthread
+
+#include "Exceptions.h"
+#include "Rules.h"
+#include "Wire.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using Clock = std::chrono::steady_clock;
+
+using Geometry = StandardGeometry;
+static const uint32_t kCells = Geometry::kCellMask; // every position but the hole
+
+static uint64_t nowNs() {
+    return static_cast<uint64_t>(
+        std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count());
+}
+
+// -------------------
+// HDR histogram
+// -------------------
+// Values below 2^kSubBits are counted exactly; above, each power of two is
+// split into 2^kSubBits equal buckets, so a bucket is within 1/128 of its values
+class HdrHistogram {
+public:
+    static const int kSubBits = 7;
+    static const uint64_t kSub = 1ull << kSubBits;
+
+private:
+    std::vector<uint64_t> counts;
+    uint64_t total;
+    uint64_t maxValue;
+    double sum;
+
+    static size_t indexOf(uint64_t value) {
+        if (value < kSub) return static_cast<size_t>(value);
+        int shift = 63 - __builtin_clzll(value) - kSubBits;
+        return static_cast<size_t>(kSub * shift + (value >> shift));
+    }
+    // Highest value counted in bucket index
+    static uint64_t highestOf(size_t index) {
+        if (index < kSub) return index;
+        uint64_t shift = index / kSub - 1;
+        uint64_t low = (kSub + index % kSub) << shift;
+        return low + (1ull << shift) - 1;
+    }
+
+public:
+    HdrHistogram() : counts(kSub * (64 - kSubBits + 1)), total(0), maxValue(0), sum(0) {}
+
+    void record(uint64_t value) {
+        ++counts[indexOf(value)];
+        ++total;
+        sum += static_cast<double>(value);
+        if (value > maxValue) maxValue = value;
+    }
+    void add(const HdrHistogram& other) {
+        for (size_t k = 0; k < counts.size(); ++k) counts[k] += other.counts[k];
+        total += other.total;
+        sum += other.sum;
+        maxValue = std::max(maxValue, other.maxValue);
+    }
+
+    uint64_t getTotal() const { return total; }
+    uint64_t getMax() const { return maxValue; }
+    double getMean() const { return total ? sum / static_cast<double>(total) : 0; }
+    // Smallest bucket value that at least fraction of the values do not exceed
+    uint64_t valueAt(double fraction) const {
+        if (total == 0) return 0;
+        uint64_t rank = static_cast<uint64_t>(std::ceil(fraction * static_cast<double>(total)));
+        if (rank == 0) rank = 1;
+        uint64_t seen = 0;
+        for (size_t k = 0; k < counts.size(); ++k) {
+            seen += counts[k];
+            if (seen >= rank) return std::min(highestOf(k), maxValue);
+        }
+        return maxValue;
+    }
+
+    // Percentile distribution as HdrHistogram's tools print it, values scaled by unit
+    void writeDistribution(std::ostream& out, double unit) const {
+        out << "       Value     Percentile TotalCount 1/(1-Percentile)\n\n";
+        char line[128];
+        uint64_t seen = 0;
+        double next = 0;
+        for (size_t k = 0; k < counts.size() && seen < total; ++k) {
+            if (counts[k] == 0) continue;
+            seen += counts[k];
+            double fraction = static_cast<double>(seen) / static_cast<double>(total);
+            if (fraction < next && seen < total) continue;
+            // Five lines per halving of the remaining tail
+            next = 1 - (1 - fraction) * std::pow(0.5, 0.2);
+            double inverse = fraction < 1 ? 1 / (1 - fraction) : 0;
+            std::snprintf(line, sizeof(line), "%12.3f %14.12f %10llu %14.2f\n",
+                          static_cast<double>(std::min(highestOf(k), maxValue)) / unit, fraction,
+                          static_cast<unsigned long long>(seen), inverse);
+            out << line;
+        }
+        std::snprintf(line, sizeof(line), "#[Mean    = %12.3f, Max     = %12.3f]\n#[Total count    = %12llu]\n",
+                      getMean() / unit, static_cast<double>(maxValue) / unit, static_cast<unsigned long long>(total));
+        out << line;
+    }
+};
+
+// -------------------
+// Bots
+// -------------------
+enum class BotPolicy { Random, Memory };
+
+struct LoadOptions {
+    std::string address;
+    int threads = 2;
+    double rate = 0;  // games per second over all threads, 0: closed loop
+    int tables = 256; // closed loop: tables kept busy; open loop: at most this many at once
+    double duration = 10;
+    int mode = 3;     // 0-2 as in WireCreate, 3: each table picks one
+    int seats = 4;
+    BotPolicy bot = BotPolicy::Memory;
+    uint64_t seed = 1;
+    std::string histogram;
+};
+
+struct Bot {
+    int fd = -1;
+    int table = -1; // index in the thread's tables, -1 while idle
+    int seat = 0;
+    uint32_t seen = 0; // deltas of its table it has read
+    uint64_t sentNs = 0;
+    bool moving = false; // a pick or target is in flight
+    uint8_t in[kWireFrameSize * 64];
+    size_t inLength = 0;
+};
+
+struct LoadTable {
+    bool open = false;
+    uint32_t id = 0;
+    int mode = 0;
+    int round = 0;
+    std::vector<int> bots; // in joining order
+    int overs = 0;
+    uint32_t applied = 0;  // deltas applied to the fields below
+    uint32_t faceUp = 0;
+    uint32_t blocked = 0;
+    uint32_t untried = 0;  // face-down cells this turn has not been refused
+    uint8_t cards[Geometry::kCells]; // what the table has seen at each position, kWireNone if unknown
+    int current = -1;      // card the next pick must match
+    int picked = -1;       // position of the last pick
+};
+
+struct ThreadResult {
+    HdrHistogram rtt;
+    uint64_t games = 0;
+    uint64_t moves = 0;
+    uint64_t rejected = 0;
+    uint64_t aborted = 0;
+    uint64_t stalls = 0;
+    uint64_t connections = 0;
+    uint64_t backlogMax = 0;
+};
+
+class LoadThread {
+private:
+    const LoadOptions& options;
+    const std::atomic<bool>& stopping;
+    ThreadResult& result;
+    int epollFd;
+    std::vector<Bot> bots;
+    std::vector<int> idleBots;
+    std::vector<LoadTable> tables;
+    std::vector<int> freeTables;
+    int openTables;
+    uint64_t rng;
+
+    uint64_t next() {
+        rng ^= rng << 13;
+        rng ^= rng >> 7;
+        rng ^= rng << 17;
+        return rng;
+    }
+    int randomCell(uint32_t mask) {
+        int count = __builtin_popcount(mask);
+        if (count == 0) return -1;
+        int k = static_cast<int>(next() % static_cast<uint64_t>(count));
+        for (; k > 0; --k) mask &= mask - 1;
+        return __builtin_ctz(mask);
+    }
+
+    int connectBot();
+    void sendFrame(Bot& bot, const uint8_t* frame);
+    bool startTable();
+    void finishTable(int index, bool aborted);
+    void handle(int botIndex, const uint8_t* frame);
+    void applyDelta(LoadTable& table, const WireDelta& delta);
+    void pick(Bot& bot, LoadTable& table);
+    void target(Bot& bot, LoadTable& table);
+
+public:
+    LoadThread(const LoadOptions& options, const std::atomic<bool>& stopping, ThreadResult& result, int index)
+        : options(options), stopping(stopping), result(result), epollFd(::epoll_create1(EPOLL_CLOEXEC)),
+          openTables(0), rng(0x9E3779B97F4A7C15ull * (options.seed + static_cast<uint64_t>(index) + 1)) {}
+    ~LoadThread() {
+        for (Bot& bot : bots) ::close(bot.fd);
+        ::close(epollFd);
+    }
+
+    void run();
+};
+
+int LoadThread::connectBot() {
+    const std::string& address = options.address;
+    int fd;
+    if (address.compare(0, 5, "unix:") == 0) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strncpy(addr.sun_path, address.c_str() + 5, sizeof(addr.sun_path) - 1);
+        fd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            ::close(fd);
+            fd = -1;
+        }
+    } else {
+        size_t colon = address.rfind(':');
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(std::stoi(address.substr(colon + 1))));
+        ::inet_pton(AF_INET, address.substr(0, colon).c_str(), &addr.sin_addr);
+        fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (fd >= 0 && ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0) {
+            ::close(fd);
+            fd = -1;
+        }
+        int yes = 1;
+        if (fd >= 0) ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+    }
+    if (fd < 0) throw ServerError("Cannot connect to " + address + ": " + std::strerror(errno));
+
+    int index = static_cast<int>(bots.size());
+    bots.emplace_back();
+    bots.back().fd = fd;
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u32 = static_cast<uint32_t>(index);
+    ::epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+    ++result.connections;
+    return index;
+}
+
+void LoadThread::sendFrame(Bot& bot, const uint8_t* frame) {
+    // A bot sends a frame per turn at most, which socket buffers always take
+    if (::send(bot.fd, frame, kWireFrameSize, MSG_NOSIGNAL) != static_cast<ssize_t>(kWireFrameSize))
+        throw ServerError(std::string("load bot send: ") + std::strerror(errno));
+}
+
+// Seats idle bots (connecting more when there are none) at a new table; false at the table limit
+bool LoadThread::startTable() {
+    if (openTables >= (options.tables + options.threads - 1) / options.threads) return false;
+    int index;
+    if (!freeTables.empty()) {
+        index = freeTables.back();
+        freeTables.pop_back();
+    } else {
+        index = static_cast<int>(tables.size());
+        tables.emplace_back();
+    }
+    LoadTable& table = tables[index];
+    table = LoadTable();
+    table.open = true;
+    table.mode = options.mode < 3 ? options.mode : static_cast<int>(next() % 3);
+    for (int seat = 0; seat < options.seats; ++seat) {
+        int b;
+        if (!idleBots.empty()) {
+            b = idleBots.back();
+            idleBots.pop_back();
+        } else {
+            b = connectBot();
+        }
+        Bot& bot = bots[b];
+        bot.table = index;
+        bot.seen = 0;
+        bot.moving = false;
+        table.bots.push_back(b);
+    }
+    ++openTables;
+    uint8_t frame[kWireFrameSize];
+    encode(WireCreate{static_cast<uint8_t>(table.mode), static_cast<uint8_t>(options.seats)}, frame);
+    sendFrame(bots[table.bots[0]], frame);
+    return true;
+}
+
+// The server closed the table: its bots are free for the next one
+void LoadThread::finishTable(int index, bool aborted) {
+    LoadTable& table = tables[index];
+    if (!table.open) return;
+    table.open = false;
+    for (int b : table.bots) {
+        bots[b].table = -1;
+        idleBots.push_back(b);
+    }
+    freeTables.push_back(index);
+    --openTables;
+    if (aborted) ++result.aborted;
+    else ++result.games;
+}
+
+void LoadThread::applyDelta(LoadTable& table, const WireDelta& delta) {
+    ++table.applied;
+    if (delta.position == kWireNone) return; // a forfeit
+    bool faceUp = (delta.flags & kDeltaFaceUp) != 0;
+    if (delta.flags & kDeltaTarget) {
+        int animal = table.picked >= 0 && table.cards[table.picked] != kWireNone ? table.cards[table.picked] / Geometry::kKinds : -1;
+        if ((delta.flags & kDeltaApplied) && animal == static_cast<int>(FaceAnimal::Walrus)) {
+            table.blocked = 1u << delta.position;
+        } else if ((delta.flags & kDeltaApplied) && animal == static_cast<int>(FaceAnimal::Octopus)) {
+            // Swapped with the picked card: only what is face up is known
+            table.cards[table.picked] = kWireNone;
+            table.cards[delta.position] = kWireNone;
+        }
+    } else {
+        table.blocked = 0; // a block lasts one valid selection
+        table.picked = delta.position;
+        table.current = delta.card;
+    }
+    if (faceUp) table.cards[delta.position] = delta.card;
+    table.faceUp = delta.faceUpMask;
+}
+
+// Random: any face-down card. Memory: a card seen earlier that matches the
+// current one if there is one, else one never seen, so known mismatches are avoided.
+void LoadThread::pick(Bot& bot, LoadTable& table) {
+    uint32_t open = table.untried & ~table.faceUp & ~table.blocked & kCells;
+    int position = -1;
+    if (options.bot == BotPolicy::Memory) {
+        uint32_t matching = 0, unknown = 0;
+        for (uint32_t mask = open; mask; mask &= mask - 1) {
+            int pos = __builtin_ctz(mask);
+            if (table.cards[pos] == kWireNone) unknown |= 1u << pos;
+            else if (table.current < 0 || Rules::idsMatch(table.current, table.cards[pos])) matching |= 1u << pos;
+        }
+        position = randomCell(matching);
+        if (position < 0) position = randomCell(unknown);
+    }
+    if (position < 0) position = randomCell(open);
+    if (position < 0) {
+        // Walrus blocked the last face-down card: the server's turn timeout plays for the seat
+        ++result.stalls;
+        return;
+    }
+    uint8_t frame[kWireFrameSize];
+    encode(WireMove{false, static_cast<uint8_t>(bot.seat), static_cast<uint8_t>(position)}, frame);
+    table.untried &= ~(1u << position);
+    bot.sentNs = nowNs();
+    bot.moving = true;
+    sendFrame(bot, frame);
+}
+
+// The picked card's power decides: Octopus swaps with a neighbour, Penguin
+// turns another face-up card down, Walrus blocks a face-down card
+void LoadThread::target(Bot& bot, LoadTable& table) {
+    int animal = table.cards[table.picked] != kWireNone ? table.cards[table.picked] / Geometry::kKinds : -1;
+    uint32_t choices;
+    if (animal == static_cast<int>(FaceAnimal::Octopus)) {
+        int row = Geometry::rowOf(table.picked), col = Geometry::colOf(table.picked);
+        choices = 0;
+        if (row > 0) choices |= 1u << (table.picked - Geometry::kCols);
+        if (row < Geometry::kRows - 1) choices |= 1u << (table.picked + Geometry::kCols);
+        if (col > 0) choices |= 1u << (table.picked - 1);
+        if (col < Geometry::kCols - 1) choices |= 1u << (table.picked + 1);
+    } else if (animal == static_cast<int>(FaceAnimal::Penguin)) {
+        choices = table.faceUp & ~(1u << table.picked);
+    } else {
+        choices = ~table.faceUp;
+    }
+    int position = randomCell(choices & kCells);
+    if (position < 0) position = randomCell(kCells);
+    uint8_t frame[kWireFrameSize];
+    encode(WireMove{true, static_cast<uint8_t>(bot.seat), static_cast<uint8_t>(position)}, frame);
+    bot.sentNs = nowNs();
+    bot.moving = true;
+    sendFrame(bot, frame);
+}
+
+void LoadThread::handle(int botIndex, const uint8_t* frame) {
+    Bot& bot = bots[botIndex];
+    if (bot.table < 0) return; // left over from an abandoned table
+    int index = bot.table;
+    LoadTable& table = tables[index];
+    switch (wireType(frame)) {
+        case WireType::TableId: {
+            WireTableId id;
+            decode(frame, id);
+            table.id = id.table;
+            for (int seat = 0; seat < options.seats; ++seat) {
+                WireJoin join{};
+                join.table = table.id;
+                join.name[0] = 'b';
+                join.name[1] = static_cast<char>('0' + seat);
+                uint8_t out[kWireFrameSize];
+                encode(join, out);
+                sendFrame(bots[table.bots[seat]], out);
+            }
+            return;
+        }
+        case WireType::Seat: {
+            // Joins reach a sharded server in any order: the seat is what it says
+            WireSeat seat;
+            decode(frame, seat);
+            bot.seat = seat.seat;
+            return;
+        }
+        case WireType::Sight: {
+            WireSight sight;
+            decode(frame, sight);
+            if (sight.round < table.round) return; // read late: the table is past that round
+            if (sight.round > table.round) {
+                // A new round: new board, the turn starts over
+                table.round = sight.round;
+                table.faceUp = 0;
+                table.blocked = 0;
+                table.current = -1;
+                table.picked = -1;
+                std::memset(table.cards, kWireNone, sizeof(table.cards));
+            }
+            for (int k = 0; k < kWireSightCards && sight.positions[k] != kWireNone; ++k) {
+                table.cards[sight.positions[k]] = sight.cards[k];
+            }
+            if (sight.turn == bot.seat) {
+                table.untried = kCells;
+                pick(bot, table);
+            }
+            return;
+        }
+        case WireType::Delta: {
+            WireDelta delta;
+            decode(frame, delta);
+            // Every seat gets the delta; the first to read it brings the table up to date
+            if (bot.seen++ == table.applied) applyDelta(table, delta);
+            if (delta.seat == bot.seat && bot.moving) {
+                bot.moving = false;
+                ++result.moves;
+                result.rtt.record(nowNs() - bot.sentNs);
+            }
+            if (delta.flags & (kDeltaRoundOver | kDeltaGameOver)) return;
+            if (delta.turn != bot.seat) return;
+            if (delta.flags & kDeltaAwaitingTarget) {
+                target(bot, table);
+            } else {
+                table.untried = kCells;
+                pick(bot, table);
+            }
+            return;
+        }
+        case WireType::Over:
+            if (++table.overs == options.seats) finishTable(index, false);
+            return;
+        case WireType::Reject: {
+            WireReject reject;
+            decode(frame, reject);
+            if (reject.error == WireError::Closed) {
+                finishTable(index, true);
+                return;
+            }
+            ++result.rejected;
+            bot.moving = false;
+            // Blocked or face up after all: try another card
+            if (reject.error == WireError::Blocked || reject.error == WireError::FaceUp) pick(bot, table);
+            return;
+        }
+        default:
+            return; // Start
+    }
+}
+
+void LoadThread::run() {
+    double perThread = options.rate / options.threads;
+    uint64_t nextArrival = nowNs();
+    uint64_t backlog = 0;
+    if (perThread <= 0) {
+        int count = (options.tables + options.threads - 1) / options.threads;
+        for (int t = 0; t < count; ++t) startTable();
+    }
+
+    epoll_event events[256];
+    while (!stopping) {
+        int timeoutMs = 100;
+        if (perThread > 0) {
+            // Exponential gaps between arrivals; those over the table limit wait in the backlog
+            uint64_t now = nowNs();
+            while (nextArrival <= now) {
+                ++backlog;
+                double u = static_cast<double>((next() >> 11) + 1) / 9007199254740993.0;
+                nextArrival += static_cast<uint64_t>(-std::log(u) / perThread * 1e9);
+            }
+            while (backlog > 0 && startTable()) --backlog;
+            result.backlogMax = std::max(result.backlogMax, backlog);
+            timeoutMs = static_cast<int>(std::min<uint64_t>((nextArrival - now) / 1000000, 100));
+        }
+        int n = ::epoll_wait(epollFd, events, 256, timeoutMs);
+        if (n < 0 && errno != EINTR) throw ServerError(std::string("epoll_wait: ") + std::strerror(errno));
+        for (int e = 0; e < n; ++e) {
+            int b = static_cast<int>(events[e].data.u32);
+            Bot& bot = bots[b];
+            ssize_t got = ::recv(bot.fd, bot.in + bot.inLength, sizeof(bot.in) - bot.inLength, MSG_DONTWAIT);
+            if (got == 0 || (got < 0 && errno != EAGAIN && errno != EINTR))
+                throw ServerError("load bot lost its connection");
+            if (got < 0) continue;
+            bot.inLength += static_cast<size_t>(got);
+            size_t used = 0;
+            for (; bot.inLength - used >= kWireFrameSize; used += kWireFrameSize) handle(b, bot.in + used);
+            bot.inLength -= used;
+            std::memmove(bot.in, bot.in + used, bot.inLength);
+        }
+        if (perThread <= 0) {
+            while (startTable()) {}
+        }
+    }
+}
+
+// -------------------
+// Main
+// -------------------
+static bool parseArgs(int argc, char* argv[], LoadOptions& options) {
+    static const char* const kModes[] = {"base", "expert_display", "expert_rules", "mixed"};
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--server" && hasValue) options.address = argv[++i];
+            else if (arg == "--threads" && hasValue) options.threads = std::stoi(argv[++i]);
+            else if (arg == "--rate" && hasValue) options.rate = std::stod(argv[++i]);
+            else if (arg == "--tables" && hasValue) options.tables = std::stoi(argv[++i]);
+            else if (arg == "--duration" && hasValue) options.duration = std::stod(argv[++i]);
+            else if (arg == "--seats" && hasValue) options.seats = std::stoi(argv[++i]);
+            else if (arg == "--seed" && hasValue) options.seed = std::stoull(argv[++i]);
+            else if (arg == "--histogram" && hasValue) options.histogram = argv[++i];
+            else if (arg == "--mode" && hasValue) {
+                std::string mode = argv[++i];
+                options.mode = -1;
+                for (int m = 0; m < 4; ++m) {
+                    if (mode == kModes[m]) options.mode = m;
+                }
+            } else if (arg == "--bot" && hasValue) {
+                std::string bot = argv[++i];
+                if (bot != "random" && bot != "memory") return false;
+                options.bot = bot == "random" ? BotPolicy::Random : BotPolicy::Memory;
+            } else {
+                return false;
+            }
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    return !options.address.empty() && options.threads > 0 && options.rate >= 0 && options.tables > 0 &&
+           options.duration > 0 && options.mode >= 0 && options.seats >= 2 && options.seats <= kWireMaxSeats;
+}
+
+int main(int argc, char* argv[]) {
+    LoadOptions options;
+    if (!parseArgs(argc, argv, options)) {
+        std::cerr << "Usage: load_gen --server unix:PATH|HOST:PORT [--threads N] [--rate GAMES_PER_S] [--tables N]"
+                  << " [--duration S] [--mode base|expert_display|expert_rules|mixed] [--seats N]"
+                  << " [--bot random|memory] [--seed N] [--histogram FILE]\n";
+        return 1;
+    }
+    // Every seat is a connection
+    rlimit files{};
+    if (::getrlimit(RLIMIT_NOFILE, &files) == 0) {
+        files.rlim_cur = files.rlim_max;
+        ::setrlimit(RLIMIT_NOFILE, &files);
+    }
+
+    std::atomic<bool> stopping(false);
+    std::vector<ThreadResult> results(options.threads);
+    std::vector<std::string> failures(options.threads);
+    std::vector<std::thread> threads;
+    auto start = Clock::now();
+    for (int t = 0; t < options.threads; ++t) {
+        threads.emplace_back([&, t] {
+            try {
+                LoadThread(options, stopping, results[t], t).run();
+            } catch (const std::exception& error) {
+                failures[t] = error.what();
+            }
+        });
+    }
+    std::this_thread::sleep_for(std::chrono::duration<double>(options.duration));
+    stopping = true;
+    for (std::thread& thread : threads) thread.join();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    for (const std::string& failure : failures) {
+        if (failure.empty()) continue;
+        std::cerr << "load_gen: " << failure << "\n";
+        return 1;
+    }
+
+    ThreadResult total;
+    for (const ThreadResult& r : results) {
+        total.rtt.add(r.rtt);
+        total.games += r.games;
+        total.moves += r.moves;
+        total.rejected += r.rejected;
+        total.aborted += r.aborted;
+        total.stalls += r.stalls;
+        total.connections += r.connections;
+        total.backlogMax += r.backlogMax;
+    }
+    static const char* const kModes[] = {"base", "expert_display", "expert_rules", "mixed"};
+    auto us = [&](double fraction) { return static_cast<double>(total.rtt.valueAt(fraction)) / 1000; };
+    std::cout << "{\"name\":\"load\",\"threads\":" << options.threads << ",\"mode\":\"" << kModes[options.mode]
+              << "\",\"seats\":" << options.seats << ",\"rate\":" << options.rate << ",\"tables\":" << options.tables
+              << ",\"seconds\":" << seconds << ",\"connections\":" << total.connections
+              << ",\"games\":" << total.games << ",\"games_per_s\":" << total.games / seconds
+              << ",\"moves\":" << total.moves << ",\"moves_per_s\":" << total.moves / seconds
+              << ",\"rejected\":" << total.rejected << ",\"aborted\":" << total.aborted << ",\"stalls\":" << total.stalls
+              << ",\"backlog_max\":" << total.backlogMax << ",\"rtt_us\":{\"p50\":" << us(0.50)
+              << ",\"p90\":" << us(0.90) << ",\"p99\":" << us(0.99) << ",\"p999\":" << us(0.999)
+              << ",\"p9999\":" << us(0.9999) << ",\"max\":" << static_cast<double>(total.rtt.getMax()) / 1000
+              << ",\"mean\":" << total.rtt.getMean() / 1000 << "}}\n";
+
+    if (!options.histogram.empty()) {
+        std::ofstream out(options.histogram);
+        total.rtt.writeDistribution(out, 1000);
+        if (!out) {
+            std::cerr << "load_gen: cannot write " << options.histogram << "\n";
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,264 @@
+// Loopback load test of the game server: one server thread per I/O backend and
+// a driver thread playing base games with binary clients (Wire.h) over TCP.
+// Latency is measured from a pick to the mover's own Delta. Prints one JSON
+// object per backend (JSON Lines):
+//   {"name":"server/uring","tables":512,"games":4096,"moves":98304,"moves_per_s":412000,"p50_us":31.2,"p99_us":88.5}
+//
+// Usage: server_load [--io epoll|uring|both] [--tables N] [--games N] [--port P]
+// Build with every source except src/main.cpp, e.g.
+//   g++ -std=c++17 -O2 -Iinclude bench/server_load.cpp src/[!m]*.cpp -o server_load -pthread
+
+#include "Exceptions.h"
+#include "GameServer.h"
+#include "Wire.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+using Clock = std::chrono::steady_clock;
+
+static const int kSeats = 2;
+static const int kHole = Board::Geometry::kFirstHole;
+
+struct LoadOptions {
+    std::string io = "both";
+    int tables = 512;
+    int games = 8; // per table, played one after the other
+    int port = 7311;
+};
+
+struct LoadClient {
+    int fd = -1;
+    int table = 0;
+    int seat = 0; // seat index inside its table, also the seat the server gives it
+    uint8_t in[kWireFrameSize * 64];
+    size_t inLength = 0;
+    Clock::time_point picked;
+};
+
+struct LoadTable {
+    uint32_t id = 0;
+    int gamesLeft = 0;
+    int joined = 0;
+    uint32_t faceUp = 0;
+    uint64_t rng = 0;
+};
+
+struct LoadResult {
+    uint64_t games = 0;
+    uint64_t moves = 0;
+    double seconds = 0;
+    std::vector<float> latenciesUs;
+};
+
+static void sendFrame(LoadClient& client, const uint8_t* frame) {
+    // Loopback buffers never fill at this rate; a short write is a bug in the test
+    if (::send(client.fd, frame, kWireFrameSize, MSG_NOSIGNAL) != static_cast<ssize_t>(kWireFrameSize))
+        throw ServerError(std::string("load client send: ") + std::strerror(errno));
+}
+
+static void create(LoadClient& client) {
+    uint8_t frame[kWireFrameSize];
+    encode(WireCreate{0, kSeats}, frame);
+    sendFrame(client, frame);
+}
+
+// A random face-down card, the way a bot without memory plays
+static void pick(LoadClient& client, LoadTable& table) {
+    int position;
+    do {
+        table.rng ^= table.rng << 13;
+        table.rng ^= table.rng >> 7;
+        table.rng ^= table.rng << 17;
+        position = static_cast<int>(table.rng % Board::Geometry::kCells);
+    } while (position == kHole || ((table.faceUp >> position) & 1));
+    uint8_t frame[kWireFrameSize];
+    encode(WireMove{false, static_cast<uint8_t>(client.seat), static_cast<uint8_t>(position)}, frame);
+    client.picked = Clock::now();
+    sendFrame(client, frame);
+}
+
+static LoadResult drive(const LoadOptions& options, int port) {
+    int epollFd = ::epoll_create1(EPOLL_CLOEXEC);
+    std::vector<LoadTable> tables(options.tables);
+    std::vector<LoadClient> clients(static_cast<size_t>(options.tables) * kSeats);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    for (size_t k = 0; k < clients.size(); ++k) {
+        LoadClient& client = clients[k];
+        client.table = static_cast<int>(k / kSeats);
+        client.seat = static_cast<int>(k % kSeats);
+        client.fd = ::socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+        if (client.fd < 0 || ::connect(client.fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+            throw ServerError(std::string("load client connect: ") + std::strerror(errno));
+        int yes = 1;
+        ::setsockopt(client.fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes));
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.u64 = k;
+        ::epoll_ctl(epollFd, EPOLL_CTL_ADD, client.fd, &event);
+    }
+
+    LoadResult result;
+    result.latenciesUs.reserve(static_cast<size_t>(options.tables) * options.games * 24);
+    auto start = Clock::now();
+    for (int t = 0; t < options.tables; ++t) {
+        tables[t].gamesLeft = options.games;
+        tables[t].rng = 0x9E3779B97F4A7C15ull * (t + 1);
+        create(clients[static_cast<size_t>(t) * kSeats]);
+    }
+
+    int running = options.tables;
+    epoll_event events[256];
+    while (running > 0) {
+        int n = ::epoll_wait(epollFd, events, 256, 5000);
+        if (n == 0) throw ServerError("load test stalled");
+        for (int e = 0; e < n; ++e) {
+            LoadClient& client = clients[events[e].data.u64];
+            LoadTable& table = tables[client.table];
+            ssize_t got = ::recv(client.fd, client.in + client.inLength, sizeof(client.in) - client.inLength, 0);
+            if (got <= 0) throw ServerError("load client lost its connection");
+            client.inLength += static_cast<size_t>(got);
+
+            size_t used = 0;
+            for (; client.inLength - used >= kWireFrameSize; used += kWireFrameSize) {
+                const uint8_t* frame = client.in + used;
+                LoadClient* seats = &clients[static_cast<size_t>(client.table) * kSeats];
+                WireTableId id;
+                WireSight sight;
+                WireDelta delta;
+                switch (wireType(frame)) {
+                case WireType::TableId:
+                    decode(frame, id);
+                    table.id = id.table;
+                    table.joined = 0;
+                    for (int s = 0; s < kSeats; ++s) {
+                        uint8_t join[kWireFrameSize];
+                        WireJoin message{};
+                        message.table = table.id;
+                        message.name[0] = static_cast<char>('A' + s);
+                        encode(message, join);
+                        sendFrame(seats[s], join);
+                    }
+                    break;
+                case WireType::Sight:
+                    decode(frame, sight);
+                    table.faceUp = 0;
+                    if (sight.turn == client.seat) pick(client, table);
+                    break;
+                case WireType::Delta:
+                    decode(frame, delta);
+                    if (delta.seat == client.seat) {
+                        ++result.moves;
+                        result.latenciesUs.push_back(std::chrono::duration<float, std::micro>(Clock::now() - client.picked).count());
+                    }
+                    table.faceUp = delta.faceUpMask;
+                    if (!(delta.flags & kDeltaRoundOver) && delta.turn == client.seat) pick(client, table);
+                    break;
+                case WireType::Over:
+                    // The table is gone once every seat has its Over
+                    if (client.seat != kSeats - 1) break;
+                    ++result.games;
+                    if (--table.gamesLeft > 0) create(seats[0]);
+                    else --running;
+                    break;
+                case WireType::Reject:
+                    throw ServerError("load client move rejected");
+                default:
+                    break; // Seat, Start
+                }
+            }
+            client.inLength -= used;
+            std::memmove(client.in, client.in + used, client.inLength);
+        }
+    }
+    result.seconds = std::chrono::duration<double>(Clock::now() - start).count();
+
+    for (LoadClient& client : clients) ::close(client.fd);
+    ::close(epollFd);
+    return result;
+}
+
+static void run(const LoadOptions& options, const std::string& io, int port) {
+    ServerOptions serverOptions;
+    serverOptions.address = "127.0.0.1:" + std::to_string(port);
+    serverOptions.io = io;
+
+    // The server lives in its own thread, as in `game --server`
+    std::atomic<int> state(0); // 0 starting, 1 listening, -1 failed
+    std::atomic<bool> done(false);
+    std::string failure;
+    std::thread serverThread([&] {
+        try {
+            GameServer server(serverOptions);
+            state = 1;
+            while (!done) server.poll(10);
+        } catch (const std::exception& error) {
+            failure = error.what();
+            state = -1;
+        }
+    });
+    while (state == 0) std::this_thread::yield();
+
+    LoadResult result;
+    if (state == 1) {
+        try {
+            result = drive(options, port);
+        } catch (const std::exception& error) {
+            failure = error.what();
+        }
+    }
+    done = true;
+    serverThread.join();
+    if (!failure.empty()) {
+        std::cerr << "server/" << io << ": " << failure << "\n";
+        return;
+    }
+
+    std::vector<float>& latencies = result.latenciesUs;
+    std::sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+        return latencies.empty() ? 0.0 : latencies[static_cast<size_t>(p * (latencies.size() - 1))];
+    };
+    std::cout << "{\"name\":\"server/" << io << "\",\"tables\":" << options.tables << ",\"games\":" << result.games
+              << ",\"moves\":" << result.moves << ",\"moves_per_s\":" << result.moves / result.seconds
+              << ",\"p50_us\":" << percentile(0.50) << ",\"p99_us\":" << percentile(0.99) << "}\n";
+}
+
+int main(int argc, char* argv[]) {
+    LoadOptions options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--io" && hasValue) options.io = argv[++i];
+        else if (arg == "--tables" && hasValue) options.tables = std::stoi(argv[++i]);
+        else if (arg == "--games" && hasValue) options.games = std::stoi(argv[++i]);
+        else if (arg == "--port" && hasValue) options.port = std::stoi(argv[++i]);
+        else {
+            std::cerr << "Usage: server_load [--io epoll|uring|both] [--tables N] [--games N] [--port P]\n";
+            return 1;
+        }
+    }
+
+    // Each backend gets its own port, so the first run's TIME_WAIT sockets stay out of the way
+    int port = options.port;
+    for (const char* io : {"epoll", "uring"}) {
+        if (options.io == io || options.io == "both") run(options, io, port++);
+    }
+    return 0;
+}
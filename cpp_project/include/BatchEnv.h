@@ -0,0 +1,71 @@
+#ifndef BATCHENV_H
+#define BATCHENV_H
+
+#include "Geometry.h"
+#include <cstdint>
+#include <vector>
+
+// Many independent base games stepped in lockstep, for training bots.
+// State is kept as structure-of-arrays (one entry per game) and step() runs
+// branch-free passes over them. The rules are those of GameEngine<BasePolicy>:
+// a reveal must share the animal or background of the previous card
+// (Rules::idsMatch), a mismatch eliminates the seat, the last active seat
+// (or the first one, once every card is up) wins the next rubis, and a game
+// ends after Rules::kRounds rounds. Positions are StandardGeometry indexes.
+// memoarr_env.h exposes this class as a C ABI.
+class BatchEnv {
+public:
+    static const int kCells = StandardGeometry::kCells;
+    static const int kRubis = 7;
+    static const uint8_t kNone = 0xFF;
+
+private:
+    int nGames;
+    int nSeats;
+    std::vector<uint8_t> layout;  // nGames * kCells card ids, kNone in the hole
+    std::vector<uint32_t> faceUp; // face-up position mask
+    std::vector<uint8_t> current; // last card revealed this round, kNone at round start
+    std::vector<uint8_t> active;  // active seat mask
+    std::vector<uint8_t> turn;    // seat to move
+    std::vector<uint8_t> round;   // 1..kRounds
+    std::vector<uint8_t> rubisNext;
+    std::vector<uint8_t> rubis;   // nGames * kRubis values in draw order
+    std::vector<uint8_t> rubies;  // nGames * nSeats rubies won so far
+    std::vector<uint8_t> done;
+    std::vector<uint64_t> rng;
+    std::vector<uint8_t> roundOver; // step() scratch
+
+    void resetGame(int g);
+    void startRound(int g);
+
+public:
+    // Throws std::invalid_argument unless nGames > 0 and 2 <= nSeats <= Game::kMaxSeats
+    BatchEnv(int nGames, int nSeats, uint64_t seed);
+
+    int size() const { return nGames; }
+    int seats() const { return nSeats; }
+
+    void reset();      // new deal for every game
+    void resetDone();  // new deal for finished games only
+    // Fixed deals, e.g. to replay a GameSnapshot; the game restarts at round 1
+    void setDeal(int g, const uint8_t* layoutIds, const uint8_t* rubisValues);
+
+    // Reveals actions[g] for the seat to move in every unfinished game. Illegal
+    // picks (hole, face up, out of range) leave that game unchanged.
+    // rewards receives nGames * nSeats rubis won in this step, dones 1 per finished game.
+    void step(const uint8_t* actions, float* rewards, uint8_t* dones);
+
+    // nGames * kCells card ids the seat to move can see: face-up cards and its
+    // own sight cards; kNone elsewhere
+    void observe(uint8_t* cards) const;
+
+    const uint32_t* faceUpMasks() const { return faceUp.data(); }
+    const uint8_t* currentCards() const { return current.data(); }
+    const uint8_t* activeMasks() const { return active.data(); }
+    const uint8_t* turns() const { return turn.data(); }
+    const uint8_t* rounds() const { return round.data(); }
+    const uint8_t* rubiesWon() const { return rubies.data(); }
+    const uint8_t* doneFlags() const { return done.data(); }
+};
+
+#endif
@@ -5,22 +5,31 @@
 #include "CardDeck.h"
 #include "Enums.h"
 #include "Exceptions.h"
+#include "Geometry.h"
+#include <array>
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <iostream>
 
-class Board {
+// Board of any BoardGeometry; Board is the printed 5x5 game.
+// Member definitions live in Board.cpp, instantiated for the geometries in Geometry.h.
+template <typename G>
+class BasicBoard {
+public:
+    using Geometry = G;
+    using Mask = typename G::Mask;
+
 private:
-    std::vector<std::vector<Card*>> grid; // 5x5, but center is nullptr
-    std::vector<std::vector<bool>> faceUp; // 5x5, true if face up
+    std::array<Card*, G::kCells> grid; // row * kCols + col, nullptr in holes
+    Mask faceUp;                       // same bit per position, set if face up (see Sight.h)
 
-    int letterToIndex(Letter l) const;
-    int numberToIndex(Number n) const;
-    bool isValidPosition(Letter l, Number n) const;
+    bool isValidPosition(Letter l, Number n) const { return G::isCell(static_cast<int>(l), static_cast<int>(n)); }
+    void print(std::ostream& os) const;
 
 public:
-    Board(CardDeck& deck);
-    ~Board();
+    BasicBoard(CardDeck& deck);
+    BasicBoard(); // empty board, filled with setCard (snapshot restore)
 
     bool isFaceUp(const Letter& l, const Number& n) const;
     bool turnFaceUp(const Letter& l, const Number& n);
@@ -29,10 +38,21 @@ public:
     void setCard(const Letter& l, const Number& n, Card* card);
     void allFacesDown();
 
+    // Mask variants flip several cards at once, e.g. a side's sight cards
+    static constexpr Mask kCellMask = G::kCellMask; // every position but the holes
+    Mask getFaceUpMask() const { return faceUp; }
+    void turnFaceUp(Mask mask) { faceUp |= mask & kCellMask; }
+    void turnFaceDown(Mask mask) { faceUp &= ~mask; }
+
     // Added for Octopus ability
     void swapCards(const Letter& l1, const Number& n1, const Letter& l2, const Number& n2);
 
-    friend std::ostream& operator<<(std::ostream& os, const Board& board);
+    friend std::ostream& operator<<(std::ostream& os, const BasicBoard& board) {
+        board.print(os);
+        return os;
+    }
 };
 
-#endif
\ No newline at end of file
+using Board = BasicBoard<StandardGeometry>;
+
+#endif
@@ -8,7 +8,8 @@ class Card {
 private:
     FaceAnimal animal;
     FaceBackground background;
-    Card(FaceAnimal animal, FaceBackground background); // private constructor
+    int id;
+    Card(FaceAnimal animal, FaceBackground background, int kinds); // private constructor
     friend class CardDeck;
 
 public:
@@ -16,6 +17,8 @@ public:
     int getNRows() const { return 3; }
     operator FaceAnimal() const;
     operator FaceBackground() const;
+    // animal * kinds + background for the deck's kinds: animal*5+background in the printed game
+    int getId() const { return id; }
 };
 
 #endif
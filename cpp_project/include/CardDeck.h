@@ -3,14 +3,20 @@
 
 #include "DeckFactory.h"
 #include "Card.h"
+#include "Geometry.h"
 
 class CardDeck : public DeckFactory<Card> {
 private:
-    static CardDeck* instance;
-    CardDeck();
+    static thread_local CardDeck* instances[kFaceKinds + 1]; // one deck per thread (server shards) and kinds
+    int kinds;
+    Card* byId[kFaceKinds * kFaceKinds]; // the deck order changes, the cards do not
+    explicit CardDeck(int kinds);
 
 public:
-    static CardDeck& make_CardDeck();
+    // kinds x kinds cards, Geometry::kKinds of the board they deal (5 for the printed game)
+    static CardDeck& make_CardDeck(int kinds = StandardGeometry::kKinds);
+    int getKinds() const { return kinds; }
+    Card* getCard(int id) const; // lookup by Card::getId()
 };
 
 #endif
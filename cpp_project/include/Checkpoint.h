@@ -0,0 +1,95 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include "Snapshot.h"
+#include "MoveLog.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+
+// File layout: 64-byte header | one entry per local table index below count
+struct CheckpointHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t shard; // as in LogHeader
+    uint32_t shardCount;
+    uint64_t start; // move log position when the checkpoint began
+    uint64_t count; // entries
+    uint32_t entrySize;
+    uint8_t reserved[20];
+};
+
+// A table slot as the checkpoint saw it. The slot's log records from position
+// on are not in game yet; earlier ones are.
+struct CheckpointEntry {
+    uint64_t position;
+    uint8_t seats; // 0: no table in the slot
+    uint8_t reserved[3];
+    GameSnapshot game;
+};
+
+// Checkpoint of a server shard's tables, written a slice at a time between
+// polls: entries are saved straight into a shared mapping of PATH.tmp, and once
+// all are in, a thread of its own syncs the file, renames it over PATH and copies
+// the move log's tail for its truncation, so play never waits for the disk. Tables move on between slices; each entry's log
+// position tells recovery which of their records are still to be played.
+class CheckpointWriter {
+private:
+    std::string path;
+    int fd;
+    uint8_t* base;
+    size_t length;
+    uint64_t start;
+    uint64_t count;
+    MoveLog* log; // truncated once the checkpoint is durable
+    std::thread syncer;
+    std::atomic<int> status; // 0 writing or syncing, 1 done, -1 failed
+
+    void sync();
+
+public:
+    // Throws ArchiveError
+    CheckpointWriter(const std::string& path, int shard, int shardCount, uint64_t start, uint64_t count);
+    ~CheckpointWriter(); // waits for the sync
+    CheckpointWriter(const CheckpointWriter&) = delete;
+    CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+    uint64_t getStart() const { return start; }
+    uint64_t size() const { return count; }
+    CheckpointEntry& entry(uint64_t index) {
+        return reinterpret_cast<CheckpointEntry*>(base + sizeof(CheckpointHeader))[index];
+    }
+
+    // Every entry is written: publishes the file in the background (once), then
+    // copies what log holds past the checkpoint's start (MoveLog::beginTruncate)
+    void finish(MoveLog& log);
+    // True once the file is in place and durable and the log's copy too, when the
+    // caller is left to call MoveLog::endTruncate; throws ArchiveError if that failed
+    bool isDone() const;
+};
+
+// Read-only view of a checkpoint through mmap
+class Checkpoint {
+private:
+    const uint8_t* base;
+    size_t length;
+    const CheckpointHeader* header;
+
+public:
+    // Throws ArchiveError, also when it was written by another shard or for another number of shards
+    Checkpoint(const std::string& path, int shard, int shardCount);
+    ~Checkpoint();
+    Checkpoint(const Checkpoint&) = delete;
+    Checkpoint& operator=(const Checkpoint&) = delete;
+
+    uint64_t getStart() const { return header->start; }
+    uint64_t size() const { return header->count; }
+    const CheckpointEntry& operator[](uint64_t index) const {
+        return reinterpret_cast<const CheckpointEntry*>(base + sizeof(CheckpointHeader))[index];
+    }
+};
+
+#endif
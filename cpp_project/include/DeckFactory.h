@@ -12,11 +12,18 @@ class DeckFactory {
 protected:
     std::vector<C*> deck;
     size_t currentIndex;
+    std::vector<C*> creationOrder;
+
+    // Per thread, like the deck singletons, so shards shuffle without sharing state
+    static std::mt19937& generator() {
+        static thread_local std::mt19937 g(std::random_device{}());
+        return g;
+    }
 
 public:
     DeckFactory() : currentIndex(0) {
         // Seed random for std::random_shuffle
-        static bool seeded = false;
+        static thread_local bool seeded = false;
         if (!seeded) {
             std::srand(static_cast<unsigned>(std::time(nullptr)));
             seeded = true;
@@ -29,15 +36,27 @@ public:
         }
     }
 
+    // Reseeds the shuffles of this deck type (scripted sessions use a fixed seed)
+    static void seed(unsigned s) {
+        generator().seed(s);
+        std::srand(s);
+    }
+
     void shuffle() {
+        // Always start from the creation order so a seeded shuffle is reproducible.
+        // The first shuffle runs in the derived constructor, right after the deck is filled.
+        if (creationOrder.size() != deck.size()) {
+            creationOrder = deck;
+        } else {
+            deck = creationOrder;
+        }
+
         // PDF explicitly requires std::random_shuffle
         // Note: deprecated in C++14, removed in C++17
         // If using C++17+, may need to use std::shuffle instead
         #if __cplusplus >= 201703L
             // C++17 or later - use std::shuffle
-            std::random_device rd;
-            std::mt19937 g(rd());
-            std::shuffle(deck.begin(), deck.end(), g);
+            std::shuffle(deck.begin(), deck.end(), generator());
         #else
             // C++14 or earlier - use std::random_shuffle as required
             std::random_shuffle(deck.begin(), deck.end());
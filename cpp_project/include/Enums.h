@@ -1,13 +1,20 @@
 #ifndef ENUMS_H
 #define ENUMS_H
 
-enum class FaceAnimal { Crab, Penguin, Octopus, Turtle, Walrus };
-enum class FaceBackground { Red, Green, Purple, Blue, Yellow };
-enum class Side { top, bottom, left, right };
-enum class Letter { A, B, C, D, E };
-enum class Number { One = 0, Two, Three, Four, Five };
+// The printed game uses the first five of each; tournament decks add the rest (see Geometry::kKinds)
+enum class FaceAnimal { Crab, Penguin, Octopus, Turtle, Walrus, Seal, Urchin };
+enum class FaceBackground { Red, Green, Purple, Blue, Yellow, Orange, Cyan };
+const int kFaceKinds = 7; // values of each of FaceAnimal and FaceBackground
+// Seats: one per side, then the corner seats used with five to eight players
+enum class Side { top, bottom, left, right, topLeft, topRight, bottomRight, bottomLeft };
+// Rows and columns; F, G, Six and Seven only exist on the larger geometries
+enum class Letter { A, B, C, D, E, F, G };
+enum class Number { One = 0, Two, Three, Four, Five, Six, Seven };
 
 // Added for Expert Rules flow control
 enum class ExpertEffect { None, PlayAgain, SkipNext };
 
+// Power an animal has under expert rules (same order as ReplayEffect)
+enum class AnimalPower { None, SwapAdjacent, TurnDown, Block, PlayAgain, SkipNext };
+
 #endif
\ No newline at end of file
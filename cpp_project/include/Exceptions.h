@@ -14,4 +14,19 @@ public:
     NoMoreCards(const std::string& msg) : std::runtime_error(msg) {}
 };
 
+class ArchiveError : public std::runtime_error {
+public:
+    ArchiveError(const std::string& msg) : std::runtime_error(msg) {}
+};
+
+class SnapshotError : public std::runtime_error {
+public:
+    SnapshotError(const std::string& msg) : std::runtime_error(msg) {}
+};
+
+class ServerError : public std::runtime_error {
+public:
+    ServerError(const std::string& msg) : std::runtime_error(msg) {}
+};
+
 #endif
@@ -3,13 +3,35 @@
 
 #include "Board.h"
 #include "Player.h"
+#include "Sight.h"
+#include "Snapshot.h"
+#include <array>
+#include <cstdint>
 #include <vector>
 #include <iostream>
 
+// Lowest set bit of every seat mask, -1 for an empty mask
+inline constexpr std::array<int8_t, 256> kLowestSeat = [] {
+    std::array<int8_t, 256> table{};
+    table[0] = -1;
+    for (int mask = 1; mask < 256; ++mask) {
+        int seat = 0;
+        while (!(mask & (1 << seat))) ++seat;
+        table[mask] = static_cast<int8_t>(seat);
+    }
+    return table;
+}();
+
 class Game {
+public:
+    static constexpr int kMaxSeats = 8;
+
 private:
     Board board;
-    std::vector<Player> players;
+    std::vector<Player> players;     // indexed by seat
+    uint8_t activeSeats;             // bit per seat, kept in step with Player::isActive
+    int8_t seatOfSide[kMaxSeats];    // seat sitting on each Side, -1 if empty
+    uint32_t sightMasks[kMaxSeats];  // cards each seat sees before a round
     int round;
     const Card* previousCard;
     const Card* currentCard;
@@ -21,12 +43,20 @@ private:
     Number blockedNumber;
 
     friend class Rules;
+    friend struct GameSnapshot;
+
+    void clearSeats();
 
 public:
     Game(CardDeck& deck, bool expertDisplay = false);
+    Game(const GameSnapshot& snapshot, const CardDeck& cardDeck, RubisDeck& rubisDeck);
     int getRound() const;
+    // Seats are given in order, up to kMaxSeats; the seat's sight defaults to its Side
     void addPlayer(const Player& player);
     Player& getPlayer(Side side);
+    int getSeatCount() const { return static_cast<int>(players.size()); }
+    Player& getSeat(int seat) { return players[seat]; }
+    const Player& getSeat(int seat) const { return players[seat]; }
     const Card* getPreviousCard() const;
     const Card* getCurrentCard() const;
     void setCurrentCard(const Card* card);
@@ -38,6 +68,11 @@ public:
     bool turnFaceDown(const Letter& l, const Number& n); // Added wrapper
     const std::vector<Player>& getPlayers() const;
     void setPlayerActive(Side side, bool active);
+    void setSeatActive(int seat, bool active);
+    uint8_t getActiveSeats() const { return activeSeats; }
+    int getActiveCount() const;
+    // First active seat at or after from (cyclic); -1 if nobody is active
+    int nextActiveSeat(int from) const;
     void addRubisToPlayer(Side side, const Rubis& rubis);
     const Board& getBoard() const { return board; }
     std::vector<Player>& getPlayersMutable() { return players; }
@@ -48,8 +83,12 @@ public:
     void resetBlocked();
     void swapCards(Letter l1, Number n1, Letter l2, Number n2);
     
-    // Start of round peek helper
-    std::vector<std::pair<Letter, Number>> getSightLocations(Side side) const;
+    // Start of round peek helpers
+    const SightLocations& getSightLocations(Side side) const { return sightLocations(side); }
+    uint32_t getSightMask(int seat) const { return sightMasks[seat]; }
+    void setSightMask(int seat, uint32_t mask) { sightMasks[seat] = mask; }
+    void revealSight(int seat) { board.turnFaceUp(sightMasks[seat]); }
+    void hideSight(int seat) { board.turnFaceDown(sightMasks[seat]); }
 
     friend std::ostream& operator<<(std::ostream& os, const Game& game);
 };
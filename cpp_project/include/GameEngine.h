@@ -0,0 +1,74 @@
+#ifndef GAMEENGINE_H
+#define GAMEENGINE_H
+
+#include "Game.h"
+#include "Rules.h"
+#include "RubisDeck.h"
+#include "Replay.h"
+
+enum class PickResult { Hole, Blocked, AlreadyFaceUp, NeedsTarget, Matched, Eliminated };
+
+// Headless turn logic: whose turn it is, picks, expert targets and round awards.
+// Front ends (console, scripts) only translate input into pick()/target() calls.
+// Policy is a RulePolicy; effects it disables are compiled out of the engine.
+// All RulePolicy combinations are instantiated in GameEngine.cpp.
+template <typename Policy>
+class GameEngine {
+private:
+    Game& game;
+    Rules& rules;
+    RubisDeck& rubisDeck;
+
+    int turn;           // index of the player to move
+    bool skipNext;      // Turtle: skip the next active player
+    bool secondTurn;    // Crab: the current player is already playing again
+    int skipped;        // player skipped by the last turn change, -1 if none
+    Letter pickedLetter;
+    Number pickedNumber;
+    bool awaitingTarget;
+    bool targetApplied;
+    ExpertEffect lastEffect;
+    const Rubis* lastAward;
+    Replay* recorder;
+
+    PickResult resolve(uint8_t target);
+    void advance();
+    void record(bool matched, uint8_t target);
+
+public:
+    GameEngine(Game& game, Rules& rules, RubisDeck& rubisDeck);
+
+    void startRound();
+    // Not while a target is pending: it may turn a card back down
+    bool isRoundOver() const { return !awaitingTarget && rules.roundOver(game); }
+    bool isGameOver() const { return rules.gameOver(game); }
+
+    int getTurn() const { return turn; }
+    Player& getCurrentPlayer() { return game.getPlayersMutable()[turn]; }
+    int getSkippedPlayer() const { return skipped; }
+    bool isSecondTurn() const { return secondTurn; }
+    bool isAwaitingTarget() const { return awaitingTarget; }
+    bool wasTargetApplied() const { return targetApplied; }
+    ExpertEffect getLastEffect() const { return lastEffect; }
+
+    // Reveals a card for the current player; invalid picks leave the game unchanged
+    PickResult pick(Letter l, Number n);
+    // Expert target for the card just revealed (only while awaiting a target)
+    PickResult target(Letter l, Number n);
+    // The current player drops out of the round without playing (e.g. out of time)
+    PickResult forfeit();
+
+    // Awards a rubis to the remaining player; returns their index or -1
+    int finishRound();
+    const Rubis* getLastAward() const { return lastAward; }
+
+    // The turn as a GameSnapshot keeps it (turnPlayer to pickedPosition), so that a
+    // game restored mid-round goes on with the same seat and pending effects
+    void saveTurn(GameSnapshot& snapshot) const;
+    void restoreTurn(const GameSnapshot& snapshot);
+
+    // Records every event of the game into replay (nullptr to stop recording)
+    void setRecorder(Replay* replay);
+};
+
+#endif
@@ -0,0 +1,226 @@
+#ifndef GAMESERVER_H
+#define GAMESERVER_H
+
+#include "Checkpoint.h"
+#include "IoBackend.h"
+#include "Matchmaker.h"
+#include "MoveLog.h"
+#include "SpectatorRing.h"
+#include "ShardMesh.h"
+#include "Slab.h"
+#include "Table.h"
+#include "TimerWheel.h"
+#include "Wire.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sys/uio.h>
+
+class CardDeck;
+class RubisDeck;
+
+// Server mode of the console binary:
+//   game --server ADDRESS [--seed N] [--io epoll|uring] [--shards N] [--lobby-timeout S]
+//                [--turn-timeout S] [--on-timeout pick|eliminate] [--sight-time S] [--idle-timeout S]
+//                [--wal PATH] [--checkpoint-interval S]
+// ADDRESS is unix:PATH or HOST:PORT (e.g. 127.0.0.1:7300). Thousands of tables share
+// one event loop (IoBackend.h); sockets never block, so a slow client only delays itself.
+// With --shards N (0: one per core, TCP only) each shard is a GameServer on its own
+// thread and SO_REUSEPORT socket, owning the tables it created: table ids encode the
+// shard, and a client joining another shard's table is handed over to it
+// (ShardedServer.h). Clients may instead queue for a table of some size: the
+// shards share one lock-free Matchmaker, and whichever shard completes a group
+// opens the table and fetches the players from their shards.
+// Tables still waiting for players after S seconds are closed. A seat that
+// does not move within the turn timeout has its first hidden card picked for it
+// (or drops out of the round with --on-timeout eliminate); each round's first
+// turn also gets the sight time to memorize the cards. A table where no client
+// moved for the idle timeout is closed. Deadlines live in a hierarchical TimerWheel.
+// With --wal every deal, join and accepted move goes to a MoveLog (PATH.N for
+// shard N when sharded), synced once per poll before any reply of that poll is
+// sent; a server started on the same log plays it again and reopens its tables
+// with their seats free, which players take back by joining under the same name.
+// Every checkpoint interval the tables are also saved to PATH.ckpt a slice per
+// poll (CheckpointWriter), after which the log drops what the checkpoint holds:
+// recovery loads the checkpoint and plays only the log's tail.
+// Spectators follow a table through its SpectatorRings: what a table publishes
+// is written there once and each spectator takes what is new at its own pace;
+// one whose socket still holds kSpectatorLag unsent bytes is skipped, and one
+// that fell a ring behind gets a fresh board instead of the moves it missed.
+// Bots speak the binary frames of Wire.h; the text protocol below renders the
+// same messages for people and scripts. Each client picks one with its first byte.
+//
+// Line protocol, positions as in the console (A1..E5):
+//   create MODE SEATS  ->  table ID          MODE base|expert_display|expert_rules, 2-8 seats
+//   join ID NAME       ->  seat S            the game starts once every seat is taken
+//   play MODE SEATS NAME  ->  queued, then seat S once enough players queued for the same table
+//   A1                     pick, or the expert target after "turn S target"
+//   watch ID           ->  board MODE SEATS waiting|round R turn S POS=CARD ...  then the table's broadcasts
+// Broadcast to the table:
+//   start MODE NAME...   round R   turn S [target]   skip S   award S VALUE   over R0 R1 ...
+//   reveal S POS CARD matched|eliminated|target      target S POS applied|ignored matched|eliminated
+//   timeout S [eliminated]  (before the move played for S, or S dropped out of the round)
+//   closed               (a seat left before the end, or the lobby timed out)
+// Sent to one seat: sight POS=CARD ... at each round start, error TEXT
+struct ServerOptions {
+    std::string address;
+    unsigned seed;
+    std::string io;   // IoBackend: epoll or uring
+    int shards;       // 0: one per core
+    int lobbyTimeout; // seconds, 0: tables wait forever
+    int turnTimeout;  // seconds, 0: seats may think forever
+    std::string onTimeout; // pick or eliminate
+    int sightTime;    // seconds added to each round's first turn
+    int idleTimeout;  // seconds without a client move before a game is closed, 0: never
+    std::string wal;  // move log path, empty for none
+    int checkpointInterval; // seconds between checkpoints of the move log, 0: never
+
+    ServerOptions()
+        : seed(1), io("epoll"), shards(1), lobbyTimeout(300), turnTimeout(60), onTimeout("pick"), sightTime(0),
+          idleTimeout(600), checkpointInterval(300) {}
+};
+
+class GameServer : private IoEvents {
+public:
+    static const size_t kLineMax = 128;
+    static const uint64_t kCheckpointSlice = 1024; // tables saved per poll
+    static const size_t kSpectatorFrameRing = 4096; // bytes of binary frames kept per watched table
+    static const size_t kSpectatorTextRing = 16384; // and of text lines
+    static const size_t kSpectatorLag = 4096;       // unsent bytes that hold a spectator's next delivery back
+
+private:
+    enum class Protocol : uint8_t { Unknown, Text, Binary };
+    enum class Move : uint8_t { Either, Pick, Target };
+
+    struct Connection {
+        bool open;
+        Protocol protocol;
+        int table;      // -1 until seated
+        int seat;
+        int watching;    // local index of the table it spectates, -1 if none
+        uint64_t cursor; // its position in that table's SpectatorRing of its protocol
+        size_t inLength;
+        char in[kLineMax];
+        int handoffTable; // global id of the table it leaves this shard for, -1 if staying
+        std::string handoffName;
+        bool handoffWatch;
+        std::string handoffInput; // received after the handoff started
+        uint32_t handoffSerial;   // serial of the formed table it goes to, 0 if joined by id
+        uint32_t queueSerial;     // Matchmaker ticket while queued, 0 otherwise
+
+        Connection()
+            : open(false), protocol(Protocol::Unknown), table(-1), seat(-1), watching(-1), cursor(0), inLength(0),
+              handoffTable(-1), handoffWatch(false), handoffSerial(0), queueSerial(0) {}
+    };
+
+    // The spectators of a table and what it published for them
+    struct Audience {
+        SpectatorRing frames;
+        SpectatorRing text;
+        uint64_t lastFrames; // where the latest message starts in each ring
+        uint64_t lastText;
+        std::vector<int> spectators;
+        bool stale; // listed in staleAudiences
+
+        Audience()
+            : frames(kSpectatorFrameRing), text(kSpectatorTextRing), lastFrames(0), lastText(0), stale(false) {}
+    };
+
+    ServerOptions options;
+    ShardMesh* mesh; // nullptr when running alone
+    int shard;
+    int shardCount;
+    CardDeck& cardDeck;
+    RubisDeck& rubisDeck;
+    int listenFd;
+    std::unique_ptr<IoBackend> io;
+    std::atomic<bool> stopping;
+    std::vector<Connection> connections; // indexed by fd
+    Slab<Table> tablePool;
+    std::vector<Table*> tables;          // indexed by local table index, nullptr when free
+    std::vector<int> freeTables;
+    int tableCount;
+    std::vector<uint32_t> tableSerials; // tells apart the tables that used an index
+    uint32_t nextSerial;
+    TimerWheel timers;
+    std::vector<Handoff> stalled; // handoffs whose queue was full, retried every poll
+    std::unique_ptr<Matchmaker> ownMatchmaker; // when running alone
+    Matchmaker* matchmaker;
+    std::unique_ptr<MoveLog> log; // when recording moves
+    std::string logPath;
+    std::unique_ptr<CheckpointWriter> checkpoint; // while one is written
+    uint64_t checkpointCursor; // next table index it saves
+    uint64_t nextCheckpointMs;
+    std::vector<std::unique_ptr<Audience>> audiences; // by local table index, while watched
+    std::vector<int> staleAudiences; // with spectators that have not read everything
+
+    void listen();
+    void recover();
+    void checkpointStep();
+    void onOpen(int fd) override;
+    void onData(int fd, const char* data, size_t size) override;
+    void onClose(int fd) override;
+    void onDetach(int fd, std::string& unsent) override;
+    void onWake() override;
+    bool consume(int fd);
+    void closeClient(int fd);
+
+    // Table ids seen by clients: local index * shardCount + shard
+    int globalId(int index) const { return index * shardCount + shard; }
+    void handOff(int fd, int id, const std::string& name, uint32_t tableSerial);
+    void adopt(Handoff& handoff);
+    void pushHandoff(Handoff& handoff);
+
+    void handleLine(int fd, std::string_view line);
+    void handleFrame(int fd, const uint8_t* frame);
+    int openTable(int mode, int seats);
+    void install(Table* table);
+    void createTable(int fd, int mode, int seats);
+    void joinTable(int fd, int id, const std::string& name, uint32_t tableSerial = 0);
+    void watchTable(int fd, int id);
+    void unwatch(int fd);
+    bool deliver(int fd, Audience& audience, bool closing);
+    void resync(int fd, const Table& table);
+    void flushSpectators();
+    void queue(int fd, int mode, int seats, std::string_view name);
+    void leaveQueue(int fd);
+    void formTable(int mode, const Ticket* group, int seats);
+    void play(int fd, Letter l, Number n, Move move);
+    void timeOut(Table& table);
+    void broadcast(Table& table, const TableUpdate& update);
+    void armTurn(Table& table, bool roundStart);
+    void touch(Table& table);
+    void abandon(Table& table);
+    void closeTable(Table& table);
+
+    void send(int fd, std::string_view bytes);
+    void reject(int fd, WireError error);
+    void publish(const Table& table, std::string_view text, const uint8_t* frames, size_t frameBytes, bool sight);
+
+public:
+    // Binds the listening socket and starts the backend; throws ServerError.
+    // Shards of a ShardedServer pass their mesh and index and must be built on
+    // the thread that polls them (the decks are per thread).
+    explicit GameServer(const ServerOptions& options, ShardMesh* mesh = nullptr, int shard = 0);
+    ~GameServer();
+    GameServer(const GameServer&) = delete;
+    GameServer& operator=(const GameServer&) = delete;
+
+    // Waits up to timeoutMs for socket activity and handles it; returns the events handled.
+    // Polls must come from one thread at a time; stop() may come from any.
+    int poll(int timeoutMs);
+    // Polls until stop() or SIGINT/SIGTERM; returns the exit code
+    int run();
+    void stop() { stopping = true; }
+
+    int getTableCount() const { return tableCount; }
+
+    // Parses command line options; false on unknown or malformed arguments
+    static bool parseArgs(int argc, char* argv[], ServerOptions& options);
+};
+
+#endif
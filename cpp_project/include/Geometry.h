@@ -0,0 +1,67 @@
+#ifndef GEOMETRY_H
+#define GEOMETRY_H
+
+#include "Enums.h"
+#include <cstdint>
+#include <type_traits>
+
+// Compile-time board shape: Rows x Cols positions, with bit (row * Cols + col)
+// of HoleMask set for every position that holds no card. Loops over a geometry
+// have constant bounds, so every board size is fully specialized.
+
+constexpr int countBits(uint64_t mask) {
+    int n = 0;
+    for (; mask; mask &= mask - 1) ++n;
+    return n;
+}
+
+constexpr int lowestBit(uint64_t mask) {
+    int n = 0;
+    while (n < 64 && !((mask >> n) & 1)) ++n;
+    return n;
+}
+
+template <int Rows, int Cols, uint64_t HoleMask>
+struct BoardGeometry {
+    static_assert(Rows > 0 && Cols > 0 && Rows * Cols <= 64, "face-up state must fit in 64 bits");
+
+    static constexpr int kRows = Rows;
+    static constexpr int kCols = Cols;
+    static constexpr int kCells = Rows * Cols;
+    static constexpr int kCards = kCells - countBits(HoleMask);
+    // Animals and backgrounds of the geometry's deck (CardDeck::make_CardDeck(kKinds)):
+    // kKinds x kKinds distinct cards, enough for every position
+    static constexpr int kKinds = Rows > Cols ? Rows : Cols;
+    // Lowest hole position (64 for a board without holes): a pick the engine always refuses
+    static constexpr int kFirstHole = lowestBit(HoleMask);
+    // Text rendering: 3x3 cards separated by one blank row or column
+    static constexpr int kRenderRows = Rows * 4 - 1;
+    static constexpr int kRenderCols = Cols * 4 - 1;
+
+    using Mask = std::conditional_t<(kCells <= 32), uint32_t, uint64_t>;
+    static constexpr Mask kHoleMask = static_cast<Mask>(HoleMask);
+    static constexpr Mask kCellMask = static_cast<Mask>((kCells == 64 ? ~0ull : (1ull << kCells) - 1) & ~HoleMask);
+
+    static constexpr int index(int row, int col) { return row * Cols + col; }
+    static constexpr int rowOf(int index) { return index / Cols; }
+    static constexpr int colOf(int index) { return index % Cols; }
+    static constexpr Mask bit(int row, int col) { return Mask(1) << index(row, col); }
+    static constexpr bool isHole(int row, int col) { return (HoleMask >> index(row, col)) & 1; }
+    static constexpr bool isCell(int row, int col) {
+        return row >= 0 && row < Rows && col >= 0 && col < Cols && !isHole(row, col);
+    }
+
+    static_assert(kKinds * kKinds >= kCards, "not enough distinct cards for the board");
+    static_assert(kKinds <= kFaceKinds, "not enough animals and backgrounds for the board");
+};
+
+// The printed game: 5x5 with the hole at C3
+using StandardGeometry = BoardGeometry<5, 5, 1ull << 12>;
+// Tournament variants: 6x6 without the four centre cells, 7x7 without D4
+using Geometry6x6 = BoardGeometry<6, 6, (1ull << 14) | (1ull << 15) | (1ull << 20) | (1ull << 21)>;
+using Geometry7x7 = BoardGeometry<7, 7, 1ull << 24>;
+
+static_assert(StandardGeometry::kCards == 24 && StandardGeometry::kCellMask == 0x1FFEFFFu, "5x5 board, hole at C3");
+static_assert(Geometry6x6::kCards == 32 && Geometry7x7::kCards == 48, "tournament boards");
+
+#endif
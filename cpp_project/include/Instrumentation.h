@@ -0,0 +1,99 @@
+#ifndef INSTRUMENTATION_H
+#define INSTRUMENTATION_H
+
+#include <atomic>
+#include <cstdint>
+#include <iostream>
+
+// Hot-path instrumentation, compiled in only with -DMEMO_PROFILE.
+// Without it every MEMO_* macro expands to nothing.
+//   MEMO_SCOPE(Probe::Reveal);         cycle timer for the rest of the scope
+//   MEMO_COUNT(Counter::Picks);        per-thread event counter
+//   MEMO_DUMP(std::cerr);              summary of all threads
+
+// Reveal turns the card up; Resolve judges the match once any expert target is in
+enum class Probe {
+    RoundSetup, SightPhase, PickValidation, Reveal, ExpertEffect, Resolve, RubisAward, Render, InputWait, Count
+};
+enum class Counter { Rounds, Picks, RejectedPicks, Eliminations, ExpertTargets, Count };
+
+#ifdef MEMO_PROFILE
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+struct ProbeStats {
+    // Written only by the owning thread; relaxed atomics let the summary read them safely
+    std::atomic<uint64_t> count{0};
+    std::atomic<uint64_t> cycles{0};
+    std::atomic<uint64_t> maxCycles{0};
+};
+
+struct ThreadStats {
+    ProbeStats probes[static_cast<int>(Probe::Count)];
+    std::atomic<uint64_t> counters[static_cast<int>(Counter::Count)];
+
+    ThreadStats();  // registers the thread for the summary
+    ~ThreadStats(); // folds its totals into the retired threads
+};
+
+class Instrumentation {
+public:
+    static uint64_t now() {
+#if defined(__x86_64__) || defined(__i386__)
+        return __rdtsc();
+#else
+        return static_cast<uint64_t>(std::chrono::steady_clock::now().time_since_epoch().count());
+#endif
+    }
+
+    static ThreadStats& local() {
+        thread_local ThreadStats stats;
+        return stats;
+    }
+
+    static void record(Probe probe, uint64_t cycles) {
+        ProbeStats& s = local().probes[static_cast<int>(probe)];
+        s.count.store(s.count.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        s.cycles.store(s.cycles.load(std::memory_order_relaxed) + cycles, std::memory_order_relaxed);
+        if (cycles > s.maxCycles.load(std::memory_order_relaxed)) s.maxCycles.store(cycles, std::memory_order_relaxed);
+    }
+
+    static void count(Counter counter) {
+        std::atomic<uint64_t>& c = local().counters[static_cast<int>(counter)];
+        c.store(c.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    static void dumpSummary(std::ostream& os);
+};
+
+class ScopedTimer {
+private:
+    Probe probe;
+    uint64_t start;
+
+public:
+    explicit ScopedTimer(Probe probe) : probe(probe), start(Instrumentation::now()) {}
+    ~ScopedTimer() { Instrumentation::record(probe, Instrumentation::now() - start); }
+    ScopedTimer(const ScopedTimer&) = delete;
+    ScopedTimer& operator=(const ScopedTimer&) = delete;
+};
+
+#define MEMO_CONCAT_INNER(a, b) a##b
+#define MEMO_CONCAT(a, b) MEMO_CONCAT_INNER(a, b)
+#define MEMO_SCOPE(probe) ScopedTimer MEMO_CONCAT(memoScope, __LINE__)(probe)
+#define MEMO_COUNT(counter) Instrumentation::count(counter)
+#define MEMO_DUMP(os) Instrumentation::dumpSummary(os)
+
+#else
+
+#define MEMO_SCOPE(probe) ((void)0)
+#define MEMO_COUNT(counter) ((void)0)
+#define MEMO_DUMP(os) ((void)0)
+
+#endif
+
+#endif
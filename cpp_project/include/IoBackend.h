@@ -0,0 +1,61 @@
+#ifndef IOBACKEND_H
+#define IOBACKEND_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <sys/uio.h>
+
+// Socket I/O under GameServer: a backend accepts clients on a listening socket,
+// hands their bytes to the server and sends its replies without ever blocking.
+// Clients are identified by their file descriptor. A client can be detached
+// from one backend and adopted by another (server shards hand sockets over).
+//   epoll  readiness events; one recv per wakeup, writes as soon as they are queued
+//   uring  io_uring completions; multishot accept and recv into provided
+//          buffers, sends from registered buffers, all submitted in one syscall per poll
+
+// What a backend reports to the server
+class IoEvents {
+public:
+    virtual ~IoEvents() {}
+    virtual void onOpen(int client) = 0;
+    virtual void onData(int client, const char* data, size_t size) = 0;
+    // The peer left, failed or stopped reading; the backend closes the socket
+    virtual void onClose(int client) = 0;
+    // After detach(): the backend no longer uses the socket; unsent may be taken
+    virtual void onDetach(int client, std::string& unsent) = 0;
+    // The wake descriptor was signalled
+    virtual void onWake() = 0;
+};
+
+class IoBackend {
+public:
+    static const size_t kMaxPending = 64 * 1024; // unsent bytes before a client is dropped
+
+    virtual ~IoBackend() {}
+
+    // Waits up to timeoutMs (-1 forever) and reports what happened; returns the completions handled
+    virtual int poll(int timeoutMs, IoEvents& events) = 0;
+    // Sends parts after anything still unsent for client
+    virtual void send(int client, const iovec* parts, int count) = 0;
+    // Bytes sent to client that the kernel has not taken yet
+    virtual size_t unsent(int client) const = 0;
+    // Closes client without an onClose
+    virtual void close(int client) = 0;
+    // Stops reading client; onDetach follows once no write is in flight.
+    // Data that was already on its way may still arrive through onData first.
+    virtual void detach(int client) = 0;
+    // Serves an open socket from another backend, sending unsent first
+    virtual void adopt(int client, const std::string& unsent) = 0;
+    // Until release(), sends only queue up: a server logging its moves syncs the
+    // log in between, so no client hears of a move that is not on disk yet
+    virtual void hold() = 0;
+    virtual void release() = 0;
+};
+
+// Both throw ServerError when the kernel refuses to set them up.
+// wakeFd is an eventfd reported through onWake, -1 for none.
+std::unique_ptr<IoBackend> makeEpollBackend(int listenFd, int wakeFd);
+std::unique_ptr<IoBackend> makeUringBackend(int listenFd, int wakeFd);
+
+#endif
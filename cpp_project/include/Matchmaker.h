@@ -0,0 +1,116 @@
+#ifndef MATCHMAKER_H
+#define MATCHMAKER_H
+
+#include "MpmcQueue.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// A client waiting for a table. fd is process wide, so it names the client on
+// whichever shard holds it; serial tells this wait apart from later ones.
+struct Ticket {
+    int shard;
+    int fd;
+    uint32_t serial;
+    char name[16]; // zero padded, not terminated when full
+};
+
+// Groups waiting clients into tables of one size and rule mode. Each
+// (seats, mode) bucket is a lock-free MPMC queue plus a counter of tickets
+// pushed: the thread whose push completes a multiple of seats pops that many
+// and forms the table, so any shard can queue and form without a global lock.
+// Each fd has one atomic state word (a wait counter in the high bits, idle,
+// queued or claimed in the low two), so cancel() and the claim of a popped
+// ticket are one compare-and-swap each; tickets cancelled in the meantime are
+// dropped and the rest of the group is queued again.
+class Matchmaker {
+public:
+    static const int kMinSeats = 2;
+    static const int kMaxGroup = 16;
+    static const int kModes = 3;
+    static const size_t kMaxClients = 1 << 20;
+
+private:
+    struct Bucket {
+        MpmcQueue<Ticket> queue;
+        alignas(64) std::atomic<uint64_t> pushed;
+
+        explicit Bucket(size_t capacity) : queue(capacity), pushed(0) {}
+    };
+
+    int maxSeats;
+    std::vector<std::unique_ptr<Bucket>> buckets; // [(seats - kMinSeats) * kModes + mode]
+    std::unique_ptr<std::atomic<uint32_t>[]> states; // indexed by fd
+    size_t maxClients;
+
+    // State after a wait ends, whether seated or cancelled
+    static uint32_t idleAfter(uint32_t serial) { return (serial | 3u) + 1; }
+
+    // After a push completed a group: pops and claims it; false if some were cancelled,
+    // leaving the `claimed` others for the caller to queue again
+    bool take(Bucket& bucket, int seats, Ticket* group, int& claimed);
+
+public:
+    // capacity: tickets per bucket; fds from 0 to maxClients - 1 can queue.
+    // Throws std::invalid_argument unless kMinSeats <= maxSeats <= kMaxGroup.
+    Matchmaker(int maxSeats, size_t capacity, size_t maxClients);
+    Matchmaker(const Matchmaker&) = delete;
+    Matchmaker& operator=(const Matchmaker&) = delete;
+
+    bool isValid(int mode, int seats) const {
+        return mode >= 0 && mode < kModes && seats >= kMinSeats && seats <= maxSeats;
+    }
+
+    // Queues ticket (its serial is set here) and calls form(const Ticket* group, int seats)
+    // for every table this call completes, possibly including ticket. Returns false
+    // when the client is already queued, its fd is out of range or the bucket is full.
+    template <typename Fn>
+    bool join(int mode, int seats, Ticket& ticket, Fn form);
+
+    // Takes fd out of the queue; false if it was not queued or a table was formed with
+    // it. Waits while its group is being checked, so false is final.
+    bool cancel(int fd, uint32_t serial);
+
+    // Open file limit of the process, at most kMaxClients: enough for any fd it can have
+    static size_t clientLimit();
+};
+
+template <typename Fn>
+bool Matchmaker::join(int mode, int seats, Ticket& ticket, Fn form) {
+    if (!isValid(mode, seats) || ticket.fd < 0 || static_cast<size_t>(ticket.fd) >= maxClients) return false;
+    std::atomic<uint32_t>& state = states[ticket.fd];
+    uint32_t current = state.load(std::memory_order_relaxed);
+    if ((current & 3) != 0 || !state.compare_exchange_strong(current, current | 1)) return false;
+    ticket.serial = current | 1;
+
+    Bucket& bucket = *buckets[(seats - kMinSeats) * kModes + mode];
+    if (!bucket.queue.push(ticket)) {
+        state.store(idleAfter(ticket.serial), std::memory_order_release);
+        return false;
+    }
+
+    // Whoever completes a group forms it; requeued survivors may complete more
+    Ticket group[kMaxGroup];
+    int pending = 1;
+    while (pending > 0) {
+        --pending;
+        if (bucket.pushed.fetch_add(1, std::memory_order_acq_rel) % seats != static_cast<uint64_t>(seats - 1)) continue;
+        int claimed = 0;
+        if (take(bucket, seats, group, claimed)) {
+            form(static_cast<const Ticket*>(group), seats);
+            continue;
+        }
+        for (int k = 0; k < claimed; ++k) {
+            // Same serial: the client still waits on it, and the old copy was popped
+            std::atomic<uint32_t>& other = states[group[k].fd];
+            other.store(group[k].serial, std::memory_order_release);
+            if (bucket.queue.push(group[k])) ++pending;
+            else other.store(idleAfter(group[k].serial), std::memory_order_release); // full: it lost its place
+        }
+    }
+    return true;
+}
+
+#endif
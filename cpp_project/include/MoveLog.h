@@ -0,0 +1,109 @@
+#ifndef MOVELOG_H
+#define MOVELOG_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// One entry of the move log: something a server table accepted, by local table index.
+// Open is followed by the table's deal (Table::kDealSize bytes) and Join by the
+// player's name (value bytes); the others carry nothing more.
+struct LogRecord {
+    enum class Type : uint8_t { Open = 1, Join, Move, Timeout, Close };
+
+    Type type;
+    uint8_t seat;  // Open: the mode
+    uint8_t value; // Open: seats, Join: name length, Move: position row*5+col, Timeout: 1 if forfeited
+    uint8_t reserved;
+    uint32_t table;
+};
+
+// File layout: 64-byte header | blocks of records, each {u32 size, u32 checksum} then size bytes
+struct LogHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint32_t shard; // the server shard writing it, of shardCount: table indexes are per shard
+    uint32_t shardCount;
+    uint64_t base; // position of the first record, those before were truncated
+    uint8_t reserved[32];
+};
+
+// Write-ahead log of a server shard's tables: the deal, the joins and every accepted
+// move, enough to play each game again after the process died. Records collect in a
+// buffer and commit() writes them as one checksummed block followed by one
+// fdatasync, so a whole poll of moves over every table costs a single sync
+// (group commit). Opening an existing log maps it for next(); a torn or corrupt
+// last block ends the log there and is overwritten by the next commit.
+// Positions count the record bytes logged since the log was created, so they
+// survive truncation, which drops what a checkpoint already holds.
+class MoveLog {
+public:
+    static const size_t kBlockHeader = 2 * sizeof(uint32_t);
+
+private:
+    std::string path;
+    int shard;
+    int shardCount;
+    int fd;
+    uint64_t end;       // of the last whole block
+    uint64_t base;      // position at the first block
+    uint64_t committed; // position at end
+    std::vector<uint8_t> buffer; // block header, then the records of the next commit
+    const uint8_t* mapped;       // the log as found on open, until next() is done with it
+    size_t mappedLength;
+    size_t readPos;
+    size_t blockEnd;
+    uint64_t readPosition;
+    uint64_t markOffset; // where the position mark() returned starts in the file
+    uint64_t markPosition;
+    int fresh;           // the replacement file while truncating, -1 otherwise
+    uint64_t copyEnd;    // blocks before it are copied by copyTail, later ones written by commit()
+
+    void append(const LogRecord& record, const void* payload, size_t size);
+    void unmap();
+
+public:
+    // Opens or creates the log at path; throws ArchiveError, also when it was
+    // written by another shard or for another number of shards
+    MoveLog(const std::string& path, int shard, int shardCount);
+    ~MoveLog(); // commits what is left
+    MoveLog(const MoveLog&) = delete;
+    MoveLog& operator=(const MoveLog&) = delete;
+
+    // Records found on open, in order, with their position: false after the last
+    // one. payload points at what follows the record and stays valid until the next call.
+    bool next(LogRecord& record, const uint8_t*& payload, uint64_t& position);
+
+    void appendOpen(uint32_t table, int mode, int seats, const uint8_t* deal);
+    void appendJoin(uint32_t table, int seat, std::string_view name);
+    void appendMove(uint32_t table, int seat, int position);
+    void appendTimeout(uint32_t table, int seat, bool forfeit);
+    void appendClose(uint32_t table);
+
+    bool hasPending() const { return buffer.size() > kBlockHeader; }
+    uint64_t size() const { return end; }
+    uint64_t getBase() const { return base; }
+    // Position of the next record appended
+    uint64_t position() const { return committed + buffer.size() - kBlockHeader; }
+    // Writes and syncs the records appended since the last commit
+    void commit();
+
+    // Commits and returns the position reached, remembered for truncation
+    uint64_t mark();
+
+    // Drops the records before the last mark in three steps, so a crash leaves
+    // either the old log or the new one, each with every commit:
+    // beginTruncate opens a new file that commit() also writes and syncs from then on,
+    // copyTail copies the records from the mark to there, syncs and renames the new
+    // file over the log (any thread, e.g. a checkpoint's syncer: the slow part), and
+    // endTruncate switches to the new file once copyTail returned. Throw ArchiveError.
+    void beginTruncate();
+    void copyTail();
+    void endTruncate();
+    bool isTruncating() const { return fresh >= 0; }
+};
+
+#endif
@@ -13,6 +13,7 @@ private:
     int nRubies;
     bool active;
     mutable bool displayMode; // true for endOfGame
+    friend struct GameSnapshot;
 
 public:
     Player(const std::string& name, Side side);
@@ -27,4 +28,6 @@ public:
     friend std::ostream& operator<<(std::ostream& os, const Player& player);
 };
 
+std::string sideToString(Side s);
+
 #endif
@@ -0,0 +1,17 @@
+#ifndef POSITION_H
+#define POSITION_H
+
+#include "Enums.h"
+#include <iostream>
+#include <string_view>
+
+enum class PositionStatus { Ok, BadFormat, OutOfRange, Hole, EndOfInput };
+
+// Parses a board position such as "A1", "e5" or " b 4 " in a single pass.
+// Never throws; l and n are only written when the result is Ok.
+PositionStatus parsePosition(std::string_view text, Letter& l, Number& n) noexcept;
+
+// Reads one line from in and parses it; EndOfInput once the stream is exhausted
+PositionStatus readPosition(std::istream& in, Letter& l, Number& n);
+
+#endif
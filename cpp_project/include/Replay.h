@@ -0,0 +1,89 @@
+#ifndef REPLAY_H
+#define REPLAY_H
+
+#include <cstdint>
+#include <cstring>
+#include <cstddef>
+#include <vector>
+
+// Compact replay of one game.
+// A record is laid out as:
+//   u32 size | u8 nPlayers | u8 mode | u16 nEvents | u8 layout[25] | u8 rubies[nPlayers] | events
+// Multi-byte fields are little-endian. Layout cells hold animal*5+background, 0xFF for the hole.
+
+enum class ReplayEffect : uint8_t { None, Swap, TurnDown, Block, PlayAgain, SkipNext, Award };
+
+const uint8_t kReplayNoPosition = 0xFF;
+const int kReplayCells = 25;
+const size_t kReplayFixedBytes = 8 + kReplayCells;
+
+// One reveal (or a round award) - 6 bytes, no padding
+struct ReplayEvent {
+    uint8_t round;    // 1..7
+    uint8_t seat;     // index of the player in the game
+    uint8_t position; // row*5+col, kReplayNoPosition for awards
+    uint8_t card;     // animal*5+background, rubis value for awards
+    uint8_t flags;    // bit 0: matched, bits 4-7: ReplayEffect
+    uint8_t target;   // expert effect target, kReplayNoPosition if none
+
+    bool matched() const { return (flags & 1) != 0; }
+    ReplayEffect effect() const { return static_cast<ReplayEffect>(flags >> 4); }
+    static uint8_t makeFlags(bool matched, ReplayEffect effect) {
+        return static_cast<uint8_t>((static_cast<uint8_t>(effect) << 4) | (matched ? 1 : 0));
+    }
+};
+
+// Owning replay, used while recording a game and when appending to an archive
+class Replay {
+private:
+    uint8_t nPlayers;
+    uint8_t mode;
+    uint8_t layout[kReplayCells];
+    std::vector<uint8_t> rubies;
+    std::vector<ReplayEvent> events;
+
+public:
+    Replay(int nPlayers = 0, int mode = 0);
+
+    int getNPlayers() const { return nPlayers; }
+    int getMode() const { return mode; }
+    int getLayout(int cell) const { return layout[cell]; }
+    void setLayout(int cell, int cardId) { layout[cell] = static_cast<uint8_t>(cardId); }
+    int getRubies(int seat) const { return rubies[seat]; }
+    void setRubies(int seat, int n) { rubies[seat] = static_cast<uint8_t>(n); }
+    size_t getNEvents() const { return events.size(); }
+    const ReplayEvent& getEvent(size_t i) const { return events[i]; }
+    void addEvent(const ReplayEvent& event) { events.push_back(event); }
+    void clear(int nPlayers, int mode);
+
+    size_t encodedSize() const;
+    void encode(uint8_t* out) const;
+};
+
+// Non-owning view of an encoded replay (e.g. inside a mapped archive)
+class ReplayView {
+private:
+    const uint8_t* data;
+
+public:
+    explicit ReplayView(const uint8_t* data = nullptr) : data(data) {}
+
+    uint32_t size() const {
+        uint32_t s;
+        std::memcpy(&s, data, sizeof(s));
+        return s;
+    }
+    int getNPlayers() const { return data[4]; }
+    int getMode() const { return data[5]; }
+    size_t getNEvents() const { return static_cast<size_t>(data[6] | (data[7] << 8)); }
+    int getLayout(int cell) const { return data[8 + cell]; }
+    int getRubies(int seat) const { return data[kReplayFixedBytes + seat]; }
+    const uint8_t* eventBytes() const { return data + kReplayFixedBytes + getNPlayers(); }
+    ReplayEvent getEvent(size_t i) const {
+        ReplayEvent e;
+        std::memcpy(&e, eventBytes() + i * sizeof(ReplayEvent), sizeof(ReplayEvent));
+        return e;
+    }
+};
+
+#endif
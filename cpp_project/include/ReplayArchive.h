@@ -0,0 +1,92 @@
+#ifndef REPLAYARCHIVE_H
+#define REPLAYARCHIVE_H
+
+#include "Replay.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <iterator>
+
+// Append-only archive of compact replays.
+// File layout: 64-byte header | records | u64 offset index (one per game).
+// A writer reopening the archive appends after the old index and writes a new
+// one after its records; the header is switched over last, once both are
+// synced, so a crash mid-append leaves the games already stored intact.
+struct ArchiveHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t headerSize;
+    uint64_t gameCount;
+    uint64_t indexOffset; // also the end of the record data
+    uint8_t reserved[32];
+};
+
+class ReplayArchiveWriter {
+private:
+    int fd;
+    uint64_t dataEnd;
+    uint64_t stored; // games the header already covers
+    std::vector<uint64_t> index;
+    std::vector<uint8_t> buffer;
+
+    void flushBuffer();
+
+public:
+    // Opens an existing archive for appending, or creates a new one
+    explicit ReplayArchiveWriter(const std::string& path);
+    ~ReplayArchiveWriter();
+    ReplayArchiveWriter(const ReplayArchiveWriter&) = delete;
+    ReplayArchiveWriter& operator=(const ReplayArchiveWriter&) = delete;
+
+    void append(const Replay& replay);
+    uint64_t getGameCount() const { return index.size(); }
+    void close(); // flushes records, writes and syncs the index, then the header
+};
+
+// Read-only view of an archive through mmap; replays are decoded in place
+class ReplayArchive {
+private:
+    const uint8_t* base;
+    size_t length;
+    const ArchiveHeader* header;
+
+    // Throws ArchiveError if game i's record does not fit in the data before the index
+    ReplayView record(uint64_t i) const;
+
+public:
+    // Walks the index: records of successive writers are separated by the index they replaced
+    class Iterator {
+    private:
+        const ReplayArchive* archive;
+        uint64_t i;
+
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = ReplayView;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const ReplayView*;
+        using reference = ReplayView;
+
+        Iterator(const ReplayArchive* archive, uint64_t i) : archive(archive), i(i) {}
+        ReplayView operator*() const { return archive->record(i); }
+        Iterator& operator++() {
+            ++i;
+            return *this;
+        }
+        bool operator==(const Iterator& other) const { return i == other.i; }
+        bool operator!=(const Iterator& other) const { return i != other.i; }
+    };
+
+    explicit ReplayArchive(const std::string& path);
+    ~ReplayArchive();
+    ReplayArchive(ReplayArchive&& other) noexcept;
+    ReplayArchive(const ReplayArchive&) = delete;
+    ReplayArchive& operator=(const ReplayArchive&) = delete;
+
+    uint64_t size() const { return header->gameCount; }
+    ReplayView operator[](uint64_t i) const;
+    Iterator begin() const { return Iterator(this, 0); }
+    Iterator end() const { return Iterator(this, header->gameCount); }
+};
+
+#endif
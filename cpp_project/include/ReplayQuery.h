@@ -0,0 +1,91 @@
+#ifndef REPLAYQUERY_H
+#define REPLAYQUERY_H
+
+#include "ReplayArchive.h"
+#include <cstdint>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// Columns of the per-event table built from a replay archive
+enum class EventColumn { Round, Reveal, Seat, Card, Animal, Background, Matched, Effect };
+
+const int kEventColumns = 8;
+const int kQuerySeats = 8;
+
+// Replay events flattened into one array per column.
+// Row i of every column describes the same event.
+class EventColumns {
+private:
+    std::vector<uint8_t> columns[kEventColumns];
+    uint64_t games;
+    uint64_t seatGames[kQuerySeats]; // games each seat took part in: the denominator of per-seat rates
+    uint64_t seatWins[kQuerySeats];  // games each seat ended with the most rubies (ties all win)
+
+public:
+    EventColumns() : games(0), seatGames(), seatWins() {}
+
+    // Decodes every replay of the archive, split across nThreads (0 = hardware concurrency)
+    static EventColumns fromArchive(const ReplayArchive& archive, int nThreads = 0);
+
+    size_t size() const { return columns[0].size(); }
+    const std::vector<uint8_t>& get(EventColumn c) const { return columns[static_cast<int>(c)]; }
+    uint64_t getGames() const { return games; }
+    uint64_t getGamesPlayed(int seat) const { return seatGames[seat]; }
+    uint64_t getGamesWon(int seat) const { return seatWins[seat]; }
+    // Seats are Sides in seat order (seat k plays Side k) in every front end
+    double winRate(int seat) const { return seatGames[seat] ? double(seatWins[seat]) / double(seatGames[seat]) : 0.0; }
+};
+
+struct GroupStats {
+    uint64_t count = 0;
+    uint64_t matched = 0;
+
+    double matchRate() const { return count ? double(matched) / double(count) : 0.0; }
+    double eliminationRate() const { return count ? 1.0 - matchRate() : 0.0; }
+};
+
+struct QueryOptions;
+
+// Equality filters plus an optional group-by column, e.g.
+//   EventQuery().where(EventColumn::Animal, Walrus).where(EventColumn::Reveal, 3).groupBy(EventColumn::Round)
+// Grouped by Seat, the report also gives each Side's game win rate (EventColumns::winRate).
+class EventQuery {
+private:
+    struct Filter {
+        EventColumn column;
+        uint8_t value;
+    };
+    std::vector<Filter> filters;
+    bool grouped;
+    EventColumn groupColumn;
+
+public:
+    EventQuery() : grouped(false), groupColumn(EventColumn::Round) {}
+    EventQuery& where(EventColumn column, int value);
+    EventQuery& groupBy(EventColumn column);
+    bool isGrouped() const { return grouped; }
+    EventColumn getGroupColumn() const { return groupColumn; }
+
+    // Result is indexed by group key (a single entry when not grouped)
+    std::vector<GroupStats> run(const EventColumns& table, int nThreads = 0) const;
+
+    // Query mode of the console binary: loads the archive, runs the query and prints a line per group
+    static int report(const QueryOptions& options, std::ostream& out);
+    // Parses command line options; false on unknown columns or malformed arguments
+    static bool parseArgs(int argc, char* argv[], QueryOptions& options);
+};
+
+// game --query ARCHIVE [--where COLUMN=VALUE ...] [--group-by COLUMN] [--threads N]
+//   COLUMN round|reveal|seat|card|animal|background|matched|effect
+//   VALUE  a number, or a name for animal (crab..walrus), background (red..yellow),
+//          effect (none|swap|turn_down|block|play_again|skip_next|award) and seat (top..bottom-left)
+struct QueryOptions {
+    std::string archivePath;
+    EventQuery query;
+    int threads; // 0: hardware concurrency
+
+    QueryOptions() : threads(0) {}
+};
+
+#endif
@@ -3,14 +3,22 @@
 
 #include "DeckFactory.h"
 #include "Rubis.h"
+#include <cstdint>
 
 class RubisDeck : public DeckFactory<Rubis> {
 private:
-    static RubisDeck* instance;
+    static thread_local RubisDeck* instance; // one deck per thread (server shards)
     RubisDeck();
 
 public:
     static RubisDeck& make_RubisDeck();
+
+    // Draw order as values, and how many were drawn. Games sharing the deck
+    // (snapshots, server tables) keep their own order and put it back before drawing.
+    int getOrder(uint8_t* values, int capacity) const;
+    void setOrder(const uint8_t* values, int count, int drawn);
+    // Whether setOrder would accept these values, checked without reordering
+    bool matchesOrder(const uint8_t* values, int count) const;
 };
 
 #endif
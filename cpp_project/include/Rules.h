@@ -5,23 +5,86 @@
 #include "Player.h"
 #include "Enums.h"
 #include "Card.h" 
+#include "Geometry.h"
+#include <array>
+#include <string_view>
+
+// Compile-time rule sets. The engine is specialized per policy, so a base game
+// carries no expert branches; front ends pick the policy once with dispatchRules().
+// Custom variants are any other combination, e.g. RulePolicy<false, true, false>.
+template <bool Display, bool TurnEffects, bool TargetEffects>
+struct RulePolicy {
+    static constexpr bool expertDisplay = Display;
+    static constexpr bool turnEffects = TurnEffects;     // Crab plays again, Turtle skips
+    static constexpr bool targetEffects = TargetEffects; // Octopus, Penguin and Walrus targets
+    static constexpr bool expertRules = TurnEffects || TargetEffects;
+    static constexpr int mode = expertRules ? 2 : (Display ? 1 : 0); // snapshot and replay mode
+};
+
+using BasePolicy = RulePolicy<false, false, false>;
+using ExpertDisplayPolicy = RulePolicy<true, false, false>;
+using ExpertRulesPolicy = RulePolicy<false, true, true>;
+
+// Calls fn(Policy()) for a game mode (0 base, 1 expert display, 2 expert rules)
+template <typename Fn>
+auto dispatchRules(int mode, Fn&& fn) {
+    switch (mode) {
+        case 1: return fn(ExpertDisplayPolicy());
+        case 2: return fn(ExpertRulesPolicy());
+        default: return fn(BasePolicy());
+    }
+}
+
+// Power of each FaceAnimal, indexed by animal
+using AnimalPowers = std::array<AnimalPower, kFaceKinds>;
+
+// Printed rules: Crab plays again, Penguin turns down, Octopus swaps, Turtle skips, Walrus blocks;
+// the animals only larger decks deal have no power
+constexpr AnimalPowers kStandardPowers = {{AnimalPower::PlayAgain, AnimalPower::TurnDown, AnimalPower::SwapAdjacent,
+                                           AnimalPower::SkipNext, AnimalPower::Block, AnimalPower::None,
+                                           AnimalPower::None}};
 
 class Rules {
 private:
-    bool expertRules;
+    AnimalPowers powers;
 
 public:
-    // Constructor initializes the expert mode flag
-    Rules(bool expertRules = false) : expertRules(expertRules) {}
+    static constexpr int kRounds = 7;
+
+    // A reveal is valid if it shares the animal or the background of the previous card;
+    // ids are animal * kinds + background of a kinds x kinds deck
+    static constexpr bool idsMatch(int previousId, int currentId, int kinds = StandardGeometry::kKinds) {
+        return previousId / kinds == currentId / kinds || previousId % kinds == currentId % kinds;
+    }
+
+    // A round ends with one active seat left, or once no card is face down: nobody
+    // can reveal anything more. Shared with engines that keep no Game (BatchEnv).
+    static constexpr bool roundEnds(int activeSeats, uint64_t faceUpMask) {
+        return activeSeats <= 1 || faceUpMask == Board::kCellMask;
+    }
+
+    Rules() : powers(kStandardPowers) {}
+    explicit Rules(const AnimalPowers& powers) : powers(powers) {}
 
     // core game logic methods implemented in Rules.cpp
     bool isValid(const Game& game) const;
     bool gameOver(const Game& game) const;
     bool roundOver(const Game& game) const;
     const Player& getNextPlayer(const Game& game) const;
-    
-    // Expert rule logic
-    ExpertEffect applyExpertRule(Game& game, const Card& card, Player& currentPlayer);
+
+    // Expert rule logic (no I/O, the front end asks for targets).
+    // Only called by engines whose policy enables the effect; each animal's
+    // power is looked up in a table of pure state transitions.
+    AnimalPower getPower(FaceAnimal animal) const { return powers[static_cast<int>(animal)]; }
+    const AnimalPowers& getPowers() const { return powers; }
+    ExpertEffect applyExpertRule(const Card& card) const;
+    bool needsTarget(const Game& game, const Card& card) const;
+    // Swap, turn-down or block on the target; false if ignored
+    bool applyTarget(Game& game, const Card& card, Letter l, Number n, Letter targetL, Number targetN) const;
+
+    // Reassigns powers from "crab=skip_next,turtle=play_again" (commas or spaces);
+    // animals not named keep their power. Returns false on unknown names.
+    static bool parsePowers(std::string_view spec, AnimalPowers& powers);
 };
 
 #endif
\ No newline at end of file
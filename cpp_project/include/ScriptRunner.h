@@ -0,0 +1,59 @@
+#ifndef SCRIPTRUNNER_H
+#define SCRIPTRUNNER_H
+
+#include "Rules.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <iostream>
+
+class Replay;
+
+// Batch mode of the console binary:
+//   game --script FILE [--seed N] [--repeat N] [--render | --quiet] [--archive FILE] [--trace FILE]
+//        [--powers SPEC]
+//
+// Script format (whitespace separated, '#' starts a comment):
+//   mode base|expert_display|expert_rules
+//   powers crab=skip_next turtle=play_again ...   optional, see Rules::parsePowers
+//   players NAME NAME [NAME ...]                  up to 8 seats
+//   A1 b4 E2 ...   moves, consumed in order by whoever must act (picks and expert targets)
+struct ScriptOptions {
+    std::string scriptPath;
+    unsigned seed;
+    int repeat;
+    bool render;  // print the board after every move
+    bool quiet;   // print only the summary line
+    std::string archivePath;
+    std::string tracePath; // Chrome trace of the run (needs -DMEMO_TRACE)
+    std::string powers;    // applied after the script's powers line, to sweep variants
+
+    ScriptOptions() : seed(1), repeat(1), render(false), quiet(false) {}
+};
+
+class ScriptRunner {
+private:
+    ScriptOptions options;
+    int mode;
+    AnimalPowers powers;
+    std::vector<std::string> names;
+    std::vector<uint8_t> moves; // row*5+col, 0xFF for unreadable tokens
+
+    void load();
+    template <typename Policy>
+    bool playGame(std::ostream& out, Replay* replay, std::vector<int>& rubies);
+
+public:
+    explicit ScriptRunner(const ScriptOptions& options);
+
+    // Plays the script once from options.seed: rubies by seat, false if the moves ran out
+    bool playOne(std::ostream& out, Replay* replay, std::vector<int>& rubies);
+
+    // Plays the script options.repeat times; returns 0 if every game completed
+    int run(std::ostream& out);
+
+    // Parses command line options; false on unknown or malformed arguments
+    static bool parseArgs(int argc, char* argv[], ScriptOptions& options);
+};
+
+#endif
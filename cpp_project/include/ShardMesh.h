@@ -0,0 +1,71 @@
+#ifndef SHARDMESH_H
+#define SHARDMESH_H
+
+#include "Matchmaker.h"
+#include "SpscQueue.h"
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// A message between shards about a client and a table:
+//   Client  the client moves to the shard that owns the table it joins; the
+//           socket travels with everything the old shard still held for it
+//   Fetch   matchmaking seated a client of shard `shard` at table: send it there
+//   Gone    that client left before it could be sent; its seat stays empty
+struct Handoff {
+    enum class Kind : uint8_t { Client, Fetch, Gone };
+
+    Kind kind;
+    int fd;
+    int table;            // global table id to join
+    bool watch;           // Client: watches the table instead of joining it
+    std::string name;
+    uint8_t protocol;     // GameServer's protocol of the connection
+    std::string input;    // received but not handled yet
+    std::string unsent;   // replies the old shard had not written yet
+    uint32_t tableSerial; // the formed table it is meant for, 0 for any table with that id
+    int shard;            // Fetch: shard holding the client
+    uint32_t queueSerial; // Fetch: its matchmaking ticket
+
+    Handoff()
+        : kind(Kind::Client), fd(-1), table(-1), watch(false), protocol(0), tableSerial(0), shard(-1), queueSerial(0) {}
+    // Only a Client handoff owns its socket
+    bool ownsSocket() const { return kind == Kind::Client; }
+};
+
+// Links between server shards: one SPSC queue per ordered pair of shards, an
+// eventfd per shard that its I/O backend watches and the matchmaker they
+// share. Tables never move; only lobby traffic (handoffs) goes through here.
+class ShardMesh {
+public:
+    static const size_t kQueueCapacity = 4096;
+    static const size_t kTicketCapacity = 4096; // per matchmaking bucket
+
+private:
+    int count;
+    Matchmaker matchmaker;
+    std::vector<std::unique_ptr<SpscQueue<Handoff>>> queues; // [from * count + to]
+    std::vector<int> wakeFds;
+
+public:
+    // Throws ServerError when eventfds cannot be created
+    explicit ShardMesh(int count);
+    // Closes the sockets of handoffs nobody picked up
+    ~ShardMesh();
+    ShardMesh(const ShardMesh&) = delete;
+    ShardMesh& operator=(const ShardMesh&) = delete;
+
+    int size() const { return count; }
+    int getWakeFd(int shard) const { return wakeFds[shard]; }
+    Matchmaker& getMatchmaker() { return matchmaker; }
+
+    // Called by shard `from` only; wakes `to`. False when the queue is full.
+    bool push(int from, int to, Handoff& handoff);
+    // Called by shard `to` only
+    bool pop(int from, int to, Handoff& handoff) { return queues[from * count + to]->pop(handoff); }
+    void wake(int shard);
+};
+
+#endif
@@ -0,0 +1,40 @@
+#ifndef SHARDEDSERVER_H
+#define SHARDEDSERVER_H
+
+#include "GameServer.h"
+#include "ShardMesh.h"
+#include <mutex>
+#include <string>
+#include <vector>
+
+// One GameServer per core (`game --server HOST:PORT --shards N`). Each shard
+// runs on its own thread pinned to a core and owns everything it touches: a
+// SO_REUSEPORT listening socket, its I/O backend, decks, table pool and timer
+// wheel. Tables never leave the shard that created them, so Game and Board
+// need no locks; a client joining another shard's table is detached from its
+// backend and handed to the owner through the ShardMesh queues.
+class ShardedServer {
+private:
+    ServerOptions options;
+    ShardMesh mesh;
+    std::mutex mutex;                // guards shards and stopping
+    std::vector<GameServer*> shards; // set while each shard runs
+    bool stopping;
+
+    void runShard(int shard, std::string& failure);
+
+public:
+    // options.shards 0 means one shard per core
+    explicit ShardedServer(const ServerOptions& options);
+    ShardedServer(const ShardedServer&) = delete;
+    ShardedServer& operator=(const ShardedServer&) = delete;
+
+    int getShardCount() const { return mesh.size(); }
+
+    // Runs every shard until stop() or SIGINT/SIGTERM; throws ServerError when a
+    // shard cannot start (the others are stopped first)
+    int run();
+    void stop();
+};
+
+#endif
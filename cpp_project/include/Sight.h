@@ -0,0 +1,49 @@
+#ifndef SIGHT_H
+#define SIGHT_H
+
+#include "Enums.h"
+#include "Geometry.h"
+#include <array>
+#include <cstdint>
+#include <utility>
+
+// Compile-time sight sets: the three cards each side may look at before a round.
+// The corner seats see the corners and the ring around the hole, a quarter turn apart.
+// Positions are also available as StandardGeometry masks, so a side's sight
+// cards can be flipped with a single Board::turnFaceUp(mask).
+
+using SightLocations = std::array<std::pair<Letter, Number>, 3>;
+
+constexpr uint32_t positionBit(Letter l, Number n) {
+    return StandardGeometry::bit(static_cast<int>(l), static_cast<int>(n));
+}
+
+constexpr SightLocations kSightLocations[8] = {
+    {{{Letter::A, Number::Two}, {Letter::A, Number::Three}, {Letter::A, Number::Four}}},   // top
+    {{{Letter::E, Number::Two}, {Letter::E, Number::Three}, {Letter::E, Number::Four}}},   // bottom
+    {{{Letter::B, Number::One}, {Letter::C, Number::One}, {Letter::D, Number::One}}},      // left
+    {{{Letter::B, Number::Five}, {Letter::C, Number::Five}, {Letter::D, Number::Five}}},   // right
+    {{{Letter::A, Number::One}, {Letter::B, Number::Two}, {Letter::B, Number::Three}}},    // topLeft
+    {{{Letter::A, Number::Five}, {Letter::B, Number::Four}, {Letter::C, Number::Four}}},   // topRight
+    {{{Letter::E, Number::Five}, {Letter::D, Number::Four}, {Letter::D, Number::Three}}},  // bottomRight
+    {{{Letter::E, Number::One}, {Letter::D, Number::Two}, {Letter::C, Number::Two}}}};     // bottomLeft
+
+constexpr const SightLocations& sightLocations(Side side) {
+    return kSightLocations[static_cast<int>(side)];
+}
+
+constexpr uint32_t sightMask(Side side) {
+    uint32_t mask = 0;
+    for (const auto& loc : sightLocations(side)) mask |= positionBit(loc.first, loc.second);
+    return mask;
+}
+
+static_assert(sightMask(Side::top) == 0x0000000Eu, "top sight is A2-A4");
+static_assert(sightMask(Side::left) == 0x00008420u, "left sight is B1-D1");
+static_assert((sightMask(Side::top) | sightMask(Side::bottom) | sightMask(Side::left) | sightMask(Side::right)) ==
+                  0x00E8C62Eu, "side sight sets are disjoint and skip the corners");
+static_assert((sightMask(Side::topLeft) | sightMask(Side::topRight) | sightMask(Side::bottomRight) |
+               sightMask(Side::bottomLeft) | 0x00E8C62Eu) == StandardGeometry::kCellMask,
+              "all eight sight sets together cover the board");
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef SLAB_H
+#define SLAB_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+// Fixed-size object pool owned by one thread: objects are carved out of
+// chunks of kChunk slots and freed slots are reused first, so creating and
+// destroying objects of one type never goes back to the global heap once the
+// pool has grown. Not thread safe; a server shard keeps its own.
+template <typename T, size_t kChunk = 256>
+class Slab {
+private:
+    union Slot {
+        Slot* next; // while free
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    std::vector<std::unique_ptr<Slot[]>> chunks;
+    Slot* freeList;
+    size_t used; // slots handed out from the newest chunk
+
+public:
+    Slab() : freeList(nullptr), used(kChunk) {}
+    Slab(const Slab&) = delete;
+    Slab& operator=(const Slab&) = delete;
+
+    // Objects still alive are not destroyed; callers destroy() them first
+    ~Slab() {}
+
+    template <typename... Args>
+    T* create(Args&&... args) {
+        Slot* slot = freeList;
+        if (slot) {
+            freeList = slot->next;
+        } else {
+            if (used == kChunk) {
+                chunks.emplace_back(new Slot[kChunk]);
+                used = 0;
+            }
+            slot = &chunks.back()[used++];
+        }
+        try {
+            return new (slot->storage) T(std::forward<Args>(args)...);
+        } catch (...) {
+            slot->next = freeList;
+            freeList = slot;
+            throw;
+        }
+    }
+
+    void destroy(T* object) {
+        if (!object) return;
+        object->~T();
+        Slot* slot = reinterpret_cast<Slot*>(object);
+        slot->next = freeList;
+        freeList = slot;
+    }
+};
+
+#endif
@@ -0,0 +1,61 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <cstdint>
+#include <string>
+
+class Game;
+class CardDeck;
+class RubisDeck;
+
+const int kSnapshotMaxPlayers = 8;
+const int kSnapshotNameLength = 28;
+const uint8_t kSnapshotNone = 0xFF;
+const uint8_t kSnapshotSecondTurn = 1;     // turnFlags: Crab, the seat on turn plays again
+const uint8_t kSnapshotAwaitingTarget = 2; // turnFlags: the card at pickedPosition wants a target
+const int kSnapshotSkippedShift = 4;       // turnFlags >> 4: the seat the last turn change skipped, plus one
+
+struct SnapshotPlayer {
+    char name[kSnapshotNameLength]; // truncated, zero padded
+    uint8_t side;
+    uint8_t rubies;
+    uint8_t active;
+    uint8_t displayMode;
+};
+
+// Fixed-size binary image of a game in progress.
+// Cards are stored as animal*5+background, positions as row*5+col.
+// mode and the turn (turnPlayer to pickedPosition) belong to the front end
+// driving the game; save() leaves them untouched so the caller can fill them
+// in, e.g. with GameEngine::saveTurn().
+// Sight sets are not stored: restored seats get their Side's default.
+struct GameSnapshot {
+    char magic[4];
+    uint8_t version;
+    uint8_t mode; // 0 base, 1 expert display, 2 expert rules
+    uint8_t round;
+    uint8_t nPlayers;
+    uint32_t faceUpMask;
+    uint8_t layout[25];
+    uint8_t previousCard;
+    uint8_t currentCard;
+    uint8_t blockedPosition;
+    uint8_t turnPlayer;
+    uint8_t skipNext;
+    uint8_t rubisNext; // index of the next rubis to draw
+    uint8_t rubis[7];
+    uint8_t turnFlags;
+    uint8_t pickedPosition; // last card picked, row*5+col
+    SnapshotPlayer players[kSnapshotMaxPlayers];
+
+    GameSnapshot();
+
+    void save(const Game& game, const RubisDeck& rubisDeck);
+    void restore(Game& game, const CardDeck& cardDeck, RubisDeck& rubisDeck) const;
+    bool isValid() const;
+
+    void writeFile(const std::string& path) const;
+    bool readFile(const std::string& path); // false if missing or not a snapshot
+};
+
+#endif
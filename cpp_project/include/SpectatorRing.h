@@ -0,0 +1,53 @@
+#ifndef SPECTATORRING_H
+#define SPECTATORRING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <sys/uio.h>
+#include <vector>
+
+// What a table tells its spectators, written once however many of them follow
+// it. Each reader keeps its own position (the bytes published before it) and
+// takes what is new as at most two iovecs straight out of the ring, at its own
+// pace. A reader that fell more than the capacity behind has lost its place:
+// it must start over from a full picture of the table, so a slow reader costs
+// the table nothing. Owned by one thread (a server shard).
+class SpectatorRing {
+private:
+    std::vector<uint8_t> bytes; // capacity, a power of two
+    uint64_t head;              // bytes published so far
+
+public:
+    explicit SpectatorRing(size_t capacity) : bytes(capacity), head(0) {}
+
+    uint64_t getHead() const { return head; }
+
+    // size is at most the capacity
+    void publish(const void* data, size_t size) {
+        const uint8_t* p = static_cast<const uint8_t*>(data);
+        size_t at = static_cast<size_t>(head & (bytes.size() - 1));
+        size_t first = size < bytes.size() - at ? size : bytes.size() - at;
+        std::memcpy(&bytes[at], p, first);
+        std::memcpy(&bytes[0], p + first, size - first);
+        head += size;
+    }
+
+    // Fills parts with [position, head): returns how many (0 when nothing is
+    // new), or -1 when those bytes were overwritten
+    int read(uint64_t position, iovec parts[2]) const {
+        if (head - position > bytes.size()) return -1;
+        if (position == head) return 0;
+        size_t at = static_cast<size_t>(position & (bytes.size() - 1));
+        size_t size = static_cast<size_t>(head - position);
+        size_t first = size < bytes.size() - at ? size : bytes.size() - at;
+        parts[0].iov_base = const_cast<uint8_t*>(&bytes[at]);
+        parts[0].iov_len = first;
+        if (first == size) return 1;
+        parts[1].iov_base = const_cast<uint8_t*>(&bytes[0]);
+        parts[1].iov_len = size - first;
+        return 2;
+    }
+};
+
+#endif
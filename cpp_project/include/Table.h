@@ -0,0 +1,115 @@
+#ifndef TABLE_H
+#define TABLE_H
+
+#include "Game.h"
+#include "GameEngine.h"
+#include "Rules.h"
+#include "TimerWheel.h"
+#include <cstdint>
+#include <string>
+#include <variant>
+
+// What one action did, for the server to pass on to the seats
+struct TableUpdate {
+    int seat;            // seat that acted
+    bool isTarget;       // an expert target rather than a pick
+    PickResult result;
+    uint8_t position;    // row*5+col picked or targeted, kNoPosition when the seat forfeited
+    uint8_t card;        // card revealed by a pick
+    ExpertEffect effect;
+    bool targetApplied;
+    int skipped;         // seat skipped by Turtle, -1 if none
+    int round;           // round the action was played in
+    uint32_t faceUpMask; // board right after the action
+    uint8_t activeSeats; // seats still in that round
+    int winner;          // seat awarded a rubis when the action ended a round, -1 otherwise
+    int award;           // value of that rubis
+    bool newRound;
+    bool gameOver;
+    bool timedOut;       // the seat ran out of time: the table played for it
+
+    static const uint8_t kNoPosition = 0xFF;
+
+    TableUpdate()
+        : seat(-1), isTarget(false), result(PickResult::Hole), position(0), card(0), effect(ExpertEffect::None),
+          targetApplied(false), skipped(-1), round(0), faceUpMask(0), activeSeats(0), winner(-1), award(0),
+          newRound(false), gameOver(false), timedOut(false) {}
+};
+
+// One game hosted by the server: its seats, the game state and the engine for its mode.
+// Tables share the card and rubis decks; each keeps its own rubis draw order.
+// The engine refers to the game, so a table never moves once built.
+class Table {
+public:
+    enum class State { Waiting, Playing, Over };
+
+private:
+    using Engine = std::variant<GameEngine<BasePolicy>, GameEngine<ExpertDisplayPolicy>, GameEngine<ExpertRulesPolicy>>;
+
+    int id;
+    int mode;
+    int seats;
+    State state;
+    Game game;
+    Rules rules;
+    RubisDeck& rubisDeck;
+    Engine engine;
+    uint8_t rubis[7];
+    uint8_t rubisNext;
+    int clients[Game::kMaxSeats]; // server handle of each seat, -1 if gone
+    TimerNode timer;              // the server's lobby or turn deadline for this table
+    TimerNode idleTimer;          // the server's deadline for the next move of a client
+
+    static Engine makeEngine(int mode, Game& game, Rules& rules, RubisDeck& rubisDeck);
+    void complete(TableUpdate& update, bool roundOver);
+    void finishRound(TableUpdate& update);
+
+public:
+    static const int kDealSize = 32; // layout[25] then rubis[7], see getDeal()
+
+    // mode as in dispatchRules, 2 to Game::kMaxSeats seats
+    Table(int id, int mode, int seats, CardDeck& cardDeck, RubisDeck& rubisDeck);
+    // A table dealt as getDeal() described another one (the move log plays it again)
+    Table(int id, int mode, int seats, const uint8_t* deal, CardDeck& cardDeck, RubisDeck& rubisDeck);
+    // A table as save() left it, without its clients; throws SnapshotError
+    Table(int id, int seats, const GameSnapshot& snapshot, CardDeck& cardDeck, RubisDeck& rubisDeck);
+    Table(const Table&) = delete;
+    Table& operator=(const Table&) = delete;
+
+    int getId() const { return id; }
+    int getMode() const { return mode; }
+    int getSeats() const { return seats; }
+    State getState() const { return state; }
+    const Game& getGame() const { return game; }
+    int getClient(int seat) const { return clients[seat]; }
+    void setClient(int seat, int client) { clients[seat] = client; }
+    // Before the first move: the card ids by position (kSnapshotNone in the hole) and
+    // the rubis values in draw order, as a GameSnapshot stores them
+    void getDeal(uint8_t* deal) const;
+    // The whole game, turn included, for a checkpoint. Names come back cut to
+    // kSnapshotNameLength - 1 characters.
+    void save(GameSnapshot& snapshot) const;
+    TimerNode& getTimer() { return timer; }
+    TimerNode& getIdleTimer() { return idleTimer; }
+
+    // Seats a player; returns the seat, or -1 once the table is full.
+    // The first round starts when the last seat is taken.
+    int join(const std::string& name, int client);
+    // Gives the seat of that name back to a client after the table was recovered
+    // without its clients; returns the seat, or -1 if none is free under that name
+    int rejoin(const std::string& name, int client);
+
+    int getTurn() const;
+    bool isAwaitingTarget() const;
+
+    // Applies seat's pick, or its expert target when one is awaited. Returns false
+    // (update untouched) when it is not seat's move; rejected picks change nothing.
+    // A round also ends once every card is face up (Rules::roundOver), the first active seat winning.
+    bool act(int seat, Letter l, Number n, TableUpdate& update);
+    // Plays for the seat on turn when its time is up: the first hidden card it may pick
+    // (an expert target is skipped), or with forfeit it drops out of the round.
+    // Returns false when no game is being played.
+    bool timeOut(bool forfeit, TableUpdate& update);
+};
+
+#endif
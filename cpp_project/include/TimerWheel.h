@@ -0,0 +1,167 @@
+#ifndef TIMERWHEEL_H
+#define TIMERWHEEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Intrusive timer: embed one in the object it times. A node is in at most one
+// wheel at a time; destroying an armed node is a bug, cancel it first.
+struct TimerNode {
+    TimerNode* prev;
+    TimerNode* next;
+    uint64_t due; // ms, on the wheel's clock
+    int owner;    // for the expiry callback, e.g. a table index
+
+    TimerNode() : prev(nullptr), next(nullptr), due(0), owner(-1) {}
+    bool isArmed() const { return prev != nullptr; }
+};
+
+// Hierarchical timer wheel: kLevels wheels of kSlots lists, a slot of level k
+// spanning kSlots^k ticks of tickMs. A node goes to the lowest level that
+// reaches its due tick and moves down a level each time the wheel above turns
+// to its slot, so it is touched at most kLevels times before it fires, however
+// many timers are pending. schedule() and cancel() are O(1); advance() jumps
+// over empty slots with a bitmap per level. Deadlines beyond the top level
+// (kSlots^kLevels ticks) wait there and are placed again as it turns.
+// Owned by one thread (a server shard).
+class TimerWheel {
+public:
+    static const int kLevelBits = 6;
+    static const int kLevels = 5;
+    static const uint64_t kSlots = 1 << kLevelBits;
+
+private:
+    std::vector<TimerNode> slots; // [level * kSlots + index], circular lists around sentinels
+    uint64_t occupied[kLevels];   // bit per slot, may be stale after cancel()
+    uint64_t tickMs;
+    uint64_t current; // next tick to process
+    size_t count;
+
+    static void link(TimerNode& head, TimerNode& node) {
+        node.prev = head.prev;
+        node.next = &head;
+        head.prev->next = &node;
+        head.prev = &node;
+    }
+    static void unlink(TimerNode& node) {
+        node.prev->next = node.next;
+        node.next->prev = node.prev;
+        node.prev = node.next = nullptr;
+    }
+    // Moves every node of other to the end of head
+    static void splice(TimerNode& head, TimerNode& other) {
+        if (other.next == &other) return;
+        other.next->prev = head.prev;
+        head.prev->next = other.next;
+        other.prev->next = &head;
+        head.prev = other.prev;
+        other.prev = other.next = &other;
+    }
+
+    void place(TimerNode& node) {
+        uint64_t tick = (node.due + tickMs - 1) / tickMs; // first tick at or after the deadline
+        if (tick < current) tick = current;
+        uint64_t delta = tick - current;
+        int level = 0;
+        while (level < kLevels - 1 && delta >= (1ull << (kLevelBits * (level + 1)))) ++level;
+        if (level == kLevels - 1 && delta >= (1ull << (kLevelBits * kLevels))) {
+            tick = current + (1ull << (kLevelBits * kLevels)) - 1; // the last slot to come round
+        }
+        uint64_t index = (tick >> (kLevelBits * level)) & (kSlots - 1);
+        link(slots[level * kSlots + index], node);
+        occupied[level] |= 1ull << index;
+    }
+
+    // The wheel above level 0 turned at tick current: its slot's nodes move down
+    void cascade() {
+        for (int level = 1; level < kLevels; ++level) {
+            uint64_t index = (current >> (kLevelBits * level)) & (kSlots - 1);
+            TimerNode moving;
+            moving.prev = moving.next = &moving;
+            splice(moving, slots[level * kSlots + index]);
+            occupied[level] &= ~(1ull << index);
+            while (moving.next != &moving) {
+                TimerNode& node = *moving.next;
+                unlink(node);
+                place(node);
+            }
+            if (index != 0) break; // the next level only turns when this one wraps
+        }
+    }
+
+public:
+    TimerWheel(uint64_t nowMs, uint64_t tickMs)
+        : slots(kLevels * kSlots), occupied(), tickMs(tickMs), current(nowMs / tickMs), count(0) {
+        for (TimerNode& head : slots) head.prev = head.next = &head;
+    }
+    TimerWheel(const TimerWheel&) = delete;
+    TimerWheel& operator=(const TimerWheel&) = delete;
+
+    size_t size() const { return count; }
+
+    // (Re)arms node for dueMs; times in the past fire on the next advance()
+    void schedule(TimerNode& node, uint64_t dueMs) {
+        cancel(node);
+        node.due = dueMs;
+        place(node);
+        ++count;
+    }
+
+    void cancel(TimerNode& node) {
+        if (!node.isArmed()) return;
+        unlink(node);
+        --count;
+    }
+
+    // Calls expire(TimerNode&) for every node due by nowMs. The callback may
+    // schedule or cancel any node, including the one it was given.
+    template <typename Fn>
+    void advance(uint64_t nowMs, Fn expire) {
+        uint64_t last = nowMs / tickMs;
+        if (last < current) return;
+        TimerNode expired;
+        expired.prev = expired.next = &expired;
+        while (current <= last) {
+            if (count == 0) {
+                current = last + 1;
+                break;
+            }
+            uint64_t index = current & (kSlots - 1);
+            if (index == 0) cascade();
+            // Next slot of this turn holding nodes; none: skip to the turn's end
+            uint64_t ahead = occupied[0] >> index;
+            if (ahead == 0) {
+                current = (current | (kSlots - 1)) + 1;
+                continue;
+            }
+            current += static_cast<uint64_t>(__builtin_ctzll(ahead));
+            if (current > last) break;
+            index = current & (kSlots - 1);
+            splice(expired, slots[index]);
+            occupied[0] &= ~(1ull << index);
+            ++current;
+        }
+        if (current > last + 1) current = last + 1;
+        while (expired.next != &expired) {
+            TimerNode& node = *expired.next;
+            unlink(node);
+            --count;
+            expire(node);
+        }
+    }
+
+    // Milliseconds until advance() has work to do, -1 when nothing is armed
+    int untilNextTick(uint64_t nowMs) const {
+        if (count == 0) return -1;
+        uint64_t index = current & (kSlots - 1);
+        uint64_t ahead = index == 0 ? 0 : occupied[0] >> index;
+        // A slot of this turn, or else the next turn, which may bring nodes down
+        uint64_t tick = ahead != 0 ? current + static_cast<uint64_t>(__builtin_ctzll(ahead))
+                                   : (index == 0 ? current : (current | (kSlots - 1)) + 1);
+        uint64_t at = tick * tickMs;
+        return at > nowMs ? static_cast<int>(at - nowMs) : 0;
+    }
+};
+
+#endif
@@ -0,0 +1,118 @@
+#ifndef TRACER_H
+#define TRACER_H
+
+#include <atomic>
+#include <cstdint>
+#include <string>
+
+// Optional timeline tracer, compiled in only with -DMEMO_TRACE.
+// Begin/end events go to a fixed-size buffer owned by the recording thread
+// (single writer, no locks); Tracer::write() exports them as Chrome
+// trace-event JSON for chrome://tracing or Perfetto. Tracer::start() only bumps
+// an epoch: each thread empties its own buffer at its next event.
+//   Tracer::start();
+//   { MEMO_TRACE_SCOPE("pick"); ... }
+//   Tracer::write("game.trace.json");
+
+struct TraceEvent {
+    const char* name; // string literal, never copied
+    uint64_t timestampNs;
+    char phase;       // 'B' or 'E'
+};
+
+class TraceBuffer {
+private:
+    static const size_t kCapacity = 1 << 16;
+    TraceEvent events[kCapacity];
+    std::atomic<size_t> size;
+    std::atomic<uint64_t> dropped;
+    std::atomic<uint32_t> epoch; // Tracer::start() the events belong to
+    size_t open;                 // begun scopes still to end: their 'E' slots are kept free
+    int threadId;
+
+    void append(const char* name, char phase, uint64_t timestampNs) {
+        size_t n = size.load(std::memory_order_relaxed);
+        events[n] = {name, timestampNs, phase};
+        size.store(n + 1, std::memory_order_release); // publishes the event to write()
+    }
+
+public:
+    explicit TraceBuffer(int threadId) : size(0), dropped(0), epoch(0), open(0), threadId(threadId) {}
+
+    // Owning thread only. False (and counted as dropped) when the buffer has
+    // no room for this scope's begin and end on top of the open scopes' ends.
+    bool begin(const char* name, uint64_t timestampNs, uint32_t current) {
+        if (epoch.load(std::memory_order_relaxed) != current) {
+            // Tracer::start() since the last event: start over
+            size.store(0, std::memory_order_relaxed);
+            dropped.store(0, std::memory_order_relaxed);
+            open = 0;
+            epoch.store(current, std::memory_order_release);
+        }
+        if (size.load(std::memory_order_relaxed) + open + 2 > kCapacity) {
+            dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return false;
+        }
+        append(name, 'B', timestampNs);
+        ++open;
+        return true;
+    }
+    // Owning thread only: ends a scope begin() accepted in epoch scopeEpoch
+    void end(const char* name, uint64_t timestampNs, uint32_t scopeEpoch) {
+        if (epoch.load(std::memory_order_relaxed) != scopeEpoch) return; // its begin was cleared
+        append(name, 'E', timestampNs);
+        --open;
+    }
+
+    size_t getSize() const { return size.load(std::memory_order_acquire); }
+    const TraceEvent& get(size_t i) const { return events[i]; }
+    uint64_t getDropped() const { return dropped.load(std::memory_order_relaxed); }
+    uint32_t getEpoch() const { return epoch.load(std::memory_order_acquire); }
+    int getThreadId() const { return threadId; }
+};
+
+class Tracer {
+private:
+    static std::atomic<bool> enabled;
+    static std::atomic<uint32_t> epoch;
+    static TraceBuffer& local();
+
+public:
+    static void start(); // drops earlier events and starts recording
+    static void stop();
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+    static uint32_t getEpoch() { return epoch.load(std::memory_order_acquire); }
+    static uint64_t now();
+    static bool begin(const char* name, uint32_t current) { return local().begin(name, now(), current); }
+    static void end(const char* name, uint32_t scopeEpoch) { local().end(name, now(), scopeEpoch); }
+    // Writes all threads' events; returns false if the file cannot be written
+    static bool write(const std::string& path);
+};
+
+class TraceScope {
+private:
+    const char* name; // null when nothing was recorded
+    uint32_t epoch;
+
+public:
+    explicit TraceScope(const char* name) : name(nullptr), epoch(0) {
+        if (!Tracer::isEnabled()) return;
+        epoch = Tracer::getEpoch();
+        if (Tracer::begin(name, epoch)) this->name = name;
+    }
+    ~TraceScope() {
+        if (name) Tracer::end(name, epoch);
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+};
+
+#ifdef MEMO_TRACE
+#define MEMO_TRACE_CONCAT_INNER(a, b) a##b
+#define MEMO_TRACE_CONCAT(a, b) MEMO_TRACE_CONCAT_INNER(a, b)
+#define MEMO_TRACE_SCOPE(name) TraceScope MEMO_TRACE_CONCAT(memoTrace, __LINE__)(name)
+#else
+#define MEMO_TRACE_SCOPE(name) ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,187 @@
+#ifndef WIRE_H
+#define WIRE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// Binary protocol of the game server. Every message is one kWireFrameSize frame
+// whose first byte is its WireType; multi-byte fields are little-endian and
+// unused bytes are zero. A connection whose first byte is a WireType speaks this
+// protocol, any other byte selects the text protocol of GameServer.h.
+// encode() and decode() only touch the caller's buffers.
+
+const size_t kWireFrameSize = 16;
+const uint8_t kWireNone = 0xFF;
+const int kWireNameLength = 8;
+const int kWireSightCards = 3;
+const int kWireMaxSeats = 8;
+
+enum class WireType : uint8_t {
+    // client to server
+    Create = 1, Join, Pick, Target, Queue, Watch,
+    // server to client
+    TableId = 16, Seat, Start, Sight, Delta, Over, Reject, Queued, Board, Cards
+};
+
+enum class WireError : uint8_t {
+    None, BadRequest, BadTable, NoTable, TableFull, AlreadySeated, NotPlaying, NotYourTurn, Hole, Blocked, FaceUp,
+    Closed,   // a seat left the table before the end
+    QueueFull // matchmaking has no room for another waiting client
+};
+
+// WireDelta::flags
+const uint8_t kDeltaFaceUp = 1;          // position is face up after the action
+const uint8_t kDeltaTarget = 2;          // the action was an expert target
+const uint8_t kDeltaApplied = 4;         // that target took effect
+const uint8_t kDeltaEliminated = 8;      // the acting seat is out of the round
+const uint8_t kDeltaAwaitingTarget = 16; // the acting seat must now send a Target
+const uint8_t kDeltaRoundOver = 32;
+const uint8_t kDeltaGameOver = 64;
+const uint8_t kDeltaTimeout = 128;       // the acting seat ran out of time and the server played for it
+
+struct WireCreate {
+    uint8_t mode;  // 0 base, 1 expert display, 2 expert rules
+    uint8_t seats;
+};
+
+struct WireJoin {
+    uint32_t table;
+    char name[kWireNameLength]; // zero padded, not terminated when full
+};
+
+// Waits for a table of that size and mode; answered by Queued, then a Seat once it forms
+struct WireQueue {
+    uint8_t mode;
+    uint8_t seats;
+    char name[kWireNameLength];
+};
+
+// Follows a table as a spectator: answered by Board and two Cards, then the
+// table's Start, Delta, Over and Reject frames as its seats get them
+struct WireWatch {
+    uint32_t table;
+};
+
+// Pick, or the expert target after a Delta with kDeltaAwaitingTarget
+struct WireMove {
+    bool target;
+    uint8_t seat;
+    uint8_t position; // row*5+col
+};
+
+struct WireTableId {
+    uint32_t table;
+};
+
+struct WireSeat {
+    uint32_t table;
+    uint8_t seat;
+};
+
+struct WireStart {
+    uint8_t mode;
+    uint8_t seats;
+};
+
+struct WireQueued {
+    uint8_t mode;
+    uint8_t seats;
+};
+
+// Sent to each seat alone when a round starts
+struct WireSight {
+    uint8_t round;
+    uint8_t turn;
+    uint8_t positions[kWireSightCards];
+    uint8_t cards[kWireSightCards];
+};
+
+// Outcome of one pick or target, the same frame for every seat
+struct WireDelta {
+    uint8_t seat;        // seat that acted
+    uint8_t position;    // picked or targeted position, kWireNone when the seat forfeited the round
+    uint8_t card;        // card at position if face up, kWireNone otherwise
+    uint8_t flags;       // kDelta* bits
+    uint8_t effect;      // ExpertEffect of the pick
+    uint8_t activeSeats; // seats still in the round after the action
+    uint8_t turn;        // seat to move next
+    uint8_t skipped;     // seat skipped by Turtle, kWireNone
+    uint8_t winner;      // seat awarded a rubis, kWireNone
+    uint8_t award;       // value of that rubis
+    uint8_t round;       // round the action was played in
+    uint32_t faceUpMask; // board after the action, bit row*5+col
+};
+
+struct WireOver {
+    uint8_t seats;
+    uint8_t rubies[kWireMaxSeats];
+};
+
+struct WireReject {
+    WireError error;
+};
+
+// What a spectator sees of a table, sent when it starts watching and again
+// whenever it fell too far behind the table's moves to catch up with them
+struct WireBoard {
+    uint32_t table;
+    uint8_t mode;
+    uint8_t seats;
+    uint8_t round;       // 0 while the table waits for its players
+    uint8_t turn;
+    uint8_t activeSeats;
+    uint32_t faceUpMask;
+};
+
+// The face-up cards of a Board: two frames, positions 0-11 then 13-24
+const int kWireBoardCards = 12;
+struct WireCards {
+    uint8_t first;                 // position of cards[0]
+    uint8_t cards[kWireBoardCards]; // kWireNone when face down
+};
+
+inline WireType wireType(const uint8_t* frame) {
+    return static_cast<WireType>(frame[0]);
+}
+
+// A byte a text client would never start with
+inline bool isWireType(uint8_t byte) {
+    return (byte >= static_cast<uint8_t>(WireType::Create) && byte <= static_cast<uint8_t>(WireType::Watch)) ||
+           (byte >= static_cast<uint8_t>(WireType::TableId) && byte <= static_cast<uint8_t>(WireType::Cards));
+}
+
+// Each encode() writes exactly kWireFrameSize bytes; decode() returns false
+// when the frame holds another type or out of range fields
+void encode(const WireCreate& message, uint8_t* frame);
+void encode(const WireJoin& message, uint8_t* frame);
+void encode(const WireQueue& message, uint8_t* frame);
+void encode(const WireMove& message, uint8_t* frame);
+void encode(const WireTableId& message, uint8_t* frame);
+void encode(const WireSeat& message, uint8_t* frame);
+void encode(const WireStart& message, uint8_t* frame);
+void encode(const WireSight& message, uint8_t* frame);
+void encode(const WireDelta& message, uint8_t* frame);
+void encode(const WireOver& message, uint8_t* frame);
+void encode(const WireReject& message, uint8_t* frame);
+void encode(const WireQueued& message, uint8_t* frame);
+void encode(const WireWatch& message, uint8_t* frame);
+void encode(const WireBoard& message, uint8_t* frame);
+void encode(const WireCards& message, uint8_t* frame);
+
+bool decode(const uint8_t* frame, WireCreate& message);
+bool decode(const uint8_t* frame, WireJoin& message);
+bool decode(const uint8_t* frame, WireQueue& message);
+bool decode(const uint8_t* frame, WireMove& message);
+bool decode(const uint8_t* frame, WireTableId& message);
+bool decode(const uint8_t* frame, WireSeat& message);
+bool decode(const uint8_t* frame, WireStart& message);
+bool decode(const uint8_t* frame, WireSight& message);
+bool decode(const uint8_t* frame, WireDelta& message);
+bool decode(const uint8_t* frame, WireOver& message);
+bool decode(const uint8_t* frame, WireReject& message);
+bool decode(const uint8_t* frame, WireQueued& message);
+bool decode(const uint8_t* frame, WireWatch& message);
+bool decode(const uint8_t* frame, WireBoard& message);
+bool decode(const uint8_t* frame, WireCards& message);
+
+#endif
@@ -0,0 +1,45 @@
+#ifndef MEMOARR_ENV_H
+#define MEMOARR_ENV_H
+
+/* Plain C interface to BatchEnv: many base Memoarr games stepped in lockstep.
+ * Build as a shared library:
+ *   g++ -std=c++17 -O2 -fPIC -shared -Iinclude src/memoarr_env.cpp src/BatchEnv.cpp -o libmemoarr_env.so
+ * Positions are row * 5 + col, cards animal * 5 + background, 0xFF for none.
+ * Arrays are caller owned and laid out game-major. */
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct memoarr_env memoarr_env;
+
+/* NULL on bad sizes (n_players 2..8) or allocation failure */
+memoarr_env* memoarr_env_create(int n_games, int n_players, uint64_t seed);
+void memoarr_env_destroy(memoarr_env* env);
+
+int memoarr_env_games(const memoarr_env* env);
+int memoarr_env_players(const memoarr_env* env);
+
+void memoarr_env_reset(memoarr_env* env);
+void memoarr_env_reset_done(memoarr_env* env);
+
+/* actions[n_games]; rewards[n_games * n_players] rubis won this step; dones[n_games] */
+void memoarr_env_step(memoarr_env* env, const uint8_t* actions, float* rewards, uint8_t* dones);
+
+/* cards[n_games * 25]: cards visible to the player to move, 0xFF if hidden */
+void memoarr_env_observe(const memoarr_env* env, uint8_t* cards);
+
+/* Read-only views of the state arrays, valid until the next call on env */
+const uint32_t* memoarr_env_face_up(const memoarr_env* env);    /* [n_games] position masks */
+const uint8_t* memoarr_env_current_card(const memoarr_env* env); /* [n_games] */
+const uint8_t* memoarr_env_active(const memoarr_env* env);       /* [n_games] player masks */
+const uint8_t* memoarr_env_turn(const memoarr_env* env);         /* [n_games] player to move */
+const uint8_t* memoarr_env_rubies(const memoarr_env* env);       /* [n_games * n_players] */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,146 @@
+#include "BatchEnv.h"
+#include "Game.h"
+#include "Rules.h"
+#include "Sight.h"
+#include <algorithm>
+#include <bitset>
+#include <stdexcept>
+
+static const int kHole = StandardGeometry::kFirstHole;
+static const int kCardIds = StandardGeometry::kKinds * StandardGeometry::kKinds;
+static const uint8_t kRubisValues[BatchEnv::kRubis] = {1, 1, 1, 2, 2, 3, 4};
+
+static uint64_t splitmix(uint64_t& state) {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+}
+
+template <typename T>
+static void shuffle(T* values, int count, uint64_t& state) {
+    for (int i = count - 1; i > 0; --i) std::swap(values[i], values[splitmix(state) % (i + 1)]);
+}
+
+BatchEnv::BatchEnv(int nGames, int nSeats, uint64_t seed)
+    : nGames(nGames), nSeats(nSeats) {
+    if (nGames <= 0 || nSeats < 2 || nSeats > Game::kMaxSeats) throw std::invalid_argument("Bad environment size");
+
+    size_t n = static_cast<size_t>(nGames);
+    layout.resize(n * kCells);
+    faceUp.resize(n);
+    current.resize(n);
+    active.resize(n);
+    turn.resize(n);
+    round.resize(n);
+    rubisNext.resize(n);
+    rubis.resize(n * kRubis);
+    rubies.resize(n * nSeats);
+    done.resize(n);
+    rng.resize(n);
+    roundOver.resize(n);
+    for (size_t g = 0; g < n; ++g) rng[g] = seed ^ (g * 0xD1B54A32D192ED03ull);
+    reset();
+}
+
+void BatchEnv::startRound(int g) {
+    faceUp[g] = 0;
+    current[g] = kNone;
+    active[g] = static_cast<uint8_t>((1u << nSeats) - 1);
+    turn[g] = 0;
+}
+
+void BatchEnv::resetGame(int g) {
+    uint8_t ids[kCardIds];
+    for (int i = 0; i < kCardIds; ++i) ids[i] = static_cast<uint8_t>(i);
+    shuffle(ids, kCardIds, rng[g]);
+    uint8_t values[kRubis];
+    std::copy(kRubisValues, kRubisValues + kRubis, values);
+    shuffle(values, kRubis, rng[g]);
+    setDeal(g, ids, values);
+}
+
+void BatchEnv::setDeal(int g, const uint8_t* layoutIds, const uint8_t* rubisValues) {
+    // Cards are dealt in row order around the hole, as Board does
+    uint8_t* cells = &layout[static_cast<size_t>(g) * kCells];
+    for (int pos = 0, next = 0; pos < kCells; ++pos) {
+        bool hole = StandardGeometry::isHole(StandardGeometry::rowOf(pos), StandardGeometry::colOf(pos));
+        cells[pos] = hole ? kNone : layoutIds[next++];
+    }
+    std::copy(rubisValues, rubisValues + kRubis, &rubis[static_cast<size_t>(g) * kRubis]);
+    std::fill_n(&rubies[static_cast<size_t>(g) * nSeats], nSeats, 0);
+    rubisNext[g] = 0;
+    round[g] = 1;
+    done[g] = 0;
+    startRound(g);
+}
+
+void BatchEnv::reset() {
+    for (int g = 0; g < nGames; ++g) resetGame(g);
+}
+
+void BatchEnv::resetDone() {
+    for (int g = 0; g < nGames; ++g) {
+        if (done[g]) resetGame(g);
+    }
+}
+
+void BatchEnv::step(const uint8_t* actions, float* rewards, uint8_t* dones) {
+    std::fill_n(rewards, static_cast<size_t>(nGames) * nSeats, 0.0f);
+
+    // Reveal, match, eliminate and rotate: the same instructions for every game,
+    // illegal picks select the old state instead of branching
+    for (int g = 0; g < nGames; ++g) {
+        int pos = actions[g] < kCells ? actions[g] : kHole;
+        uint32_t bit = 1u << pos;
+        bool legal = !done[g] && (StandardGeometry::kCellMask & ~faceUp[g] & bit);
+        uint8_t card = layout[static_cast<size_t>(g) * kCells + pos];
+        uint8_t previous = current[g];
+        bool matched = previous == kNone || Rules::idsMatch(previous, card);
+
+        faceUp[g] |= legal ? bit : 0u;
+        current[g] = legal ? card : previous;
+        uint8_t mover = static_cast<uint8_t>(1u << turn[g]);
+        active[g] &= (legal && !matched) ? static_cast<uint8_t>(~mover) : static_cast<uint8_t>(0xFF);
+
+        uint8_t live = active[g];
+        int after = turn[g] + 1;
+        int next = kLowestSeat[(live >> after << after) & 0xFF];
+        next = next >= 0 ? next : kLowestSeat[live];
+        turn[g] = (legal && next >= 0) ? static_cast<uint8_t>(next) : turn[g];
+        roundOver[g] = legal && Rules::roundEnds(static_cast<int>(std::bitset<8>(live).count()), faceUp[g]);
+    }
+
+    // Round ends are rare, so this pass may branch
+    for (int g = 0; g < nGames; ++g) {
+        if (!roundOver[g]) continue;
+        int winner = kLowestSeat[active[g]];
+        if (winner >= 0 && rubisNext[g] < kRubis) {
+            uint8_t value = rubis[static_cast<size_t>(g) * kRubis + rubisNext[g]++];
+            rubies[static_cast<size_t>(g) * nSeats + winner] += value;
+            rewards[static_cast<size_t>(g) * nSeats + winner] = value;
+        }
+        if (round[g] >= Rules::kRounds) {
+            done[g] = 1;
+        } else {
+            ++round[g];
+            startRound(g);
+        }
+    }
+    std::copy(done.begin(), done.end(), dones);
+}
+
+void BatchEnv::observe(uint8_t* cards) const {
+    static constexpr uint32_t kSeatSight[Game::kMaxSeats] = {
+        sightMask(Side::top), sightMask(Side::bottom), sightMask(Side::left), sightMask(Side::right),
+        sightMask(Side::topLeft), sightMask(Side::topRight), sightMask(Side::bottomRight), sightMask(Side::bottomLeft)};
+
+    for (int g = 0; g < nGames; ++g) {
+        uint32_t visible = faceUp[g] | kSeatSight[turn[g]];
+        const uint8_t* cells = &layout[static_cast<size_t>(g) * kCells];
+        uint8_t* out = cards + static_cast<size_t>(g) * kCells;
+        for (int pos = 0; pos < kCells; ++pos) {
+            out[pos] = (visible >> pos) & 1 ? cells[pos] : kNone;
+        }
+    }
+}
@@ -3,117 +3,89 @@
 #include <stdexcept>
 #include <algorithm>
 
-Board::Board(CardDeck& deck) : grid(5, std::vector<Card*>(5, nullptr)), faceUp(5, std::vector<bool>(5, false)) {
-    for (int i = 0; i < 5; ++i) {
-        for (int j = 0; j < 5; ++j) {
-            if (i == 2 && j == 2) continue; 
+template <typename G>
+BasicBoard<G>::BasicBoard(CardDeck& deck) : faceUp(0) {
+    // Card ids and matches are relative to the deck's kinds (CardDeck::make_CardDeck(G::kKinds))
+    if (deck.getKinds() != G::kKinds) throw std::invalid_argument("Board: deck does not fit the geometry");
+    for (int i = 0; i < G::kRows; ++i) {
+        for (int j = 0; j < G::kCols; ++j) {
+            if (G::isHole(i, j)) {
+                grid[G::index(i, j)] = nullptr;
+                continue;
+            }
             Card* card = deck.getNext();
             if (!card) throw NoMoreCards("Not enough cards in deck");
-            grid[i][j] = card;
+            grid[G::index(i, j)] = card;
         }
     }
 }
 
-Board::~Board() {
-    for (auto& row : grid) {
-        for (auto card : row) {
-            delete card;
-        }
-    }
+// Cards are owned by the CardDeck, the board only references them
+template <typename G>
+BasicBoard<G>::BasicBoard() : faceUp(0) {
+    grid.fill(nullptr);
 }
 
-int Board::letterToIndex(Letter l) const {
-    switch (l) {
-        case Letter::A: return 0;
-        case Letter::B: return 1;
-        case Letter::C: return 2;
-        case Letter::D: return 3;
-        case Letter::E: return 4;
-        default: throw OutOfRange("Invalid letter");
-    }
-}
-
-int Board::numberToIndex(Number n) const {
-    switch (n) {
-        case Number::One: return 0;
-        case Number::Two: return 1;
-        case Number::Three: return 2;
-        case Number::Four: return 3;
-        case Number::Five: return 4;
-        default: throw OutOfRange("Invalid number");
-    }
-}
-
-bool Board::isValidPosition(Letter l, Number n) const {
-    int i = letterToIndex(l);
-    int j = numberToIndex(n);
-    return !(i == 2 && j == 2);
-}
-
-bool Board::isFaceUp(const Letter& l, const Number& n) const {
+template <typename G>
+bool BasicBoard<G>::isFaceUp(const Letter& l, const Number& n) const {
     if (!isValidPosition(l, n)) throw OutOfRange("Invalid position");
-    int i = letterToIndex(l);
-    int j = numberToIndex(n);
-    return faceUp[i][j];
+    return faceUp & G::bit(static_cast<int>(l), static_cast<int>(n));
 }
 
-bool Board::turnFaceUp(const Letter& l, const Number& n) {
+template <typename G>
+bool BasicBoard<G>::turnFaceUp(const Letter& l, const Number& n) {
     if (!isValidPosition(l, n)) throw OutOfRange("Invalid position");
-    int i = letterToIndex(l);
-    int j = numberToIndex(n);
-    bool wasUp = faceUp[i][j];
-    faceUp[i][j] = true;
+    Mask bit = G::bit(static_cast<int>(l), static_cast<int>(n));
+    bool wasUp = faceUp & bit;
+    faceUp |= bit;
     return !wasUp;
 }
 
-bool Board::turnFaceDown(const Letter& l, const Number& n) {
+template <typename G>
+bool BasicBoard<G>::turnFaceDown(const Letter& l, const Number& n) {
     if (!isValidPosition(l, n)) throw OutOfRange("Invalid position");
-    int i = letterToIndex(l);
-    int j = numberToIndex(n);
-    bool wasDown = !faceUp[i][j];
-    faceUp[i][j] = false;
+    Mask bit = G::bit(static_cast<int>(l), static_cast<int>(n));
+    bool wasDown = !(faceUp & bit);
+    faceUp &= ~bit;
     return wasDown;
 }
 
-Card* Board::getCard(const Letter& l, const Number& n) const {
+template <typename G>
+Card* BasicBoard<G>::getCard(const Letter& l, const Number& n) const {
     if (!isValidPosition(l, n)) throw OutOfRange("Invalid position");
-    int i = letterToIndex(l);
-    int j = numberToIndex(n);
-    return grid[i][j];
+    return grid[G::index(static_cast<int>(l), static_cast<int>(n))];
 }
 
-void Board::setCard(const Letter& l, const Number& n, Card* card) {
+template <typename G>
+void BasicBoard<G>::setCard(const Letter& l, const Number& n, Card* card) {
     if (!isValidPosition(l, n)) throw OutOfRange("Invalid position");
-    int i = letterToIndex(l);
-    int j = numberToIndex(n);
-    grid[i][j] = card;
+    grid[G::index(static_cast<int>(l), static_cast<int>(n))] = card;
 }
 
-void Board::swapCards(const Letter& l1, const Number& n1, const Letter& l2, const Number& n2) {
+template <typename G>
+void BasicBoard<G>::swapCards(const Letter& l1, const Number& n1, const Letter& l2, const Number& n2) {
     if (!isValidPosition(l1, n1) || !isValidPosition(l2, n2)) 
         throw OutOfRange("Invalid position");
     
-    int r1 = letterToIndex(l1);
-    int c1 = numberToIndex(n1);
-    int r2 = letterToIndex(l2);
-    int c2 = numberToIndex(n2);
+    int p1 = G::index(static_cast<int>(l1), static_cast<int>(n1));
+    int p2 = G::index(static_cast<int>(l2), static_cast<int>(n2));
 
-    std::swap(grid[r1][c1], grid[r2][c2]);
+    std::swap(grid[p1], grid[p2]);
     
-    bool temp = faceUp[r1][c1];
-    faceUp[r1][c1] = faceUp[r2][c2];
-    faceUp[r2][c2] = temp;
+    Mask bit1 = Mask(1) << p1;
+    Mask bit2 = Mask(1) << p2;
+    if (!(faceUp & bit1) != !(faceUp & bit2)) faceUp ^= bit1 | bit2;
 }
 
-void Board::allFacesDown() {
-    for (auto& row : faceUp) {
-        std::fill(row.begin(), row.end(), false);
-    }
+template <typename G>
+void BasicBoard<G>::allFacesDown() {
+    faceUp = 0;
 }
 
-std::ostream& operator<<(std::ostream& os, const Board& board) {
-    // Print 19x19 grid with row letters on left
-    for (int row = 0; row < 19; ++row) {
+template <typename G>
+void BasicBoard<G>::print(std::ostream& os) const {
+    // Print the card grid with row letters on left
+    for (int row = 0; row < G::kRenderRows; ++row) {
         // Print row letter for middle line of each card row
         if (row % 4 == 1) {
             int cardRow = row / 4;
@@ -122,19 +94,19 @@ std::ostream& operator<<(std::ostream& os, const Board& board) {
             os << "  "; // Two spaces for alignment
         }
         
-        for (int col = 0; col < 19; ++col) {
+        for (int col = 0; col < G::kRenderCols; ++col) {
             int cardRow = row / 4;
             int cardCol = col / 4;
             int subRow = row % 4;
             int subCol = col % 4;
 
-            if (cardRow >= 5 || cardCol >= 5 || (cardRow == 2 && cardCol == 2)) {
+            if (G::isHole(cardRow, cardCol)) {
                 os << ' ';
             } else if (subRow == 3 || subCol == 3) {
                 os << ' ';
             } else {
-                Card* card = board.grid[cardRow][cardCol];
-                if (card && board.faceUp[cardRow][cardCol]) {
+                Card* card = grid[G::index(cardRow, cardCol)];
+                if (card && (faceUp & G::bit(cardRow, cardCol))) {
                     os << (*card)(subRow)[subCol];
                 } else {
                     os << 'z';
@@ -144,6 +116,11 @@ std::ostream& operator<<(std::ostream& os, const Board& board) {
         os << '\n';
     }
     
-    os << "  1 2 3 4 5\n";
-    return os;
+    os << " ";
+    for (int col = 0; col < G::kCols; ++col) os << ' ' << (col + 1);
+    os << "\n";
 }
+
+template class BasicBoard<StandardGeometry>;
+template class BasicBoard<Geometry6x6>;
+template class BasicBoard<Geometry7x7>;
@@ -2,8 +2,9 @@
 #include "Enums.h"
 #include <stdexcept>
 
-Card::Card(FaceAnimal animal, FaceBackground background)
-    : animal(animal), background(background) {}
+Card::Card(FaceAnimal animal, FaceBackground background, int kinds)
+    : animal(animal), background(background),
+      id(static_cast<int>(animal) * kinds + static_cast<int>(background)) {}
 
 std::string Card::operator()(int row) const {
     if (row < 0 || row >= getNRows())
@@ -18,6 +19,8 @@ std::string Card::operator()(int row) const {
         case FaceBackground::Purple: fill = 'm'; break; // mauve in French
         case FaceBackground::Blue:   fill = 'b'; break;
         case FaceBackground::Yellow: fill = 'y'; break;
+        case FaceBackground::Orange: fill = 'o'; break;
+        case FaceBackground::Cyan:   fill = 'c'; break;
         default: fill = '?'; break;
     }
 
@@ -32,6 +35,8 @@ std::string Card::operator()(int row) const {
             case FaceAnimal::Octopus:  center = 'O'; break;
             case FaceAnimal::Turtle:   center = 'T'; break;
             case FaceAnimal::Walrus:   center = 'W'; break;
+            case FaceAnimal::Seal:     center = 'S'; break;
+            case FaceAnimal::Urchin:   center = 'U'; break;
             default:                   center = '?'; break;
         }
         result[1] = center;
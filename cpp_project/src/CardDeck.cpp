@@ -1,24 +1,32 @@
 #include "CardDeck.h"
 #include <algorithm>
+#include <stdexcept>
 
-CardDeck* CardDeck::instance = nullptr;
+thread_local CardDeck* CardDeck::instances[kFaceKinds + 1] = {};
 
-CardDeck::CardDeck() {
-    // Create all 25 combinations of animals and backgrounds
-    for (int a = 0; a < 5; ++a) {
-        for (int b = 0; b < 5; ++b) {
+CardDeck::CardDeck(int kinds) : kinds(kinds) {
+    // Create all kinds x kinds combinations of animals and backgrounds
+    for (int a = 0; a < kinds; ++a) {
+        for (int b = 0; b < kinds; ++b) {
             FaceAnimal animal = static_cast<FaceAnimal>(a);
             FaceBackground background = static_cast<FaceBackground>(b);
-            deck.push_back(new Card(animal, background));
+            deck.push_back(new Card(animal, background, kinds));
+            byId[deck.back()->getId()] = deck.back();
         }
     }
     // Shuffle the deck
     shuffle();
 }
 
-CardDeck& CardDeck::make_CardDeck() {
-    if (instance == nullptr) {
-        instance = new CardDeck();
+Card* CardDeck::getCard(int id) const {
+    return id >= 0 && id < kinds * kinds ? byId[id] : nullptr;
+}
+
+CardDeck& CardDeck::make_CardDeck(int kinds) {
+    if (kinds < 1 || kinds > kFaceKinds)
+        throw std::invalid_argument("CardDeck: kinds out of range");
+    if (instances[kinds] == nullptr) {
+        instances[kinds] = new CardDeck(kinds);
     }
-    return *instance;
+    return *instances[kinds];
 }
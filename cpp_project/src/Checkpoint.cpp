@@ -0,0 +1,133 @@
+#include "Checkpoint.h"
+#include "Exceptions.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char kCheckpointMagic[8] = {'M', 'E', 'M', 'O', 'C', 'K', 'P', '\0'};
+static const uint32_t kCheckpointVersion = 1;
+
+static_assert(sizeof(CheckpointHeader) == 64, "CheckpointHeader must stay 64 bytes");
+static_assert(sizeof(CheckpointEntry) == 320, "CheckpointEntry must stay 320 bytes");
+
+// A rename is only durable once its directory is synced
+static bool syncDirectory(const std::string& path) {
+    size_t slash = path.rfind('/');
+    std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) return false;
+    int synced = ::fsync(fd);
+    ::close(fd);
+    return synced == 0;
+}
+
+// -------------------
+// Writer
+// -------------------
+CheckpointWriter::CheckpointWriter(const std::string& path, int shard, int shardCount, uint64_t start, uint64_t count)
+    : path(path), fd(-1), base(nullptr), length(sizeof(CheckpointHeader) + count * sizeof(CheckpointEntry)),
+      start(start), count(count), log(nullptr), status(0) {
+    std::string temporary = path + ".tmp";
+    fd = ::open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd < 0) throw ArchiveError("Cannot create checkpoint " + temporary);
+    void* p = MAP_FAILED;
+    if (::ftruncate(fd, static_cast<off_t>(length)) == 0) {
+        p = ::mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (p == MAP_FAILED) {
+        ::close(fd);
+        throw ArchiveError("Cannot map checkpoint " + temporary);
+    }
+    base = static_cast<uint8_t*>(p);
+
+    CheckpointHeader& h = *reinterpret_cast<CheckpointHeader*>(base);
+    std::memcpy(h.magic, kCheckpointMagic, sizeof(kCheckpointMagic));
+    h.version = kCheckpointVersion;
+    h.headerSize = sizeof(CheckpointHeader);
+    h.shard = static_cast<uint32_t>(shard);
+    h.shardCount = static_cast<uint32_t>(shardCount);
+    h.start = start;
+    h.count = count;
+    h.entrySize = sizeof(CheckpointEntry);
+}
+
+CheckpointWriter::~CheckpointWriter() {
+    if (syncer.joinable()) {
+        syncer.join();
+        return;
+    }
+    ::munmap(base, length);
+    ::close(fd);
+}
+
+void CheckpointWriter::finish(MoveLog& log) {
+    if (syncer.joinable()) return;
+    log.beginTruncate();
+    this->log = &log;
+    syncer = std::thread(&CheckpointWriter::sync, this);
+}
+
+// On the syncer thread: the poll thread no longer touches the mapping
+void CheckpointWriter::sync() {
+    std::string temporary = path + ".tmp";
+    bool synced = ::msync(base, length, MS_SYNC) == 0;
+    ::munmap(base, length);
+    synced = synced && ::fsync(fd) == 0;
+    ::close(fd);
+    synced = synced && ::rename(temporary.c_str(), path.c_str()) == 0 && syncDirectory(path);
+    if (synced) {
+        try {
+            log->copyTail();
+        } catch (const ArchiveError&) {
+            synced = false;
+        }
+    }
+    status.store(synced ? 1 : -1, std::memory_order_release);
+}
+
+bool CheckpointWriter::isDone() const {
+    int done = status.load(std::memory_order_acquire);
+    if (done < 0) throw ArchiveError("Failed to write checkpoint " + path + " or truncate its move log");
+    return done > 0;
+}
+
+// -------------------
+// Reader
+// -------------------
+Checkpoint::Checkpoint(const std::string& path, int shard, int shardCount)
+    : base(nullptr), length(0), header(nullptr) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) throw ArchiveError("Cannot open checkpoint " + path);
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(CheckpointHeader)) {
+        ::close(fd);
+        throw ArchiveError("Not a checkpoint: " + path);
+    }
+    length = static_cast<size_t>(st.st_size);
+    void* p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) throw ArchiveError("Cannot map checkpoint " + path);
+    base = static_cast<const uint8_t*>(p);
+    header = reinterpret_cast<const CheckpointHeader*>(base);
+    ::madvise(p, length, MADV_SEQUENTIAL);
+
+    const CheckpointHeader& h = *header;
+    if (std::memcmp(h.magic, kCheckpointMagic, sizeof(kCheckpointMagic)) != 0 || h.version != kCheckpointVersion ||
+        h.headerSize != sizeof(CheckpointHeader) || h.entrySize != sizeof(CheckpointEntry) ||
+        h.count > (length - sizeof(CheckpointHeader)) / sizeof(CheckpointEntry)) {
+        ::munmap(p, length);
+        throw ArchiveError("Not a checkpoint: " + path);
+    }
+    if (h.shard != static_cast<uint32_t>(shard) || h.shardCount != static_cast<uint32_t>(shardCount)) {
+        std::string owner = std::to_string(h.shard) + " of " + std::to_string(h.shardCount);
+        ::munmap(p, length);
+        throw ArchiveError("Checkpoint " + path + " was written by shard " + owner);
+    }
+}
+
+Checkpoint::~Checkpoint() {
+    ::munmap(const_cast<uint8_t*>(base), length);
+}
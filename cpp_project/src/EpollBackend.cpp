@@ -0,0 +1,248 @@
+#include "IoBackend.h"
+#include "Exceptions.h"
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <utility>
+#include <vector>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+class EpollBackend : public IoBackend {
+private:
+    struct Client {
+        bool open;
+        bool dropping;
+        bool writable; // watched for EPOLLOUT
+        bool held;     // sent to while holding, listed in heldClients
+        std::string out; // bytes the socket did not take yet
+
+        Client() : open(false), dropping(false), writable(false), held(false) {}
+    };
+
+    int listenFd;
+    int wakeFd;
+    int epollFd;
+    std::vector<Client> clients; // indexed by fd
+    std::vector<int> dropped;    // over kMaxPending, closed at the end of poll()
+    std::vector<std::pair<int, std::string>> detached; // reported at the end of poll()
+    bool holding;
+    std::vector<int> heldClients;
+
+    void acceptClients(IoEvents& events);
+    void flush(int fd);
+    void watch(int fd, bool writable);
+
+public:
+    EpollBackend(int listenFd, int wakeFd);
+    ~EpollBackend();
+
+    int poll(int timeoutMs, IoEvents& events) override;
+    void send(int client, const iovec* parts, int count) override;
+    size_t unsent(int client) const override;
+    void close(int client) override;
+    void detach(int client) override;
+    void adopt(int client, const std::string& unsent) override;
+    void hold() override { holding = true; }
+    void release() override;
+};
+
+EpollBackend::EpollBackend(int listenFd, int wakeFd)
+    : listenFd(listenFd), wakeFd(wakeFd), epollFd(epoll_create1(EPOLL_CLOEXEC)), holding(false) {
+    if (epollFd < 0) throw ServerError(std::string("epoll_create1: ") + std::strerror(errno));
+    for (int fd : {listenFd, wakeFd}) {
+        if (fd < 0) continue;
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            ::close(epollFd);
+            throw ServerError(std::string("epoll_ctl: ") + std::strerror(errno));
+        }
+    }
+}
+
+EpollBackend::~EpollBackend() {
+    for (size_t fd = 0; fd < clients.size(); ++fd) {
+        if (clients[fd].open) ::close(static_cast<int>(fd));
+    }
+    ::close(epollFd);
+}
+
+int EpollBackend::poll(int timeoutMs, IoEvents& events) {
+    epoll_event ready[256];
+    int n = epoll_wait(epollFd, ready, 256, timeoutMs);
+    if (n < 0) {
+        if (errno == EINTR) return 0;
+        throw ServerError(std::string("epoll_wait: ") + std::strerror(errno));
+    }
+
+    char buffer[4096];
+    for (int i = 0; i < n; ++i) {
+        int fd = ready[i].data.fd;
+        if (fd == listenFd) {
+            acceptClients(events);
+            continue;
+        }
+        if (fd == wakeFd) {
+            uint64_t count;
+            ssize_t got = ::read(wakeFd, &count, sizeof(count)); // resets the eventfd
+            (void)got;
+            events.onWake();
+            continue;
+        }
+        if (static_cast<size_t>(fd) >= clients.size() || !clients[fd].open) continue;
+        if (ready[i].events & (EPOLLHUP | EPOLLERR)) {
+            events.onClose(fd);
+            close(fd);
+            continue;
+        }
+        if ((ready[i].events & EPOLLOUT) && !clients[fd].held) flush(fd); // held bytes wait for release()
+        if (!(ready[i].events & EPOLLIN)) continue;
+
+        // One read per wakeup: a chatty client cannot starve the others
+        ssize_t got = ::recv(fd, buffer, sizeof(buffer), 0);
+        if (got > 0) {
+            events.onData(fd, buffer, static_cast<size_t>(got));
+        } else if (got == 0 || (errno != EAGAIN && errno != EINTR)) {
+            events.onClose(fd);
+            close(fd);
+        }
+    }
+
+    // A dropped client's table may queue "closed" for others, so the list can grow
+    for (size_t k = 0; k < dropped.size(); ++k) {
+        int fd = dropped[k];
+        if (!clients[fd].open) continue;
+        events.onClose(fd);
+        close(fd);
+    }
+    dropped.clear();
+    for (size_t k = 0; k < detached.size(); ++k) events.onDetach(detached[k].first, detached[k].second);
+    detached.clear();
+    return n;
+}
+
+void EpollBackend::acceptClients(IoEvents& events) {
+    while (true) {
+        int fd = ::accept4(listenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0) return; // EAGAIN, or out of descriptors until a client leaves
+
+        int yes = 1;
+        ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes)); // fails harmlessly on unix sockets
+        epoll_event event{};
+        event.events = EPOLLIN;
+        event.data.fd = fd;
+        if (epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event) < 0) {
+            ::close(fd);
+            continue;
+        }
+        if (clients.size() <= static_cast<size_t>(fd)) clients.resize(fd + 1);
+        clients[fd] = Client();
+        clients[fd].open = true;
+        events.onOpen(fd);
+    }
+}
+
+void EpollBackend::send(int fd, const iovec* parts, int count) {
+    Client& client = clients[fd];
+    if (!client.open) return;
+
+    // One gathered write when nothing is queued ahead (sendmsg is writev without SIGPIPE)
+    size_t sent = 0;
+    bool queued = !client.out.empty();
+    if (!queued && !holding) {
+        msghdr message{};
+        message.msg_iov = const_cast<iovec*>(parts);
+        message.msg_iovlen = static_cast<size_t>(count);
+        ssize_t n = ::sendmsg(fd, &message, MSG_NOSIGNAL);
+        if (n > 0) sent = static_cast<size_t>(n);
+    }
+    for (int k = 0; k < count; ++k) {
+        size_t skip = sent < parts[k].iov_len ? sent : parts[k].iov_len;
+        sent -= skip;
+        client.out.append(static_cast<const char*>(parts[k].iov_base) + skip, parts[k].iov_len - skip);
+    }
+
+    // A client that never reads is dropped instead of holding memory for its table
+    if (client.out.size() > kMaxPending && !client.dropping) {
+        client.dropping = true;
+        dropped.push_back(fd);
+    } else if (holding) {
+        if (!client.held) heldClients.push_back(fd);
+        client.held = true;
+    } else if (!queued && !client.out.empty()) {
+        watch(fd, true);
+    }
+}
+
+size_t EpollBackend::unsent(int fd) const {
+    return static_cast<size_t>(fd) < clients.size() ? clients[fd].out.size() : 0;
+}
+
+void EpollBackend::release() {
+    holding = false;
+    for (int fd : heldClients) {
+        Client& client = clients[fd];
+        client.held = false;
+        if (!client.open || client.dropping) continue;
+        flush(fd);
+        if (!client.out.empty()) watch(fd, true);
+    }
+    heldClients.clear();
+}
+
+void EpollBackend::flush(int fd) {
+    Client& client = clients[fd];
+    size_t sent = 0;
+    while (sent < client.out.size()) {
+        ssize_t n = ::send(fd, client.out.data() + sent, client.out.size() - sent, MSG_NOSIGNAL);
+        if (n <= 0) break;
+        sent += static_cast<size_t>(n);
+    }
+    client.out.erase(0, sent);
+    if (client.out.empty()) watch(fd, false);
+}
+
+void EpollBackend::watch(int fd, bool writable) {
+    if (clients[fd].writable == writable) return;
+    clients[fd].writable = writable;
+    epoll_event event{};
+    event.events = writable ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+    event.data.fd = fd;
+    epoll_ctl(epollFd, EPOLL_CTL_MOD, fd, &event);
+}
+
+void EpollBackend::detach(int fd) {
+    if (static_cast<size_t>(fd) >= clients.size() || !clients[fd].open) return;
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    detached.emplace_back(fd, std::move(clients[fd].out));
+    clients[fd] = Client();
+}
+
+void EpollBackend::adopt(int fd, const std::string& unsent) {
+    if (clients.size() <= static_cast<size_t>(fd)) clients.resize(fd + 1);
+    clients[fd] = Client();
+    clients[fd].open = true;
+    clients[fd].out = unsent;
+    clients[fd].writable = !unsent.empty();
+    epoll_event event{};
+    event.events = unsent.empty() ? EPOLLIN : (EPOLLIN | EPOLLOUT);
+    event.data.fd = fd;
+    epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+}
+
+void EpollBackend::close(int fd) {
+    if (static_cast<size_t>(fd) >= clients.size() || !clients[fd].open) return;
+    epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+    ::close(fd);
+    clients[fd] = Client();
+}
+
+std::unique_ptr<IoBackend> makeEpollBackend(int listenFd, int wakeFd) {
+    return std::unique_ptr<IoBackend>(new EpollBackend(listenFd, wakeFd));
+}
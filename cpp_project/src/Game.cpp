@@ -1,24 +1,52 @@
 #include "Game.h"
 #include "Card.h"
 #include "CardDeck.h"
+#include "Instrumentation.h"
+#include <bitset>
+#include <stdexcept>
+#include <tuple>
 
 Game::Game(CardDeck& deck, bool expertDisplay) 
     : board(deck), round(0), previousCard(nullptr), currentCard(nullptr), 
-      expertDisplay(expertDisplay), hasBlockedCard(false) {}
+      expertDisplay(expertDisplay), hasBlockedCard(false) {
+    clearSeats();
+}
+
+Game::Game(const GameSnapshot& snapshot, const CardDeck& cardDeck, RubisDeck& rubisDeck)
+    : round(0), previousCard(nullptr), currentCard(nullptr),
+      expertDisplay(false), hasBlockedCard(false) {
+    clearSeats();
+    snapshot.restore(*this, cardDeck, rubisDeck);
+}
+
+void Game::clearSeats() {
+    players.clear();
+    players.reserve(kMaxSeats);
+    activeSeats = 0;
+    for (int i = 0; i < kMaxSeats; ++i) {
+        seatOfSide[i] = -1;
+        sightMasks[i] = 0;
+    }
+}
 
 int Game::getRound() const {
     return round;
 }
 
 void Game::addPlayer(const Player& player) {
+    if (players.size() == static_cast<size_t>(kMaxSeats)) throw std::runtime_error("Too many players");
+    int seat = static_cast<int>(players.size());
+    int side = static_cast<int>(player.getSide());
     players.push_back(player);
+    if (player.isActive()) activeSeats |= 1u << seat;
+    if (seatOfSide[side] < 0) seatOfSide[side] = static_cast<int8_t>(seat);
+    sightMasks[seat] = sightMask(player.getSide());
 }
 
 Player& Game::getPlayer(Side side) {
-    for (auto& p : players) {
-        if (p.getSide() == side) return p;
-    }
-    throw std::runtime_error("Player not found");
+    int seat = seatOfSide[static_cast<int>(side)];
+    if (seat < 0) throw std::runtime_error("Player not found");
+    return players[seat];
 }
 
 const Card* Game::getPreviousCard() const {
@@ -51,6 +79,7 @@ void Game::nextRound() {
     for (auto& p : players) {
         p.setActive(true);
     }
+    activeSeats = static_cast<uint8_t>((1u << players.size()) - 1);
 }
 
 bool Game::isExpertDisplay() const {
@@ -70,21 +99,30 @@ const std::vector<Player>& Game::getPlayers() const {
 }
 
 void Game::setPlayerActive(Side side, bool active) {
-    for (auto& p : players) {
-        if (p.getSide() == side) {
-            p.setActive(active);
-            return;
-        }
-    }
+    int seat = seatOfSide[static_cast<int>(side)];
+    if (seat >= 0) setSeatActive(seat, active);
+}
+
+void Game::setSeatActive(int seat, bool active) {
+    players[seat].setActive(active);
+    if (active) activeSeats |= 1u << seat;
+    else activeSeats &= ~(1u << seat);
+}
+
+int Game::getActiveCount() const {
+    return static_cast<int>(std::bitset<kMaxSeats>(activeSeats).count());
+}
+
+int Game::nextActiveSeat(int from) const {
+    if (players.empty()) return -1;
+    from %= static_cast<int>(players.size());
+    int seat = kLowestSeat[(activeSeats >> from << from) & 0xFF];
+    return seat >= 0 ? seat : kLowestSeat[activeSeats];
 }
 
 void Game::addRubisToPlayer(Side side, const Rubis& rubis) {
-    for (auto& p : players) {
-        if (p.getSide() == side) {
-            p.addRubis(rubis);
-            return;
-        }
-    }
+    int seat = seatOfSide[static_cast<int>(side)];
+    if (seat >= 0) players[seat].addRubis(rubis);
 }
 
 void Game::setBlockedCard(Letter l, Number n) {
@@ -105,34 +143,8 @@ void Game::swapCards(Letter l1, Number n1, Letter l2, Number n2) {
     board.swapCards(l1, n1, l2, n2);
 }
 
-std::vector<std::pair<Letter, Number>> Game::getSightLocations(Side side) const {
-    std::vector<std::pair<Letter, Number>> locs;
-    switch (side) {
-        case Side::top:
-            locs.push_back({Letter::A, Number::Two});
-            locs.push_back({Letter::A, Number::Three});
-            locs.push_back({Letter::A, Number::Four});
-            break;
-        case Side::bottom:
-            locs.push_back({Letter::E, Number::Two});
-            locs.push_back({Letter::E, Number::Three});
-            locs.push_back({Letter::E, Number::Four});
-            break;
-        case Side::left:
-            locs.push_back({Letter::B, Number::One});
-            locs.push_back({Letter::C, Number::One});
-            locs.push_back({Letter::D, Number::One});
-            break;
-        case Side::right:
-            locs.push_back({Letter::B, Number::Five});
-            locs.push_back({Letter::C, Number::Five});
-            locs.push_back({Letter::D, Number::Five});
-            break;
-    }
-    return locs;
-}
-
 std::ostream& operator<<(std::ostream& os, const Game& game) {
+    MEMO_SCOPE(Probe::Render);
     if (game.expertDisplay) {
         // Expert display: cards printed horizontally, positions below
         // Format per PDF:
@@ -142,9 +154,9 @@ std::ostream& operator<<(std::ostream& os, const Game& game) {
         // A1  D1  B4  D3
         
         std::vector<std::tuple<Letter, Number, Card*>> revealed;
-        for (int i = 0; i < 5; ++i) {
-            for (int j = 0; j < 5; ++j) {
-                if (i == 2 && j == 2) continue;
+        for (int i = 0; i < Board::Geometry::kRows; ++i) {
+            for (int j = 0; j < Board::Geometry::kCols; ++j) {
+                if (Board::Geometry::isHole(i, j)) continue;
                 Letter l = static_cast<Letter>(i);
                 Number n = static_cast<Number>(j);
                 if (game.board.isFaceUp(l, n)) {
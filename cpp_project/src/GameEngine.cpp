@@ -0,0 +1,234 @@
+#include "GameEngine.h"
+#include "Card.h"
+#include "Instrumentation.h"
+#include "Tracer.h"
+#include <stdexcept>
+
+static_assert(static_cast<int>(AnimalPower::SkipNext) == static_cast<int>(ReplayEffect::SkipNext),
+              "replay effects mirror animal powers");
+
+static uint8_t positionOf(Letter l, Number n) {
+    return static_cast<uint8_t>(Board::Geometry::index(static_cast<int>(l), static_cast<int>(n)));
+}
+
+template <typename Policy>
+GameEngine<Policy>::GameEngine(Game& game, Rules& rules, RubisDeck& rubisDeck)
+    : game(game), rules(rules), rubisDeck(rubisDeck), turn(0), skipNext(false),
+      secondTurn(false), skipped(-1), pickedLetter(Letter::A), pickedNumber(Number::One),
+      awaitingTarget(false), targetApplied(false), lastEffect(ExpertEffect::None),
+      lastAward(nullptr), recorder(nullptr) {}
+
+template <typename Policy>
+void GameEngine<Policy>::startRound() {
+    MEMO_SCOPE(Probe::RoundSetup);
+    MEMO_TRACE_SCOPE("round_start");
+    MEMO_COUNT(Counter::Rounds);
+    game.nextRound();
+    turn = 0;
+    skipNext = false;
+    secondTurn = false;
+    skipped = -1;
+    awaitingTarget = false;
+    lastEffect = ExpertEffect::None;
+}
+
+template <typename Policy>
+void GameEngine<Policy>::advance() {
+    secondTurn = false;
+    skipped = -1;
+    if (rules.roundOver(game)) return;
+
+    // At least two seats are still active here
+    turn = game.nextActiveSeat(turn + 1);
+    if (Policy::turnEffects && skipNext) {
+        // Turtle effect: the next active player loses their turn
+        skipNext = false;
+        skipped = turn;
+        turn = game.nextActiveSeat(turn + 1);
+    }
+}
+
+template <typename Policy>
+PickResult GameEngine<Policy>::pick(Letter l, Number n) {
+    if (awaitingTarget) return PickResult::NeedsTarget;
+    MEMO_TRACE_SCOPE("pick");
+    {
+        MEMO_SCOPE(Probe::PickValidation);
+        PickResult rejected = PickResult::Matched;
+        if (Board::Geometry::isHole(static_cast<int>(l), static_cast<int>(n))) rejected = PickResult::Hole;
+        else if (game.isBlocked(l, n)) rejected = PickResult::Blocked;
+        else if (game.getBoard().isFaceUp(l, n)) rejected = PickResult::AlreadyFaceUp;
+        if (rejected != PickResult::Matched) {
+            MEMO_COUNT(Counter::RejectedPicks);
+            return rejected;
+        }
+    }
+    MEMO_COUNT(Counter::Picks);
+
+    Card* card;
+    {
+        MEMO_SCOPE(Probe::Reveal);
+        // Walrus block only lasts for one valid selection
+        game.resetBlocked();
+        game.turnFaceUp(l, n);
+        card = game.getCard(l, n);
+        game.setCurrentCard(card);
+        pickedLetter = l;
+        pickedNumber = n;
+        targetApplied = false;
+    }
+    {
+        MEMO_SCOPE(Probe::ExpertEffect);
+        MEMO_TRACE_SCOPE("expert_effect");
+        if constexpr (Policy::turnEffects) lastEffect = rules.applyExpertRule(*card);
+        if constexpr (Policy::targetEffects) {
+            if (rules.needsTarget(game, *card)) {
+                awaitingTarget = true;
+                return PickResult::NeedsTarget;
+            }
+        }
+    }
+
+    MEMO_SCOPE(Probe::Resolve);
+    return resolve(kReplayNoPosition);
+}
+
+template <typename Policy>
+PickResult GameEngine<Policy>::target(Letter l, Number n) {
+    if (!awaitingTarget) throw std::runtime_error("No expert target expected");
+    awaitingTarget = false;
+    MEMO_COUNT(Counter::ExpertTargets);
+    {
+        MEMO_SCOPE(Probe::ExpertEffect);
+        MEMO_TRACE_SCOPE("expert_effect");
+        targetApplied = rules.applyTarget(game, *game.getCurrentCard(), pickedLetter, pickedNumber, l, n);
+    }
+
+    MEMO_SCOPE(Probe::Resolve);
+    return resolve(targetApplied ? positionOf(l, n) : kReplayNoPosition);
+}
+
+template <typename Policy>
+PickResult GameEngine<Policy>::forfeit() {
+    MEMO_COUNT(Counter::Eliminations);
+    awaitingTarget = false;
+    targetApplied = false;
+    lastEffect = ExpertEffect::None;
+    game.setSeatActive(turn, false);
+    advance();
+    return PickResult::Eliminated;
+}
+
+template <typename Policy>
+PickResult GameEngine<Policy>::resolve(uint8_t target) {
+    bool matched = rules.isValid(game);
+    record(matched, target);
+
+    if (!matched) {
+        MEMO_COUNT(Counter::Eliminations);
+        game.setSeatActive(turn, false);
+        advance();
+        return PickResult::Eliminated;
+    }
+
+    if constexpr (Policy::turnEffects) {
+        if (lastEffect == ExpertEffect::PlayAgain && !secondTurn) {
+            secondTurn = true;
+            return PickResult::Matched;
+        }
+        if (lastEffect == ExpertEffect::SkipNext) skipNext = true;
+    }
+    advance();
+    return PickResult::Matched;
+}
+
+template <typename Policy>
+int GameEngine<Policy>::finishRound() {
+    MEMO_SCOPE(Probe::RubisAward);
+    MEMO_TRACE_SCOPE("award");
+    lastAward = nullptr;
+    auto& players = game.getPlayersMutable();
+    int winner = game.nextActiveSeat(0);
+    if (winner >= 0) {
+        const Rubis* rubis = rubisDeck.getNext();
+        if (rubis) {
+            players[winner].addRubis(*rubis);
+            lastAward = rubis;
+            if (recorder) {
+                recorder->addEvent({static_cast<uint8_t>(game.getRound()), static_cast<uint8_t>(winner), kReplayNoPosition,
+                                    static_cast<uint8_t>(static_cast<int>(*rubis)),
+                                    ReplayEvent::makeFlags(true, ReplayEffect::Award), kReplayNoPosition});
+            }
+        }
+    }
+
+    if (recorder && rules.gameOver(game)) {
+        for (size_t i = 0; i < players.size(); ++i) recorder->setRubies(static_cast<int>(i), players[i].getNRubies());
+    }
+    return winner;
+}
+
+template <typename Policy>
+void GameEngine<Policy>::record(bool matched, uint8_t target) {
+    if (!recorder) return;
+
+    ReplayEffect effect = ReplayEffect::None;
+    const Card& card = *game.getCurrentCard();
+    AnimalPower power = rules.getPower((FaceAnimal)card);
+    bool turnPower = power == AnimalPower::PlayAgain || power == AnimalPower::SkipNext;
+    if (turnPower ? Policy::turnEffects : targetApplied) effect = static_cast<ReplayEffect>(power);
+
+    recorder->addEvent({static_cast<uint8_t>(game.getRound()), static_cast<uint8_t>(turn),
+                        positionOf(pickedLetter, pickedNumber), static_cast<uint8_t>(card.getId()),
+                        ReplayEvent::makeFlags(matched, effect), target});
+}
+
+template <typename Policy>
+void GameEngine<Policy>::saveTurn(GameSnapshot& snapshot) const {
+    snapshot.turnPlayer = static_cast<uint8_t>(turn);
+    snapshot.skipNext = skipNext;
+    snapshot.turnFlags = static_cast<uint8_t>((secondTurn ? kSnapshotSecondTurn : 0) |
+                                              (awaitingTarget ? kSnapshotAwaitingTarget : 0) |
+                                              ((skipped + 1) << kSnapshotSkippedShift));
+    snapshot.pickedPosition = positionOf(pickedLetter, pickedNumber);
+}
+
+template <typename Policy>
+void GameEngine<Policy>::restoreTurn(const GameSnapshot& snapshot) {
+    turn = snapshot.turnPlayer;
+    skipNext = snapshot.skipNext != 0;
+    secondTurn = (snapshot.turnFlags & kSnapshotSecondTurn) != 0;
+    awaitingTarget = (snapshot.turnFlags & kSnapshotAwaitingTarget) != 0;
+    pickedLetter = static_cast<Letter>(snapshot.pickedPosition / Board::Geometry::kCols);
+    pickedNumber = static_cast<Number>(snapshot.pickedPosition % Board::Geometry::kCols);
+    skipped = (snapshot.turnFlags >> kSnapshotSkippedShift) - 1;
+    targetApplied = false;
+    lastEffect = ExpertEffect::None;
+    lastAward = nullptr;
+}
+
+template <typename Policy>
+void GameEngine<Policy>::setRecorder(Replay* replay) {
+    recorder = replay;
+    if (!recorder) return;
+
+    int mode = Policy::expertRules ? 2 : (game.isExpertDisplay() ? 1 : 0);
+    recorder->clear(static_cast<int>(game.getPlayers().size()), mode);
+    for (int i = 0; i < Board::Geometry::kRows; ++i) {
+        for (int j = 0; j < Board::Geometry::kCols; ++j) {
+            if (Board::Geometry::isHole(i, j)) continue;
+            const Card* card = game.getBoard().getCard(static_cast<Letter>(i), static_cast<Number>(j));
+            if (card) recorder->setLayout(Board::Geometry::index(i, j), card->getId());
+        }
+    }
+}
+
+// Every RulePolicy combination, so custom variants link without extra code
+template class GameEngine<RulePolicy<false, false, false>>;
+template class GameEngine<RulePolicy<false, false, true>>;
+template class GameEngine<RulePolicy<false, true, false>>;
+template class GameEngine<RulePolicy<false, true, true>>;
+template class GameEngine<RulePolicy<true, false, false>>;
+template class GameEngine<RulePolicy<true, false, true>>;
+template class GameEngine<RulePolicy<true, true, false>>;
+template class GameEngine<RulePolicy<true, true, true>>;
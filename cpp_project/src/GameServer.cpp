@@ -0,0 +1,1125 @@
+#include "GameServer.h"
+#include "CardDeck.h"
+#include "RubisDeck.h"
+#include "Exceptions.h"
+#include "Position.h"
+#include <arpa/inet.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstring>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static const char* const kModeNames[3] = {"base", "expert_display", "expert_rules"};
+// Text rendering of each WireError
+static const char* const kErrorText[] = {
+    "", "unknown command", "usage: create base|expert_display|expert_rules 2-8", "no such table", "table is full",
+    "already seated", "not playing", "not your turn", "hole", "blocked", "face up", "closed",
+    "queue is full"};
+static volatile std::sig_atomic_t signalled = 0;
+
+static void onSignal(int) {
+    signalled = 1;
+}
+
+static uint64_t nowMs() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+// Splits off the next whitespace separated word of line
+static std::string_view nextWord(std::string_view& line) {
+    size_t begin = line.find_first_not_of(" \t\r");
+    if (begin == std::string_view::npos) {
+        line = std::string_view();
+        return line;
+    }
+    size_t end = line.find_first_of(" \t\r", begin);
+    if (end == std::string_view::npos) end = line.size();
+    std::string_view word = line.substr(begin, end - begin);
+    line.remove_prefix(end);
+    return word;
+}
+
+// Non-negative decimal number, -1 if word is not one
+static int parseNumber(std::string_view word) {
+    if (word.empty() || word.size() > 6) return -1;
+    int value = 0;
+    for (char c : word) {
+        if (c < '0' || c > '9') return -1;
+        value = value * 10 + (c - '0');
+    }
+    return value;
+}
+
+// Wire, log and sight positions are Board::Geometry indexes
+static Letter letterOf(int pos) {
+    return static_cast<Letter>(Board::Geometry::rowOf(pos));
+}
+
+static Number numberOf(int pos) {
+    return static_cast<Number>(Board::Geometry::colOf(pos));
+}
+
+static const Card* cardAt(const Game& game, int pos) {
+    return game.getBoard().getCard(letterOf(pos), numberOf(pos));
+}
+
+static std::string positionName(int pos) {
+    return std::string{static_cast<char>('A' + Board::Geometry::rowOf(pos)),
+                       static_cast<char>('1' + Board::Geometry::colOf(pos))};
+}
+
+static WireSight makeSight(const Table& table, int seat) {
+    const Game& game = table.getGame();
+    WireSight sight{};
+    sight.round = static_cast<uint8_t>(game.getRound());
+    sight.turn = static_cast<uint8_t>(table.getTurn());
+    uint32_t mask = game.getSightMask(seat);
+    int k = 0;
+    for (int pos = 0; pos < Board::Geometry::kCells && k < kWireSightCards; ++pos) {
+        if (!(mask & (1u << pos))) continue;
+        sight.positions[k] = static_cast<uint8_t>(pos);
+        sight.cards[k++] = static_cast<uint8_t>(cardAt(game, pos)->getId());
+    }
+    for (; k < kWireSightCards; ++k) sight.positions[k] = sight.cards[k] = kWireNone;
+    return sight;
+}
+
+static WireDelta makeDelta(const Table& table, const TableUpdate& update) {
+    WireDelta delta{};
+    delta.seat = static_cast<uint8_t>(update.seat);
+    bool forfeited = update.position == TableUpdate::kNoPosition;
+    delta.position = forfeited ? kWireNone : update.position;
+    bool faceUp = !forfeited && ((update.faceUpMask >> update.position) & 1);
+    delta.card = kWireNone;
+    if (faceUp) delta.card = update.isTarget ? static_cast<uint8_t>(cardAt(table.getGame(), update.position)->getId())
+                                             : update.card;
+    delta.flags = static_cast<uint8_t>((faceUp ? kDeltaFaceUp : 0) | (update.isTarget ? kDeltaTarget : 0) |
+                                       (update.targetApplied ? kDeltaApplied : 0) |
+                                       (update.result == PickResult::Eliminated ? kDeltaEliminated : 0) |
+                                       (update.result == PickResult::NeedsTarget ? kDeltaAwaitingTarget : 0) |
+                                       (update.newRound || update.gameOver ? kDeltaRoundOver : 0) |
+                                       (update.gameOver ? kDeltaGameOver : 0) |
+                                       (update.timedOut ? kDeltaTimeout : 0));
+    delta.effect = static_cast<uint8_t>(update.effect);
+    delta.activeSeats = update.activeSeats;
+    delta.turn = static_cast<uint8_t>(table.getTurn());
+    delta.skipped = update.skipped >= 0 ? static_cast<uint8_t>(update.skipped) : kWireNone;
+    delta.winner = update.winner >= 0 ? static_cast<uint8_t>(update.winner) : kWireNone;
+    delta.award = static_cast<uint8_t>(update.award);
+    delta.round = static_cast<uint8_t>(update.round);
+    delta.faceUpMask = update.faceUpMask;
+    return delta;
+}
+
+// A spectator's picture of the table: never a card that is face down
+static void makeBoard(const Table& table, int id, WireBoard& board, WireCards* cards) {
+    const Game& game = table.getGame();
+    bool playing = table.getState() == Table::State::Playing;
+    board.table = static_cast<uint32_t>(id);
+    board.mode = static_cast<uint8_t>(table.getMode());
+    board.seats = static_cast<uint8_t>(table.getSeats());
+    board.round = playing ? static_cast<uint8_t>(game.getRound()) : 0;
+    board.turn = playing ? static_cast<uint8_t>(table.getTurn()) : kWireNone;
+    board.activeSeats = game.getActiveSeats();
+    board.faceUpMask = game.getBoard().getFaceUpMask();
+    for (int part = 0; part < 2; ++part) {
+        cards[part].first = static_cast<uint8_t>(part * (kWireBoardCards + 1));
+        for (int k = 0; k < kWireBoardCards; ++k) {
+            int pos = cards[part].first + k;
+            cards[part].cards[k] = (board.faceUpMask >> pos) & 1
+                ? static_cast<uint8_t>(cardAt(game, pos)->getId())
+                : kWireNone;
+        }
+    }
+}
+
+static WireOver makeOver(const Table& table) {
+    WireOver over{};
+    const auto& players = table.getGame().getPlayers();
+    over.seats = static_cast<uint8_t>(players.size());
+    for (size_t seat = 0; seat < players.size(); ++seat) over.rubies[seat] = static_cast<uint8_t>(players[seat].getNRubies());
+    return over;
+}
+
+// Text lines for the same messages
+static std::string describe(const WireSight& sight) {
+    std::string text = "sight";
+    for (int k = 0; k < kWireSightCards && sight.positions[k] != kWireNone; ++k) {
+        text += " " + positionName(sight.positions[k]) + "=" + std::to_string(sight.cards[k]);
+    }
+    return text + "\nturn " + std::to_string(sight.turn) + "\n";
+}
+
+static std::string describe(const WireBoard& board, const WireCards* cards) {
+    std::string text = std::string("board ") + kModeNames[board.mode] + " " + std::to_string(board.seats);
+    if (board.round == 0) return text + " waiting\n";
+    text += " round " + std::to_string(board.round) + " turn " + std::to_string(board.turn);
+    for (int part = 0; part < 2; ++part) {
+        for (int k = 0; k < kWireBoardCards; ++k) {
+            if (cards[part].cards[k] == kWireNone) continue;
+            text += " " + positionName(cards[part].first + k) + "=" + std::to_string(cards[part].cards[k]);
+        }
+    }
+    return text + "\n";
+}
+
+static std::string describe(const WireOver& over) {
+    std::string text = "over";
+    for (int seat = 0; seat < over.seats; ++seat) text += " " + std::to_string(over.rubies[seat]);
+    return text + "\n";
+}
+
+static std::string describe(const WireDelta& delta) {
+    std::string seat = std::to_string(delta.seat);
+    const char* outcome = (delta.flags & kDeltaAwaitingTarget) ? "target"
+                          : (delta.flags & kDeltaEliminated) ? "eliminated" : "matched";
+    std::string text;
+    if (delta.flags & kDeltaTimeout) text = "timeout " + seat + (delta.position == kWireNone ? " eliminated\n" : "\n");
+    if (delta.position == kWireNone) {
+        // Forfeited: nothing was played
+    } else if (delta.flags & kDeltaTarget) {
+        text += "target " + seat + " " + positionName(delta.position) +
+                ((delta.flags & kDeltaApplied) ? " applied " : " ignored ") + outcome + "\n";
+    } else {
+        text += "reveal " + seat + " " + positionName(delta.position) + " " + std::to_string(delta.card) + " " +
+                outcome + "\n";
+    }
+    if (delta.skipped != kWireNone) text += "skip " + std::to_string(delta.skipped) + "\n";
+    if (delta.winner != kWireNone) {
+        text += "award " + std::to_string(delta.winner) + " " + std::to_string(delta.award) + "\n";
+    }
+    if (delta.flags & kDeltaGameOver) return text;
+    if (delta.flags & kDeltaRoundOver) return text + "round " + std::to_string(delta.round + 1) + "\n";
+    return text + "turn " + std::to_string(delta.turn) + ((delta.flags & kDeltaAwaitingTarget) ? " target\n" : "\n");
+}
+
+GameServer::GameServer(const ServerOptions& options, ShardMesh* mesh, int shard)
+    : options(options), mesh(mesh), shard(shard), shardCount(mesh ? mesh->size() : 1),
+      cardDeck(CardDeck::make_CardDeck()), rubisDeck(RubisDeck::make_RubisDeck()), listenFd(-1), stopping(false),
+      tableCount(0), nextSerial(0), timers(nowMs(), 10),
+      ownMatchmaker(mesh ? nullptr
+                         : new Matchmaker(Game::kMaxSeats, ShardMesh::kTicketCapacity, Matchmaker::clientLimit())),
+      matchmaker(mesh ? &mesh->getMatchmaker() : ownMatchmaker.get()), checkpointCursor(0),
+      nextCheckpointMs(nowMs() + options.checkpointInterval * 1000ull) {
+    if (options.io != "epoll" && options.io != "uring") throw ServerError("Unknown I/O backend: " + options.io);
+    // Shards deal different games from the same seed
+    CardDeck::seed(options.seed + static_cast<unsigned>(shard));
+    RubisDeck::seed(options.seed + static_cast<unsigned>(shard));
+    if (!options.wal.empty()) {
+        logPath = shardCount > 1 ? options.wal + "." + std::to_string(shard) : options.wal;
+        try {
+            log.reset(new MoveLog(logPath, shard, shardCount));
+            recover();
+        } catch (const ArchiveError& e) {
+            throw ServerError(e.what());
+        } catch (const SnapshotError& e) {
+            throw ServerError(e.what());
+        }
+    }
+    int wakeFd = mesh ? mesh->getWakeFd(shard) : -1;
+    try {
+        listen();
+        io = options.io == "uring" ? makeUringBackend(listenFd, wakeFd) : makeEpollBackend(listenFd, wakeFd);
+    } catch (...) {
+        if (listenFd >= 0) ::close(listenFd);
+        throw;
+    }
+}
+
+GameServer::~GameServer() {
+    for (Table* table : tables) {
+        if (!table) continue;
+        timers.cancel(table->getTimer());
+        timers.cancel(table->getIdleTimer());
+        tablePool.destroy(table);
+    }
+    for (Handoff& handoff : stalled) {
+        if (handoff.ownsSocket()) ::close(handoff.fd);
+    }
+    for (size_t fd = 0; fd < connections.size(); ++fd) {
+        if (connections[fd].queueSerial) matchmaker->cancel(static_cast<int>(fd), connections[fd].queueSerial);
+    }
+    io.reset();
+    ::close(listenFd);
+    if (options.address.compare(0, 5, "unix:") == 0) ::unlink(options.address.c_str() + 5);
+}
+
+void GameServer::listen() {
+    const std::string& address = options.address;
+    if (address.compare(0, 5, "unix:") == 0) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::string path = address.substr(5);
+        if (shardCount > 1) throw ServerError("Shards need a HOST:PORT address");
+        if (path.empty() || path.size() >= sizeof(addr.sun_path)) throw ServerError("Bad socket path: " + path);
+        std::memcpy(addr.sun_path, path.c_str(), path.size());
+        ::unlink(path.c_str());
+        listenFd = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        if (listenFd < 0 || ::bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+            throw ServerError("Cannot bind " + address + ": " + std::strerror(errno));
+    } else {
+        size_t colon = address.rfind(':');
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        int port = colon == std::string::npos ? -1 : parseNumber(std::string_view(address).substr(colon + 1));
+        if (port < 0 || port > 65535 || ::inet_pton(AF_INET, address.substr(0, colon).c_str(), &addr.sin_addr) != 1)
+            throw ServerError("Bad address: " + address);
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        listenFd = ::socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+        int yes = 1;
+        if (listenFd >= 0) ::setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+        // Every shard binds the same port; the kernel spreads new connections over them
+        if (listenFd >= 0 && shardCount > 1) ::setsockopt(listenFd, SOL_SOCKET, SO_REUSEPORT, &yes, sizeof(yes));
+        if (listenFd < 0 || ::bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) < 0)
+            throw ServerError("Cannot bind " + address + ": " + std::strerror(errno));
+    }
+    if (::listen(listenFd, SOMAXCONN) < 0) throw ServerError(std::string("listen: ") + std::strerror(errno));
+}
+
+int GameServer::poll(int timeoutMs) {
+    int untilTimer = timers.untilNextTick(nowMs());
+    if (untilTimer >= 0 && (timeoutMs < 0 || untilTimer < timeoutMs)) timeoutMs = untilTimer;
+    if (!stalled.empty()) timeoutMs = 0;
+    if (log && options.checkpointInterval > 0) {
+        // A checkpoint saves a slice of tables per poll, then waits for its sync
+        uint64_t now = nowMs();
+        int untilCheckpoint = checkpoint ? (checkpointCursor < checkpoint->size() ? 0 : 10)
+                                         : (nextCheckpointMs > now ? static_cast<int>(nextCheckpointMs - now) : 0);
+        if (timeoutMs < 0 || untilCheckpoint < timeoutMs) timeoutMs = untilCheckpoint;
+    }
+    // Spectators left behind get another chance once their sockets drained a little
+    if (!staleAudiences.empty() && (timeoutMs < 0 || timeoutMs > 10)) timeoutMs = 10;
+
+    if (log) io->hold();
+    int handled = io->poll(timeoutMs, *this);
+    timers.advance(nowMs(), [this](TimerNode& node) {
+        Table* table = tables[node.owner];
+        if (!table) return;
+        if (&node == &table->getIdleTimer() || table->getState() == Table::State::Waiting) abandon(*table);
+        else timeOut(*table);
+    });
+
+    std::vector<Handoff> retry;
+    retry.swap(stalled);
+    for (Handoff& handoff : retry) pushHandoff(handoff);
+    if (!staleAudiences.empty()) flushSpectators();
+
+    // One sync for every table that moved, then the replies
+    if (log) {
+        log->commit();
+        io->release();
+        if (options.checkpointInterval > 0) checkpointStep();
+    }
+    return handled;
+}
+
+// Starts a checkpoint when one is due, saves its next slice of tables, and once
+// it is durable drops the log records it holds
+void GameServer::checkpointStep() {
+    if (!checkpoint) {
+        if (nowMs() < nextCheckpointMs) return;
+        checkpoint.reset(new CheckpointWriter(logPath + ".ckpt", shard, shardCount, log->mark(), tables.size()));
+        checkpointCursor = 0;
+    }
+    uint64_t last = std::min(checkpointCursor + kCheckpointSlice, checkpoint->size());
+    for (; checkpointCursor < last; ++checkpointCursor) {
+        CheckpointEntry& entry = checkpoint->entry(checkpointCursor);
+        const Table* table = tables[checkpointCursor];
+        entry.position = log->position();
+        entry.seats = static_cast<uint8_t>(table ? table->getSeats() : 0);
+        if (table) table->save(entry.game);
+    }
+    if (checkpointCursor < checkpoint->size()) return;
+    checkpoint->finish(*log);
+    if (!checkpoint->isDone()) return;
+    log->endTruncate();
+    checkpoint.reset();
+    nextCheckpointMs = nowMs() + options.checkpointInterval * 1000ull;
+}
+
+// Loads the last checkpoint and plays the move log's records it does not hold:
+// every table comes back as it was, with its seats free until their players join again
+void GameServer::recover() {
+    uint64_t start = 0;
+    std::vector<uint64_t> resume; // by table index: position of the first record the checkpoint lacks
+    std::string checkpointPath = logPath + ".ckpt";
+    if (::access(checkpointPath.c_str(), F_OK) == 0) {
+        Checkpoint saved(checkpointPath, shard, shardCount);
+        start = saved.getStart();
+        tables.resize(saved.size(), nullptr);
+        resume.resize(saved.size());
+        for (uint64_t index = 0; index < saved.size(); ++index) {
+            const CheckpointEntry& entry = saved[index];
+            resume[index] = entry.position;
+            if (entry.seats == 0) continue;
+            tables[index] = tablePool.create(static_cast<int>(index), entry.seats, entry.game, cardDeck, rubisDeck);
+        }
+    }
+    if (log->getBase() > start || log->position() < start) throw ArchiveError("Move log does not match its checkpoint");
+
+    LogRecord record;
+    const uint8_t* payload = nullptr;
+    uint64_t position = 0;
+    TableUpdate update;
+    while (log->next(record, payload, position)) {
+        size_t index = record.table;
+        if (position < start || (index < resume.size() && position < resume[index])) continue;
+        if (record.type == LogRecord::Type::Open) {
+            if (tables.size() <= index) tables.resize(index + 1, nullptr);
+            tablePool.destroy(tables[index]);
+            tables[index] = tablePool.create(static_cast<int>(index), record.seat, record.value, payload, cardDeck,
+                                             rubisDeck);
+            continue;
+        }
+        if (index >= tables.size() || !tables[index]) throw ArchiveError("Move log uses a table it did not open");
+        Table& table = *tables[index];
+        switch (record.type) {
+            case LogRecord::Type::Join:
+                table.join(std::string(reinterpret_cast<const char*>(payload), record.value), -1);
+                break;
+            case LogRecord::Type::Move:
+                table.act(record.seat, letterOf(record.value), numberOf(record.value), update);
+                break;
+            case LogRecord::Type::Timeout:
+                table.timeOut(record.value != 0, update);
+                break;
+            case LogRecord::Type::Close:
+                tablePool.destroy(&table);
+                tables[index] = nullptr;
+                break;
+            default:
+                throw ArchiveError("Bad record in move log");
+        }
+    }
+
+    // Free slots are reused lowest first, as if the tables had been opened in this run
+    for (size_t index = tables.size(); index-- > 0;) {
+        if (tables[index]) install(tables[index]);
+        else freeTables.push_back(static_cast<int>(index));
+    }
+}
+
+int GameServer::run() {
+    struct sigaction action{};
+    action.sa_handler = onSignal;
+    sigaction(SIGINT, &action, nullptr);
+    sigaction(SIGTERM, &action, nullptr);
+
+    while (!stopping && !signalled) poll(1000);
+    // A signal interrupts one thread: let the other shards see it too
+    if (mesh) {
+        for (int other = 0; other < shardCount; ++other) mesh->wake(other);
+    }
+    return 0;
+}
+
+void GameServer::onOpen(int fd) {
+    if (connections.size() <= static_cast<size_t>(fd)) connections.resize(fd + 1);
+    connections[fd] = Connection();
+    connections[fd].open = true;
+}
+
+void GameServer::onData(int fd, const char* data, size_t size) {
+    Connection& conn = connections[fd];
+    while (size > 0 && conn.open) {
+        if (conn.handoffTable >= 0) {
+            // Leaving for another shard, which handles the rest
+            conn.handoffInput.append(data, size);
+            return;
+        }
+        if (conn.protocol == Protocol::Unknown) {
+            conn.protocol = isWireType(static_cast<uint8_t>(data[0])) ? Protocol::Binary : Protocol::Text;
+        }
+        size_t take = kLineMax - conn.inLength < size ? kLineMax - conn.inLength : size;
+        std::memcpy(conn.in + conn.inLength, data, take);
+        conn.inLength += take;
+        data += take;
+        size -= take;
+        if (!consume(fd)) return;
+    }
+}
+
+// Handles every complete line or frame in the connection's buffer, stopping
+// after a handoff; false if it was closed
+bool GameServer::consume(int fd) {
+    Connection& conn = connections[fd];
+    size_t start = 0;
+    if (conn.protocol == Protocol::Binary) {
+        while (conn.inLength - start >= kWireFrameSize && conn.handoffTable < 0) {
+            handleFrame(fd, reinterpret_cast<const uint8_t*>(conn.in + start));
+            if (!conn.open) return false;
+            start += kWireFrameSize;
+        }
+    } else {
+        for (size_t i = 0; i < conn.inLength && conn.handoffTable < 0; ++i) {
+            if (conn.in[i] != '\n') continue;
+            handleLine(fd, std::string_view(conn.in + start, i - start));
+            if (!conn.open) return false;
+            start = i + 1;
+        }
+        if (start == 0 && conn.inLength == kLineMax) {
+            send(fd, "error line too long\n");
+            closeClient(fd);
+            return false;
+        }
+    }
+    std::memmove(conn.in, conn.in + start, conn.inLength - start);
+    conn.inLength -= start;
+    return true;
+}
+
+void GameServer::send(int fd, std::string_view bytes) {
+    iovec part{const_cast<char*>(bytes.data()), bytes.size()};
+    io->send(fd, &part, 1);
+}
+
+void GameServer::reject(int fd, WireError error) {
+    if (connections[fd].protocol == Protocol::Binary) {
+        uint8_t frame[kWireFrameSize];
+        encode(WireReject{error}, frame);
+        send(fd, std::string_view(reinterpret_cast<const char*>(frame), sizeof(frame)));
+    } else {
+        send(fd, std::string("error ") + kErrorText[static_cast<int>(error)] + "\n");
+    }
+}
+
+void GameServer::publish(const Table& table, std::string_view text, const uint8_t* frames, size_t frameBytes,
+                         bool sight) {
+    const Game& game = table.getGame();
+    for (int seat = 0; seat < game.getSeatCount(); ++seat) {
+        int fd = table.getClient(seat);
+        if (fd < 0) continue;
+        bool binary = connections[fd].protocol == Protocol::Binary;
+
+        // The shared part, then this seat's sight when a round starts, in one gathered write
+        iovec parts[2];
+        parts[0].iov_base = binary ? static_cast<void*>(const_cast<uint8_t*>(frames))
+                                   : static_cast<void*>(const_cast<char*>(text.data()));
+        parts[0].iov_len = binary ? frameBytes : text.size();
+        uint8_t sightFrame[kWireFrameSize];
+        std::string sightText;
+        if (sight) {
+            WireSight own = makeSight(table, seat);
+            if (binary) {
+                encode(own, sightFrame);
+                parts[1].iov_base = sightFrame;
+                parts[1].iov_len = sizeof(sightFrame);
+            } else {
+                sightText = describe(own);
+                parts[1].iov_base = &sightText[0];
+                parts[1].iov_len = sightText.size();
+            }
+        }
+        io->send(fd, parts, sight ? 2 : 1);
+    }
+
+    // Spectators take it from the rings, once this poll is done
+    size_t index = static_cast<size_t>(table.getId());
+    if (index >= audiences.size() || !audiences[index]) return;
+    Audience& audience = *audiences[index];
+    audience.lastFrames = audience.frames.getHead();
+    audience.frames.publish(frames, frameBytes);
+    audience.lastText = audience.text.getHead();
+    audience.text.publish(text.data(), text.size());
+    if (!audience.stale) {
+        audience.stale = true;
+        staleAudiences.push_back(static_cast<int>(index));
+    }
+}
+
+// Hands every audience with news to its spectators; those still behind stay listed
+void GameServer::flushSpectators() {
+    size_t kept = 0;
+    for (size_t k = 0; k < staleAudiences.size(); ++k) {
+        Audience& audience = *audiences[staleAudiences[k]];
+        bool behind = false;
+        for (int fd : audience.spectators) behind |= !deliver(fd, audience, false);
+        if (behind) staleAudiences[kept++] = staleAudiences[k];
+        else audience.stale = false;
+    }
+    staleAudiences.resize(kept);
+}
+
+// Sends a spectator what it has not read yet, or a fresh board when that was
+// overwritten; false while its socket is too far behind to take more. A table
+// closing gets its last message through regardless.
+bool GameServer::deliver(int fd, Audience& audience, bool closing) {
+    Connection& conn = connections[fd];
+    bool binary = conn.protocol == Protocol::Binary;
+    const SpectatorRing& ring = binary ? audience.frames : audience.text;
+    if (conn.cursor == ring.getHead()) return true;
+    if (!closing && io->unsent(fd) > kSpectatorLag) return false;
+
+    iovec parts[2];
+    int count = ring.read(conn.cursor, parts);
+    if (count < 0) {
+        resync(fd, *tables[conn.watching]);
+        if (closing) count = ring.read(binary ? audience.lastFrames : audience.lastText, parts);
+    }
+    if (count > 0) io->send(fd, parts, count);
+    conn.cursor = ring.getHead();
+    return true;
+}
+
+void GameServer::resync(int fd, const Table& table) {
+    WireBoard board;
+    WireCards cards[2];
+    makeBoard(table, globalId(table.getId()), board, cards);
+    if (connections[fd].protocol == Protocol::Binary) {
+        uint8_t frames[3 * kWireFrameSize];
+        encode(board, frames);
+        encode(cards[0], frames + kWireFrameSize);
+        encode(cards[1], frames + 2 * kWireFrameSize);
+        send(fd, std::string_view(reinterpret_cast<const char*>(frames), sizeof(frames)));
+    } else {
+        send(fd, describe(board, cards));
+    }
+}
+
+void GameServer::closeClient(int fd) {
+    io->close(fd);
+    onClose(fd);
+}
+
+void GameServer::onClose(int fd) {
+    Connection& conn = connections[fd];
+    if (!conn.open) return;
+    conn.open = false;
+    leaveQueue(fd);
+    unwatch(fd);
+    if (conn.table >= 0) {
+        Table& table = *tables[conn.table];
+        table.setClient(conn.seat, -1);
+        abandon(table);
+    }
+    conn = Connection();
+}
+
+// The socket now belongs to no backend: send it on to the table's shard
+void GameServer::onDetach(int fd, std::string& unsent) {
+    unwatch(fd);
+    Connection& conn = connections[fd];
+    Handoff handoff;
+    handoff.fd = fd;
+    handoff.table = conn.handoffTable;
+    handoff.watch = conn.handoffWatch;
+    handoff.name.swap(conn.handoffName);
+    handoff.protocol = static_cast<uint8_t>(conn.protocol);
+    handoff.input.assign(conn.in, conn.inLength);
+    handoff.input += conn.handoffInput;
+    handoff.unsent.swap(unsent);
+    handoff.tableSerial = conn.handoffSerial;
+    conn = Connection();
+    pushHandoff(handoff);
+}
+
+void GameServer::pushHandoff(Handoff& handoff) {
+    int to = handoff.kind == Handoff::Kind::Fetch ? handoff.shard : handoff.table % shardCount;
+    if (!mesh->push(shard, to, handoff)) stalled.push_back(std::move(handoff));
+}
+
+void GameServer::onWake() {
+    Handoff handoff;
+    for (int from = 0; from < shardCount; ++from) {
+        while (from != shard && mesh->pop(from, shard, handoff)) adopt(handoff);
+    }
+}
+
+void GameServer::adopt(Handoff& handoff) {
+    int fd = handoff.fd;
+    switch (handoff.kind) {
+        case Handoff::Kind::Client:
+            // Replay its join here, then whatever it sent after
+            io->adopt(fd, handoff.unsent);
+            onOpen(fd);
+            connections[fd].protocol = static_cast<Protocol>(handoff.protocol);
+            if (handoff.watch) watchTable(fd, handoff.table);
+            else joinTable(fd, handoff.table, handoff.name, handoff.tableSerial);
+            if (connections[fd].open && !handoff.input.empty()) onData(fd, handoff.input.data(), handoff.input.size());
+            return;
+        case Handoff::Kind::Fetch:
+            // The serial tells whether it is still the same wait of the same client
+            if (static_cast<size_t>(fd) < connections.size() && connections[fd].open &&
+                connections[fd].queueSerial == handoff.queueSerial) {
+                connections[fd].queueSerial = 0;
+                handOff(fd, handoff.table, handoff.name, handoff.tableSerial);
+            } else {
+                handoff.kind = Handoff::Kind::Gone;
+                pushHandoff(handoff);
+            }
+            return;
+        case Handoff::Kind::Gone: {
+            // The table can never fill; one that was reused since is left alone
+            size_t index = static_cast<size_t>(handoff.table / shardCount);
+            if (index < tables.size() && tables[index] && tableSerials[index] == handoff.tableSerial &&
+                tables[index]->getState() == Table::State::Waiting) {
+                abandon(*tables[index]);
+            }
+            return;
+        }
+    }
+}
+
+void GameServer::handleLine(int fd, std::string_view line) {
+    std::string_view command = nextWord(line);
+    if (command.empty()) return;
+    if (command == "create") {
+        std::string_view modeName = nextWord(line);
+        int mode = -1;
+        for (int m = 0; m < 3; ++m) {
+            if (modeName == kModeNames[m]) mode = m;
+        }
+        createTable(fd, mode, parseNumber(nextWord(line)));
+    } else if (command == "join") {
+        int id = parseNumber(nextWord(line));
+        joinTable(fd, id, std::string(nextWord(line)));
+    } else if (command == "play") {
+        std::string_view modeName = nextWord(line);
+        int mode = -1;
+        for (int m = 0; m < 3; ++m) {
+            if (modeName == kModeNames[m]) mode = m;
+        }
+        int seats = parseNumber(nextWord(line));
+        queue(fd, mode, seats, nextWord(line));
+    } else if (command == "watch") {
+        watchTable(fd, parseNumber(nextWord(line)));
+    } else {
+        Letter l;
+        Number n;
+        PositionStatus status = parsePosition(command, l, n);
+        if (status == PositionStatus::Hole) {
+            l = letterOf(Board::Geometry::kFirstHole);
+            n = numberOf(Board::Geometry::kFirstHole);
+        } else if (status != PositionStatus::Ok) {
+            reject(fd, WireError::BadRequest);
+            return;
+        }
+        play(fd, l, n, Move::Either);
+    }
+}
+
+void GameServer::handleFrame(int fd, const uint8_t* frame) {
+    switch (wireType(frame)) {
+        case WireType::Create: {
+            WireCreate create;
+            decode(frame, create);
+            createTable(fd, create.mode, create.seats);
+            return;
+        }
+        case WireType::Join: {
+            WireJoin join;
+            decode(frame, join);
+            size_t length = 0;
+            while (length < kWireNameLength && join.name[length]) ++length;
+            joinTable(fd, static_cast<int>(join.table & 0x7FFFFFFF), std::string(join.name, length));
+            return;
+        }
+        case WireType::Queue: {
+            WireQueue request;
+            decode(frame, request);
+            size_t length = 0;
+            while (length < kWireNameLength && request.name[length]) ++length;
+            queue(fd, request.mode, request.seats, std::string_view(request.name, length));
+            return;
+        }
+        case WireType::Watch: {
+            WireWatch watch;
+            decode(frame, watch);
+            watchTable(fd, static_cast<int>(watch.table & 0x7FFFFFFF));
+            return;
+        }
+        case WireType::Pick:
+        case WireType::Target: {
+            WireMove move;
+            if (!decode(frame, move)) break;
+            play(fd, letterOf(move.position), numberOf(move.position), move.target ? Move::Target : Move::Pick);
+            return;
+        }
+        default:
+            break;
+    }
+    reject(fd, WireError::BadRequest);
+}
+
+// Opens a table waiting for its players; returns its local index
+int GameServer::openTable(int mode, int seats) {
+    int index;
+    if (!freeTables.empty()) {
+        index = freeTables.back();
+        freeTables.pop_back();
+    } else {
+        index = static_cast<int>(tables.size());
+        tables.push_back(nullptr);
+    }
+    Table* table = tablePool.create(index, mode, seats, cardDeck, rubisDeck);
+    install(table);
+    if (log) {
+        uint8_t deal[Table::kDealSize];
+        table->getDeal(deal);
+        log->appendOpen(static_cast<uint32_t>(index), mode, seats, deal);
+    }
+    return index;
+}
+
+// Puts a new or recovered table in its slot and starts its clock
+void GameServer::install(Table* table) {
+    int index = table->getId();
+    tables[index] = table;
+    ++tableCount;
+    table->getTimer().owner = index;
+    table->getIdleTimer().owner = index;
+    if (tableSerials.size() <= static_cast<size_t>(index)) tableSerials.resize(index + 1);
+    tableSerials[index] = ++nextSerial;
+    if (table->getState() == Table::State::Playing) {
+        armTurn(*table, true);
+        touch(*table);
+    } else if (options.lobbyTimeout > 0) {
+        timers.schedule(table->getTimer(), nowMs() + options.lobbyTimeout * 1000ull);
+    }
+}
+
+void GameServer::createTable(int fd, int mode, int seats) {
+    if (mode < 0 || mode > 2 || seats < 2 || seats > Game::kMaxSeats) {
+        reject(fd, WireError::BadTable);
+        return;
+    }
+    leaveQueue(fd);
+
+    int id = globalId(openTable(mode, seats));
+    if (connections[fd].protocol == Protocol::Binary) {
+        uint8_t frame[kWireFrameSize];
+        encode(WireTableId{static_cast<uint32_t>(id)}, frame);
+        send(fd, std::string_view(reinterpret_cast<const char*>(frame), sizeof(frame)));
+    } else {
+        send(fd, "table " + std::to_string(id) + "\n");
+    }
+}
+
+// Another shard owns the table: stop reading the client and pass it on once
+// the backend lets go of the socket (onDetach)
+void GameServer::handOff(int fd, int id, const std::string& name, uint32_t tableSerial) {
+    Connection& conn = connections[fd];
+    conn.handoffTable = id;
+    conn.handoffName = name;
+    conn.handoffSerial = tableSerial;
+    io->detach(fd);
+}
+
+void GameServer::joinTable(int fd, int id, const std::string& name, uint32_t tableSerial) {
+    Connection& conn = connections[fd];
+    if (conn.table >= 0) {
+        reject(fd, WireError::AlreadySeated);
+        return;
+    }
+    if (id < 0 || name.empty()) {
+        reject(fd, WireError::NoTable);
+        return;
+    }
+    leaveQueue(fd);
+    if (id % shardCount != shard) {
+        unwatch(fd);
+        handOff(fd, id, name, tableSerial);
+        return;
+    }
+    int index = id / shardCount;
+    if (static_cast<size_t>(index) >= tables.size() || !tables[index] ||
+        (tableSerial != 0 && tableSerials[index] != tableSerial)) {
+        reject(fd, WireError::NoTable);
+        return;
+    }
+
+    Table& table = *tables[index];
+    int seat = table.rejoin(name, fd);
+    bool returning = seat >= 0;
+    if (!returning) seat = table.join(name, fd);
+    if (seat < 0) {
+        reject(fd, WireError::TableFull);
+        return;
+    }
+    unwatch(fd);
+    conn.table = index;
+    conn.seat = seat;
+    if (conn.protocol == Protocol::Binary) {
+        uint8_t frame[kWireFrameSize];
+        encode(WireSeat{static_cast<uint32_t>(id), static_cast<uint8_t>(seat)}, frame);
+        send(fd, std::string_view(reinterpret_cast<const char*>(frame), sizeof(frame)));
+    } else {
+        send(fd, "seat " + std::to_string(seat) + "\n");
+    }
+    if (returning) {
+        // Back at a recovered table: its round, whose turn it is and the seat's sight again
+        if (table.getState() != Table::State::Playing) return;
+        WireSight sight = makeSight(table, seat);
+        if (conn.protocol == Protocol::Binary) {
+            uint8_t frame[kWireFrameSize];
+            encode(sight, frame);
+            send(fd, std::string_view(reinterpret_cast<const char*>(frame), sizeof(frame)));
+        } else {
+            send(fd, describe(sight));
+        }
+        return;
+    }
+    if (log) log->appendJoin(static_cast<uint32_t>(index), seat, name);
+
+    if (table.getState() == Table::State::Playing) {
+        armTurn(table, true);
+        touch(table);
+        std::string text = std::string("start ") + kModeNames[table.getMode()];
+        for (const Player& p : table.getGame().getPlayers()) text += " " + p.getName();
+        text += "\nround 1\n";
+        uint8_t frame[kWireFrameSize];
+        encode(WireStart{static_cast<uint8_t>(table.getMode()), static_cast<uint8_t>(table.getSeats())}, frame);
+        publish(table, text, frame, sizeof(frame), true);
+    }
+}
+
+void GameServer::queue(int fd, int mode, int seats, std::string_view name) {
+    Connection& conn = connections[fd];
+    if (conn.table >= 0 || conn.queueSerial != 0) {
+        reject(fd, WireError::AlreadySeated);
+        return;
+    }
+    if (!matchmaker->isValid(mode, seats) || name.empty()) {
+        reject(fd, WireError::BadTable);
+        return;
+    }
+    unwatch(fd);
+
+    Ticket ticket{};
+    ticket.shard = shard;
+    ticket.fd = fd;
+    std::memcpy(ticket.name, name.data(), std::min(name.size(), sizeof(ticket.name)));
+    // Acknowledged first: the group this join completes may seat it right away
+    if (conn.protocol == Protocol::Binary) {
+        uint8_t frame[kWireFrameSize];
+        encode(WireQueued{static_cast<uint8_t>(mode), static_cast<uint8_t>(seats)}, frame);
+        send(fd, std::string_view(reinterpret_cast<const char*>(frame), sizeof(frame)));
+    } else {
+        send(fd, "queued\n");
+    }
+    bool queued = matchmaker->join(mode, seats, ticket, [this, mode](const Ticket* group, int size) {
+        formTable(mode, group, size);
+    });
+    if (!queued) {
+        reject(fd, WireError::QueueFull);
+        return;
+    }
+    if (conn.table < 0) conn.queueSerial = ticket.serial;
+}
+
+// Follows a table from the seats' side of the room: its board now, then what
+// it publishes. Watching another table, taking a seat or queueing ends it.
+void GameServer::watchTable(int fd, int id) {
+    Connection& conn = connections[fd];
+    if (conn.table >= 0) {
+        reject(fd, WireError::AlreadySeated);
+        return;
+    }
+    if (id < 0) {
+        reject(fd, WireError::NoTable);
+        return;
+    }
+    leaveQueue(fd);
+    unwatch(fd);
+    if (id % shardCount != shard) {
+        conn.handoffWatch = true;
+        handOff(fd, id, std::string(), 0);
+        return;
+    }
+    size_t index = static_cast<size_t>(id / shardCount);
+    if (index >= tables.size() || !tables[index]) {
+        reject(fd, WireError::NoTable);
+        return;
+    }
+
+    if (audiences.size() <= index) audiences.resize(index + 1);
+    if (!audiences[index]) audiences[index].reset(new Audience());
+    Audience& audience = *audiences[index];
+    audience.spectators.push_back(fd);
+    conn.watching = static_cast<int>(index);
+    conn.cursor = conn.protocol == Protocol::Binary ? audience.frames.getHead() : audience.text.getHead();
+    resync(fd, *tables[index]);
+}
+
+void GameServer::unwatch(int fd) {
+    Connection& conn = connections[fd];
+    if (conn.watching < 0) return;
+    std::vector<int>& spectators = audiences[conn.watching]->spectators;
+    *std::find(spectators.begin(), spectators.end(), fd) = spectators.back();
+    spectators.pop_back();
+    conn.watching = -1;
+}
+
+// A create or join by id replaces the client's place in the queue
+void GameServer::leaveQueue(int fd) {
+    Connection& conn = connections[fd];
+    if (conn.queueSerial == 0) return;
+    // Fails once a table formed with it on another shard; its fetch then finds the client gone
+    matchmaker->cancel(fd, conn.queueSerial);
+    conn.queueSerial = 0;
+}
+
+// Runs on the shard whose join completed the group, which owns the new table;
+// players waiting on other shards are fetched from there
+void GameServer::formTable(int mode, const Ticket* group, int seats) {
+    int index = openTable(mode, seats);
+    int id = globalId(index);
+    for (int k = 0; k < seats; ++k) {
+        const Ticket& ticket = group[k];
+        std::string name(ticket.name, strnlen(ticket.name, sizeof(ticket.name)));
+        if (ticket.shard == shard) {
+            // Claimed on this thread, so the client is still connected and waiting
+            connections[ticket.fd].queueSerial = 0;
+            joinTable(ticket.fd, id, name, tableSerials[index]);
+            continue;
+        }
+        Handoff fetch;
+        fetch.kind = Handoff::Kind::Fetch;
+        fetch.fd = ticket.fd;
+        fetch.table = id;
+        fetch.name = name;
+        fetch.tableSerial = tableSerials[index];
+        fetch.shard = ticket.shard;
+        fetch.queueSerial = ticket.serial;
+        pushHandoff(fetch);
+    }
+}
+
+void GameServer::play(int fd, Letter l, Number n, Move move) {
+    Connection& conn = connections[fd];
+    if (conn.table < 0 || tables[conn.table]->getState() != Table::State::Playing) {
+        reject(fd, WireError::NotPlaying);
+        return;
+    }
+
+    Table& table = *tables[conn.table];
+    if (move != Move::Either && conn.seat == table.getTurn() && (move == Move::Target) != table.isAwaitingTarget()) {
+        reject(fd, WireError::BadRequest);
+        return;
+    }
+    TableUpdate update;
+    if (!table.act(conn.seat, l, n, update)) {
+        reject(fd, WireError::NotYourTurn);
+        return;
+    }
+    switch (update.result) {
+        case PickResult::Hole: reject(fd, WireError::Hole); return;
+        case PickResult::Blocked: reject(fd, WireError::Blocked); return;
+        case PickResult::AlreadyFaceUp: reject(fd, WireError::FaceUp); return;
+        default: break;
+    }
+    if (log) log->appendMove(static_cast<uint32_t>(conn.table), conn.seat, update.position);
+    touch(table);
+    broadcast(table, update);
+}
+
+// The seat on turn ran out of time: the table plays for it
+void GameServer::timeOut(Table& table) {
+    TableUpdate update;
+    int seat = table.getTurn();
+    bool forfeit = options.onTimeout == "eliminate";
+    if (!table.timeOut(forfeit, update)) return;
+    if (log) log->appendTimeout(static_cast<uint32_t>(table.getId()), seat, forfeit);
+    broadcast(table, update);
+}
+
+// Sends the outcome of an action to every seat, then starts the next turn's clock
+void GameServer::broadcast(Table& table, const TableUpdate& update) {
+    // Encoded once for the whole table
+    WireDelta delta = makeDelta(table, update);
+    uint8_t frames[2 * kWireFrameSize];
+    encode(delta, frames);
+    size_t frameBytes = kWireFrameSize;
+    std::string text = describe(delta);
+    if (update.gameOver) {
+        WireOver over = makeOver(table);
+        encode(over, frames + kWireFrameSize);
+        frameBytes += kWireFrameSize;
+        text += describe(over);
+    }
+    publish(table, text, frames, frameBytes, update.newRound);
+    if (update.gameOver) closeTable(table);
+    else armTurn(table, update.newRound);
+}
+
+void GameServer::armTurn(Table& table, bool roundStart) {
+    if (options.turnTimeout <= 0) {
+        timers.cancel(table.getTimer()); // the lobby deadline
+        return;
+    }
+    uint64_t seconds = static_cast<uint64_t>(options.turnTimeout) + (roundStart ? options.sightTime : 0);
+    timers.schedule(table.getTimer(), nowMs() + seconds * 1000);
+}
+
+// A client moved: the game is not idle
+void GameServer::touch(Table& table) {
+    if (options.idleTimeout > 0) timers.schedule(table.getIdleTimer(), nowMs() + options.idleTimeout * 1000ull);
+}
+
+// Tells the remaining seats the table is gone, then closes it
+void GameServer::abandon(Table& table) {
+    uint8_t frame[kWireFrameSize];
+    encode(WireReject{WireError::Closed}, frame);
+    publish(table, "closed\n", frame, sizeof(frame), false);
+    closeTable(table);
+}
+
+void GameServer::closeTable(Table& table) {
+    for (int seat = 0; seat < table.getGame().getSeatCount(); ++seat) {
+        int client = table.getClient(seat);
+        if (client < 0) continue;
+        connections[client].table = -1;
+        connections[client].seat = -1;
+    }
+    int index = table.getId();
+    if (static_cast<size_t>(index) < audiences.size() && audiences[index]) {
+        // Spectators get the table's last words before it goes
+        Audience& audience = *audiences[index];
+        for (int fd : audience.spectators) {
+            deliver(fd, audience, true);
+            connections[fd].watching = -1;
+        }
+        audiences[index].reset();
+        staleAudiences.erase(std::remove(staleAudiences.begin(), staleAudiences.end(), index), staleAudiences.end());
+    }
+    if (log) log->appendClose(static_cast<uint32_t>(index));
+    timers.cancel(table.getTimer());
+    timers.cancel(table.getIdleTimer());
+    tablePool.destroy(&table);
+    tables[index] = nullptr;
+    freeTables.push_back(index);
+    --tableCount;
+}
+
+bool GameServer::parseArgs(int argc, char* argv[], ServerOptions& options) {
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--server" && hasValue) options.address = argv[++i];
+            else if (arg == "--seed" && hasValue) options.seed = static_cast<unsigned>(std::stoul(argv[++i]));
+            else if (arg == "--io" && hasValue) options.io = argv[++i];
+            else if (arg == "--shards" && hasValue) options.shards = std::stoi(argv[++i]);
+            else if (arg == "--lobby-timeout" && hasValue) options.lobbyTimeout = std::stoi(argv[++i]);
+            else if (arg == "--turn-timeout" && hasValue) options.turnTimeout = std::stoi(argv[++i]);
+            else if (arg == "--on-timeout" && hasValue) options.onTimeout = argv[++i];
+            else if (arg == "--sight-time" && hasValue) options.sightTime = std::stoi(argv[++i]);
+            else if (arg == "--idle-timeout" && hasValue) options.idleTimeout = std::stoi(argv[++i]);
+            else if (arg == "--wal" && hasValue) options.wal = argv[++i];
+            else if (arg == "--checkpoint-interval" && hasValue) options.checkpointInterval = std::stoi(argv[++i]);
+            else return false;
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    return !options.address.empty() && options.shards >= 0 && options.lobbyTimeout >= 0 &&
+           options.turnTimeout >= 0 && options.sightTime >= 0 && options.idleTimeout >= 0 &&
+           options.checkpointInterval >= 0 &&
+           (options.onTimeout == "pick" || options.onTimeout == "eliminate");
+}
@@ -0,0 +1,103 @@
+#include "Instrumentation.h"
+
+#ifdef MEMO_PROFILE
+
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <mutex>
+#include <vector>
+
+static const int kProbes = static_cast<int>(Probe::Count);
+static const int kCounters = static_cast<int>(Counter::Count);
+
+static const char* kProbeNames[kProbes] = {
+    "round_setup", "sight_phase", "pick_validation", "reveal",
+    "expert_effect", "resolve", "rubis_award", "render", "input_wait"};
+static const char* kCounterNames[kCounters] = {
+    "rounds", "picks", "rejected_picks", "eliminations", "expert_targets"};
+
+struct Totals {
+    uint64_t count[kProbes] = {};
+    uint64_t cycles[kProbes] = {};
+    uint64_t maxCycles[kProbes] = {};
+    uint64_t counters[kCounters] = {};
+
+    void add(const ThreadStats& stats) {
+        for (int p = 0; p < kProbes; ++p) {
+            count[p] += stats.probes[p].count.load(std::memory_order_relaxed);
+            cycles[p] += stats.probes[p].cycles.load(std::memory_order_relaxed);
+            maxCycles[p] = std::max(maxCycles[p], stats.probes[p].maxCycles.load(std::memory_order_relaxed));
+        }
+        for (int c = 0; c < kCounters; ++c) counters[c] += stats.counters[c].load(std::memory_order_relaxed);
+    }
+};
+
+// Registry of live threads plus the totals of threads that already exited
+static std::mutex registryMutex;
+static std::vector<ThreadStats*> registry;
+static Totals retired;
+
+// Cycle counter and wall clock at the first registration, to convert cycles to ns
+struct Calibration {
+    uint64_t cycles;
+    std::chrono::steady_clock::time_point time;
+    Calibration() : cycles(Instrumentation::now()), time(std::chrono::steady_clock::now()) {}
+};
+
+static const Calibration& calibration() {
+    static Calibration start;
+    return start;
+}
+
+ThreadStats::ThreadStats() {
+    for (auto& c : counters) c.store(0, std::memory_order_relaxed);
+    calibration();
+    std::lock_guard<std::mutex> lock(registryMutex);
+    registry.push_back(this);
+}
+
+ThreadStats::~ThreadStats() {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    retired.add(*this);
+    registry.erase(std::remove(registry.begin(), registry.end(), this), registry.end());
+}
+
+void Instrumentation::dumpSummary(std::ostream& os) {
+    Totals totals;
+    size_t threads;
+    {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        totals = retired;
+        for (const auto* stats : registry) totals.add(*stats);
+        threads = registry.size();
+    }
+
+    // Spin briefly on very short runs so the cycle rate estimate is usable
+    const Calibration& start = calibration();
+    double elapsedNs;
+    do {
+        elapsedNs = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start.time).count();
+    } while (elapsedNs < 1e7);
+    double cyclesPerNs = double(now() - start.cycles) / elapsedNs;
+    if (cyclesPerNs <= 0) cyclesPerNs = 1;
+
+    os << "\n--- Instrumentation (" << threads << " live threads, "
+       << std::fixed << std::setprecision(2) << cyclesPerNs << " cycles/ns) ---\n";
+    os << std::left << std::setw(18) << "probe" << std::right << std::setw(12) << "count"
+       << std::setw(14) << "total ms" << std::setw(12) << "avg ns" << std::setw(14) << "max ns" << "\n";
+    for (int p = 0; p < kProbes; ++p) {
+        if (totals.count[p] == 0) continue;
+        double totalNs = totals.cycles[p] / cyclesPerNs;
+        os << std::left << std::setw(18) << kProbeNames[p] << std::right << std::setw(12) << totals.count[p]
+           << std::setw(14) << totalNs / 1e6 << std::setw(12) << totalNs / totals.count[p]
+           << std::setw(14) << totals.maxCycles[p] / cyclesPerNs << "\n";
+    }
+    for (int c = 0; c < kCounters; ++c) {
+        os << kCounterNames[c] << "=" << totals.counters[c] << (c + 1 < kCounters ? " " : "\n");
+    }
+    os.unsetf(std::ios::floatfield);
+    os << std::setprecision(6);
+}
+
+#endif
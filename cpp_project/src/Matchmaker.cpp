@@ -0,0 +1,47 @@
+#include "Matchmaker.h"
+#include <stdexcept>
+#include <thread>
+#include <sys/resource.h>
+
+Matchmaker::Matchmaker(int maxSeats, size_t capacity, size_t maxClients)
+    : maxSeats(maxSeats), states(new std::atomic<uint32_t>[maxClients]), maxClients(maxClients) {
+    if (maxSeats < kMinSeats || maxSeats > kMaxGroup) throw std::invalid_argument("Bad matchmaking table size");
+    for (int k = 0; k < (maxSeats - kMinSeats + 1) * kModes; ++k) buckets.emplace_back(new Bucket(capacity));
+    for (size_t fd = 0; fd < maxClients; ++fd) states[fd].store(0, std::memory_order_relaxed);
+}
+
+bool Matchmaker::take(Bucket& bucket, int seats, Ticket* group, int& claimed) {
+    claimed = 0;
+    for (int k = 0; k < seats; ++k) {
+        // The tickets are counted, so they are there; one may still be mid-push
+        Ticket ticket;
+        while (!bucket.queue.pop(ticket)) std::this_thread::yield();
+        uint32_t expected = ticket.serial;
+        if (states[ticket.fd].compare_exchange_strong(expected, ticket.serial + 1, std::memory_order_acq_rel)) {
+            group[claimed++] = ticket;
+        }
+    }
+    if (claimed < seats) return false;
+    for (int k = 0; k < seats; ++k) states[group[k].fd].store(idleAfter(group[k].serial), std::memory_order_release);
+    return true;
+}
+
+bool Matchmaker::cancel(int fd, uint32_t serial) {
+    if (fd < 0 || static_cast<size_t>(fd) >= maxClients) return false;
+    std::atomic<uint32_t>& state = states[fd];
+    while (true) {
+        uint32_t current = serial;
+        if (state.compare_exchange_strong(current, idleAfter(serial), std::memory_order_acq_rel)) return true;
+        // Claimed: its group either forms or puts it back in a moment
+        if (current != serial + 1) return false;
+        std::this_thread::yield();
+    }
+}
+
+size_t Matchmaker::clientLimit() {
+    rlimit limit{};
+    if (::getrlimit(RLIMIT_NOFILE, &limit) < 0 || limit.rlim_cur == RLIM_INFINITY || limit.rlim_cur > kMaxClients) {
+        return kMaxClients;
+    }
+    return static_cast<size_t>(limit.rlim_cur);
+}
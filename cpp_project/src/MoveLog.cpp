@@ -0,0 +1,266 @@
+#include "MoveLog.h"
+#include "Table.h"
+#include "Exceptions.h"
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char kLogMagic[8] = {'M', 'E', 'M', 'O', 'W', 'A', 'L', '\0'};
+static const uint32_t kLogVersion = 1;
+static const size_t kBufferSize = 1 << 20;
+static const size_t kCopyChunk = 1 << 20;
+
+static_assert(sizeof(LogRecord) == 8, "LogRecord must stay 8 bytes");
+static_assert(sizeof(LogHeader) == 64, "LogHeader must stay 64 bytes");
+
+static void writeAll(int fd, const void* data, size_t n, uint64_t offset) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (n > 0) {
+        ssize_t w = ::pwrite(fd, p, n, static_cast<off_t>(offset));
+        if (w <= 0) throw ArchiveError("Failed to write move log");
+        p += w;
+        n -= static_cast<size_t>(w);
+        offset += static_cast<uint64_t>(w);
+    }
+}
+
+static void readAll(int fd, void* data, size_t n, uint64_t offset) {
+    uint8_t* p = static_cast<uint8_t*>(data);
+    while (n > 0) {
+        ssize_t r = ::pread(fd, p, n, static_cast<off_t>(offset));
+        if (r <= 0) throw ArchiveError("Failed to read move log");
+        p += r;
+        n -= static_cast<size_t>(r);
+        offset += static_cast<uint64_t>(r);
+    }
+}
+
+static void writeHeader(int fd, int shard, int shardCount, uint64_t base) {
+    LogHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, kLogMagic, sizeof(kLogMagic));
+    h.version = kLogVersion;
+    h.headerSize = sizeof(LogHeader);
+    h.shard = static_cast<uint32_t>(shard);
+    h.shardCount = static_cast<uint32_t>(shardCount);
+    h.base = base;
+    writeAll(fd, &h, sizeof(h), 0);
+}
+
+// A rename is only durable once its directory is synced
+static void syncDirectory(const std::string& path) {
+    size_t slash = path.rfind('/');
+    std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    int fd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) throw ArchiveError("Cannot open directory " + directory);
+    int synced = ::fsync(fd);
+    ::close(fd);
+    if (synced != 0) throw ArchiveError("Failed to sync directory " + directory);
+}
+
+// FNV-1a over 8-byte words with a fold after each: a torn or stale block fails it
+static uint32_t checksum(const uint8_t* data, size_t size) {
+    uint64_t hash = 14695981039346656037ull;
+    size_t k = 0;
+    for (; k + 8 <= size; k += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + k, sizeof(word));
+        hash = (hash ^ word) * 1099511628211ull;
+        hash ^= hash >> 32;
+    }
+    for (; k < size; ++k) hash = (hash ^ data[k]) * 1099511628211ull;
+    return static_cast<uint32_t>(hash ^ (hash >> 32));
+}
+
+MoveLog::MoveLog(const std::string& path, int shard, int shardCount)
+    : path(path), shard(shard), shardCount(shardCount), fd(-1), end(0), base(0), committed(0), mapped(nullptr),
+      mappedLength(0), readPos(0), blockEnd(0), readPosition(0), markOffset(0), markPosition(0), fresh(-1), copyEnd(0) {
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0) throw ArchiveError("Cannot open move log " + path);
+    auto fail = [&](const std::string& message) {
+        unmap();
+        ::close(fd);
+        throw ArchiveError(message);
+    };
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) fail("Cannot stat move log " + path);
+    size_t length = static_cast<size_t>(st.st_size);
+    if (length == 0) {
+        writeHeader(fd, shard, shardCount, 0);
+        if (::fdatasync(fd) != 0) fail("Failed to sync move log " + path);
+        end = sizeof(LogHeader);
+    } else {
+        if (length < sizeof(LogHeader)) fail("Not a move log: " + path);
+        void* p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) fail("Cannot map move log " + path);
+        mapped = static_cast<const uint8_t*>(p);
+        mappedLength = length;
+        ::madvise(p, length, MADV_SEQUENTIAL);
+
+        LogHeader h;
+        std::memcpy(&h, mapped, sizeof(h));
+        if (std::memcmp(h.magic, kLogMagic, sizeof(kLogMagic)) != 0 || h.version != kLogVersion ||
+            h.headerSize != sizeof(LogHeader)) {
+            fail("Not a move log: " + path);
+        }
+        if (h.shard != static_cast<uint32_t>(shard) || h.shardCount != static_cast<uint32_t>(shardCount)) {
+            fail("Move log " + path + " was written by shard " + std::to_string(h.shard) + " of " +
+                 std::to_string(h.shardCount));
+        }
+
+        // Whole blocks only: the last commit may have been cut short
+        base = committed = readPosition = h.base;
+        end = sizeof(h);
+        while (end + kBlockHeader <= length) {
+            uint32_t size, sum;
+            std::memcpy(&size, mapped + end, sizeof(size));
+            std::memcpy(&sum, mapped + end + sizeof(size), sizeof(sum));
+            if (size == 0 || size > length - end - kBlockHeader || checksum(mapped + end + kBlockHeader, size) != sum)
+                break;
+            end += kBlockHeader + size;
+            committed += size;
+        }
+        if (end < length && ::ftruncate(fd, static_cast<off_t>(end)) != 0) fail("Failed to truncate move log " + path);
+        readPos = blockEnd = sizeof(h);
+    }
+    markOffset = end;
+    markPosition = committed;
+    buffer.reserve(kBufferSize);
+    buffer.resize(kBlockHeader);
+}
+
+MoveLog::~MoveLog() {
+    try {
+        commit();
+    } catch (...) {}
+    unmap();
+    ::close(fd);
+    if (fresh >= 0) ::close(fresh);
+}
+
+void MoveLog::unmap() {
+    if (mapped) ::munmap(const_cast<uint8_t*>(mapped), mappedLength);
+    mapped = nullptr;
+}
+
+bool MoveLog::next(LogRecord& record, const uint8_t*& payload, uint64_t& position) {
+    if (!mapped) return false;
+    if (readPos == blockEnd) {
+        if (blockEnd == end) {
+            unmap();
+            return false;
+        }
+        uint32_t size;
+        std::memcpy(&size, mapped + blockEnd, sizeof(size));
+        readPos = blockEnd + kBlockHeader;
+        blockEnd = readPos + size;
+    }
+    if (blockEnd - readPos < sizeof(record)) throw ArchiveError("Bad record in move log");
+    std::memcpy(&record, mapped + readPos, sizeof(record));
+    size_t extra = record.type == LogRecord::Type::Open ? static_cast<size_t>(Table::kDealSize)
+                   : record.type == LogRecord::Type::Join ? record.value : 0;
+    if (blockEnd - readPos - sizeof(record) < extra) throw ArchiveError("Bad record in move log");
+    payload = mapped + readPos + sizeof(record);
+    position = readPosition;
+    readPos += sizeof(record) + extra;
+    readPosition += sizeof(record) + extra;
+    return true;
+}
+
+void MoveLog::append(const LogRecord& record, const void* payload, size_t size) {
+    size_t at = buffer.size();
+    buffer.resize(at + sizeof(record) + size);
+    std::memcpy(&buffer[at], &record, sizeof(record));
+    if (size > 0) std::memcpy(&buffer[at + sizeof(record)], payload, size);
+}
+
+void MoveLog::appendOpen(uint32_t table, int mode, int seats, const uint8_t* deal) {
+    LogRecord record{LogRecord::Type::Open, static_cast<uint8_t>(mode), static_cast<uint8_t>(seats), 0, table};
+    append(record, deal, Table::kDealSize);
+}
+
+void MoveLog::appendJoin(uint32_t table, int seat, std::string_view name) {
+    size_t length = name.size() < 255 ? name.size() : 255;
+    LogRecord record{LogRecord::Type::Join, static_cast<uint8_t>(seat), static_cast<uint8_t>(length), 0, table};
+    append(record, name.data(), length);
+}
+
+void MoveLog::appendMove(uint32_t table, int seat, int position) {
+    append(LogRecord{LogRecord::Type::Move, static_cast<uint8_t>(seat), static_cast<uint8_t>(position), 0, table},
+           nullptr, 0);
+}
+
+void MoveLog::appendTimeout(uint32_t table, int seat, bool forfeit) {
+    append(LogRecord{LogRecord::Type::Timeout, static_cast<uint8_t>(seat), static_cast<uint8_t>(forfeit), 0, table},
+           nullptr, 0);
+}
+
+void MoveLog::appendClose(uint32_t table) {
+    append(LogRecord{LogRecord::Type::Close, 0, 0, 0, table}, nullptr, 0);
+}
+
+void MoveLog::commit() {
+    if (!hasPending()) return;
+    uint32_t size = static_cast<uint32_t>(buffer.size() - kBlockHeader);
+    uint32_t sum = checksum(buffer.data() + kBlockHeader, size);
+    std::memcpy(buffer.data(), &size, sizeof(size));
+    std::memcpy(buffer.data() + sizeof(size), &sum, sizeof(sum));
+    writeAll(fd, buffer.data(), buffer.size(), end);
+    if (::fdatasync(fd) != 0) throw ArchiveError("Failed to sync move log");
+    // The new file may be renamed over the log any time now: it gets the block at the same place
+    if (fresh >= 0) {
+        writeAll(fresh, buffer.data(), buffer.size(), sizeof(LogHeader) + (end - markOffset));
+        if (::fdatasync(fresh) != 0) throw ArchiveError("Failed to sync move log");
+    }
+    end += buffer.size();
+    committed += size;
+    buffer.resize(kBlockHeader);
+}
+
+uint64_t MoveLog::mark() {
+    commit();
+    markOffset = end;
+    markPosition = committed;
+    return markPosition;
+}
+
+void MoveLog::beginTruncate() {
+    if (fresh >= 0) return;
+    commit();
+    unmap();
+    std::string temporary = path + ".tmp";
+    fresh = ::open(temporary.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fresh < 0) throw ArchiveError("Cannot create move log " + temporary);
+    copyEnd = end;
+}
+
+// Only reads what commit() no longer writes: the blocks before copyEnd
+void MoveLog::copyTail() {
+    if (fresh < 0) return;
+    uint64_t length = copyEnd - markOffset;
+    writeHeader(fresh, shard, shardCount, markPosition);
+    std::vector<uint8_t> chunk(length < kCopyChunk ? length : kCopyChunk);
+    for (uint64_t copied = 0; copied < length; copied += chunk.size()) {
+        if (length - copied < chunk.size()) chunk.resize(length - copied);
+        readAll(fd, chunk.data(), chunk.size(), markOffset + copied);
+        writeAll(fresh, chunk.data(), chunk.size(), sizeof(LogHeader) + copied);
+    }
+    std::string temporary = path + ".tmp";
+    if (::fdatasync(fresh) != 0 || ::rename(temporary.c_str(), path.c_str()) != 0) {
+        throw ArchiveError("Cannot replace move log " + path);
+    }
+    syncDirectory(path);
+}
+
+void MoveLog::endTruncate() {
+    if (fresh < 0) return;
+    ::close(fd);
+    fd = fresh;
+    fresh = -1;
+    end = sizeof(LogHeader) + (end - markOffset);
+    base = markPosition;
+    markOffset = sizeof(LogHeader);
+}
@@ -42,6 +42,10 @@ std::string sideToString(Side s) {
         case Side::bottom: return "bottom";
         case Side::left: return "left";
         case Side::right: return "right";
+        case Side::topLeft: return "top-left";
+        case Side::topRight: return "top-right";
+        case Side::bottomRight: return "bottom-right";
+        case Side::bottomLeft: return "bottom-left";
         default: return "";
     }
 }
@@ -0,0 +1,44 @@
+#include "Position.h"
+#include "Geometry.h"
+#include <string>
+
+static bool isBlank(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+PositionStatus parsePosition(std::string_view text, Letter& l, Number& n) noexcept {
+    size_t i = 0;
+    size_t end = text.size();
+    while (i < end && isBlank(text[i])) ++i;
+    while (end > i && isBlank(text[end - 1])) --end;
+    if (i == end) return PositionStatus::BadFormat;
+
+    // Setting bit 5 lower-cases ASCII letters and keeps everything else out of a-z
+    char letter = static_cast<char>(text[i++] | 0x20);
+    if (letter < 'a' || letter > 'z') return PositionStatus::BadFormat;
+
+    while (i < end && isBlank(text[i])) ++i;
+    if (i == end || text[i] < '0' || text[i] > '9') return PositionStatus::BadFormat;
+
+    int number = 0;
+    while (i < end && text[i] >= '0' && text[i] <= '9') {
+        if (number < 100) number = number * 10 + (text[i] - '0');
+        ++i;
+    }
+    if (i != end) return PositionStatus::BadFormat;
+
+    int row = letter - 'a';
+    int col = number - 1;
+    if (row >= StandardGeometry::kRows || col < 0 || col >= StandardGeometry::kCols) return PositionStatus::OutOfRange;
+    if (StandardGeometry::isHole(row, col)) return PositionStatus::Hole;
+
+    l = static_cast<Letter>(row);
+    n = static_cast<Number>(col);
+    return PositionStatus::Ok;
+}
+
+PositionStatus readPosition(std::istream& in, Letter& l, Number& n) {
+    std::string line;
+    if (!std::getline(in, line)) return PositionStatus::EndOfInput;
+    return parsePosition(line, l, n);
+}
@@ -0,0 +1,35 @@
+#include "Replay.h"
+#include "Exceptions.h"
+
+static_assert(sizeof(ReplayEvent) == 6, "ReplayEvent must stay packed");
+
+Replay::Replay(int nPlayers, int mode) {
+    clear(nPlayers, mode);
+}
+
+void Replay::clear(int nPlayers, int mode) {
+    this->nPlayers = static_cast<uint8_t>(nPlayers);
+    this->mode = static_cast<uint8_t>(mode);
+    std::memset(layout, kReplayNoPosition, sizeof(layout));
+    rubies.assign(nPlayers, 0);
+    events.clear();
+}
+
+size_t Replay::encodedSize() const {
+    return kReplayFixedBytes + nPlayers + events.size() * sizeof(ReplayEvent);
+}
+
+void Replay::encode(uint8_t* out) const {
+    if (events.size() > 0xFFFF) throw ArchiveError("Too many events in replay");
+    uint32_t size = static_cast<uint32_t>(encodedSize());
+    std::memcpy(out, &size, sizeof(size));
+    out[4] = nPlayers;
+    out[5] = mode;
+    out[6] = static_cast<uint8_t>(events.size() & 0xFF);
+    out[7] = static_cast<uint8_t>(events.size() >> 8);
+    std::memcpy(out + 8, layout, kReplayCells);
+    std::memcpy(out + kReplayFixedBytes, rubies.data(), nPlayers);
+    if (!events.empty()) {
+        std::memcpy(out + kReplayFixedBytes + nPlayers, events.data(), events.size() * sizeof(ReplayEvent));
+    }
+}
@@ -0,0 +1,198 @@
+#include "ReplayArchive.h"
+#include "Exceptions.h"
+#include <cstring>
+#include <string>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char kArchiveMagic[8] = {'M', 'E', 'M', 'O', 'A', 'R', 'C', '\0'};
+static const uint32_t kArchiveVersion = 1;
+static const size_t kWriteBufferSize = 1 << 20;
+
+static_assert(sizeof(ArchiveHeader) == 64, "ArchiveHeader must stay 64 bytes");
+
+static void writeAll(int fd, const void* data, size_t n, uint64_t offset) {
+    const uint8_t* p = static_cast<const uint8_t*>(data);
+    while (n > 0) {
+        ssize_t w = ::pwrite(fd, p, n, static_cast<off_t>(offset));
+        if (w <= 0) throw ArchiveError("Failed to write archive");
+        p += w;
+        n -= static_cast<size_t>(w);
+        offset += static_cast<uint64_t>(w);
+    }
+}
+
+static void readAll(int fd, void* data, size_t n, uint64_t offset) {
+    uint8_t* p = static_cast<uint8_t*>(data);
+    while (n > 0) {
+        ssize_t r = ::pread(fd, p, n, static_cast<off_t>(offset));
+        if (r <= 0) throw ArchiveError("Failed to read archive");
+        p += r;
+        n -= static_cast<size_t>(r);
+        offset += static_cast<uint64_t>(r);
+    }
+}
+
+static bool validHeader(const ArchiveHeader& h, uint64_t fileSize) {
+    return std::memcmp(h.magic, kArchiveMagic, sizeof(kArchiveMagic)) == 0 &&
+           h.version == kArchiveVersion &&
+           h.headerSize == sizeof(ArchiveHeader) &&
+           h.indexOffset >= h.headerSize && h.indexOffset <= fileSize &&
+           h.gameCount <= (fileSize - h.indexOffset) / sizeof(uint64_t);
+}
+
+static void syncAll(int fd) {
+    if (::fsync(fd) != 0) throw ArchiveError("Failed to sync archive");
+}
+
+// -------------------
+// Writer
+// -------------------
+ReplayArchiveWriter::ReplayArchiveWriter(const std::string& path) : fd(-1), dataEnd(0), stored(0) {
+    fd = ::open(path.c_str(), O_RDWR | O_CREAT, 0644);
+    if (fd < 0) throw ArchiveError("Cannot open archive " + path);
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        ::close(fd);
+        throw ArchiveError("Cannot stat archive " + path);
+    }
+
+    if (st.st_size == 0) {
+        dataEnd = sizeof(ArchiveHeader);
+    } else {
+        ArchiveHeader h;
+        if (static_cast<uint64_t>(st.st_size) < sizeof(h)) {
+            ::close(fd);
+            throw ArchiveError("Truncated archive " + path);
+        }
+        readAll(fd, &h, sizeof(h), 0);
+        if (!validHeader(h, static_cast<uint64_t>(st.st_size))) {
+            ::close(fd);
+            throw ArchiveError("Not a replay archive: " + path);
+        }
+        index.resize(h.gameCount);
+        if (h.gameCount > 0) readAll(fd, index.data(), h.gameCount * sizeof(uint64_t), h.indexOffset);
+        // The old index stays live until close: new records go after it
+        stored = h.gameCount;
+        dataEnd = h.indexOffset + h.gameCount * sizeof(uint64_t);
+    }
+    buffer.reserve(kWriteBufferSize);
+}
+
+ReplayArchiveWriter::~ReplayArchiveWriter() {
+    try {
+        close();
+    } catch (...) {}
+}
+
+void ReplayArchiveWriter::flushBuffer() {
+    if (buffer.empty()) return;
+    writeAll(fd, buffer.data(), buffer.size(), dataEnd);
+    dataEnd += buffer.size();
+    buffer.clear();
+}
+
+void ReplayArchiveWriter::append(const Replay& replay) {
+    if (fd < 0) throw ArchiveError("Archive is closed");
+    size_t n = replay.encodedSize();
+    if (buffer.size() + n > kWriteBufferSize) flushBuffer();
+
+    index.push_back(dataEnd + buffer.size());
+    size_t at = buffer.size();
+    buffer.resize(at + n);
+    replay.encode(buffer.data() + at);
+}
+
+void ReplayArchiveWriter::close() {
+    if (fd < 0) return;
+    if (stored > 0 && index.size() == stored) {
+        // Nothing appended: the archive is as it was
+        ::close(fd);
+        fd = -1;
+        return;
+    }
+    flushBuffer();
+
+    // Records and index first, so the header never points at anything unwritten
+    if (!index.empty()) writeAll(fd, index.data(), index.size() * sizeof(uint64_t), dataEnd);
+    if (::ftruncate(fd, static_cast<off_t>(dataEnd + index.size() * sizeof(uint64_t))) != 0) {
+        throw ArchiveError("Failed to truncate archive");
+    }
+    syncAll(fd);
+
+    ArchiveHeader h;
+    std::memset(&h, 0, sizeof(h));
+    std::memcpy(h.magic, kArchiveMagic, sizeof(kArchiveMagic));
+    h.version = kArchiveVersion;
+    h.headerSize = sizeof(ArchiveHeader);
+    h.gameCount = index.size();
+    h.indexOffset = dataEnd;
+    writeAll(fd, &h, sizeof(h), 0);
+    syncAll(fd);
+
+    ::close(fd);
+    fd = -1;
+}
+
+// -------------------
+// Reader
+// -------------------
+ReplayArchive::ReplayArchive(const std::string& path) : base(nullptr), length(0), header(nullptr) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw ArchiveError("Cannot open archive " + path);
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0 || static_cast<size_t>(st.st_size) < sizeof(ArchiveHeader)) {
+        ::close(fd);
+        throw ArchiveError("Not a replay archive: " + path);
+    }
+    length = static_cast<size_t>(st.st_size);
+
+    void* p = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) throw ArchiveError("Cannot map archive " + path);
+    ::madvise(p, length, MADV_SEQUENTIAL);
+
+    base = static_cast<const uint8_t*>(p);
+    header = reinterpret_cast<const ArchiveHeader*>(base);
+    if (!validHeader(*header, length)) {
+        ::munmap(p, length);
+        throw ArchiveError("Not a replay archive: " + path);
+    }
+}
+
+ReplayArchive::~ReplayArchive() {
+    if (base) ::munmap(const_cast<uint8_t*>(base), length);
+}
+
+ReplayArchive::ReplayArchive(ReplayArchive&& other) noexcept
+    : base(other.base), length(other.length), header(other.header) {
+    other.base = nullptr;
+    other.length = 0;
+    other.header = nullptr;
+}
+
+ReplayView ReplayArchive::record(uint64_t i) const {
+    uint64_t offset;
+    std::memcpy(&offset, base + header->indexOffset + i * sizeof(uint64_t), sizeof(offset));
+    uint64_t dataEnd = header->indexOffset;
+    if (offset < header->headerSize || offset > dataEnd || dataEnd - offset < kReplayFixedBytes) {
+        throw ArchiveError("Corrupt replay archive: bad offset of game " + std::to_string(i));
+    }
+    // The size must be what the counts it covers add up to, and fit before the index
+    ReplayView view(base + offset);
+    uint64_t size = view.size();
+    if (size != kReplayFixedBytes + view.getNPlayers() + view.getNEvents() * sizeof(ReplayEvent) ||
+        size > dataEnd - offset) {
+        throw ArchiveError("Corrupt replay archive: bad record of game " + std::to_string(i));
+    }
+    return view;
+}
+
+ReplayView ReplayArchive::operator[](uint64_t i) const {
+    if (i >= header->gameCount) throw OutOfRange("Replay index out of range");
+    return record(i);
+}
@@ -0,0 +1,290 @@
+#include "ReplayQuery.h"
+#include "Player.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+static const size_t kScanBlock = 4096;
+
+static const char* const kColumnNames[kEventColumns] = {"round",  "reveal",     "seat",    "card",
+                                                        "animal", "background", "matched", "effect"};
+static const char* const kAnimalNames[5] = {"crab", "penguin", "octopus", "turtle", "walrus"};
+static const char* const kBackgroundNames[5] = {"red", "green", "purple", "blue", "yellow"};
+static const char* const kEffectNames[7] = {"none", "swap", "turn_down", "block", "play_again", "skip_next", "award"};
+
+static int threadCount(int requested, size_t work) {
+    int n = requested > 0 ? requested : static_cast<int>(std::thread::hardware_concurrency());
+    if (n < 1) n = 1;
+    if (work < static_cast<size_t>(n)) n = std::max<int>(1, static_cast<int>(work));
+    return n;
+}
+
+// Runs fn(t, begin, end) on nThreads contiguous slices of [0, total)
+template <typename Fn>
+static void parallelFor(int nThreads, size_t total, Fn fn) {
+    std::vector<std::thread> workers;
+    size_t chunk = (total + nThreads - 1) / nThreads;
+    for (int t = 0; t < nThreads; ++t) {
+        size_t begin = std::min(total, chunk * t);
+        size_t end = std::min(total, begin + chunk);
+        workers.emplace_back(fn, t, begin, end);
+    }
+    for (auto& w : workers) w.join();
+}
+
+// mask[k] &= (column[k] == value); the column never overlaps the mask
+static inline void filterEquals(uint8_t* __restrict mask, const uint8_t* __restrict column, uint8_t value,
+                                size_t len) {
+    for (size_t k = 0; k < len; ++k) mask[k] &= static_cast<uint8_t>(column[k] == value);
+}
+
+// -------------------
+// Column building
+// -------------------
+EventColumns EventColumns::fromArchive(const ReplayArchive& archive, int nThreads) {
+    // First pass only reads record headers to find where each game's rows start
+    size_t nGames = archive.size();
+    std::vector<size_t> firstRow(nGames + 1, 0);
+    EventColumns table;
+    table.games = nGames;
+    size_t g = 0;
+    for (ReplayView view : archive) {
+        firstRow[g + 1] = firstRow[g] + view.getNEvents();
+        // The winners hold the most rubies at the end of the game
+        int seats = std::min(view.getNPlayers(), kQuerySeats);
+        int most = 0;
+        for (int seat = 0; seat < seats; ++seat) most = std::max(most, view.getRubies(seat));
+        for (int seat = 0; seat < seats; ++seat) {
+            ++table.seatGames[seat];
+            if (view.getRubies(seat) == most) ++table.seatWins[seat];
+        }
+        ++g;
+    }
+
+    for (auto& column : table.columns) column.resize(firstRow[nGames]);
+
+    parallelFor(threadCount(nThreads, nGames), nGames, [&](int, size_t begin, size_t end) {
+        uint8_t* round = table.columns[int(EventColumn::Round)].data();
+        uint8_t* reveal = table.columns[int(EventColumn::Reveal)].data();
+        uint8_t* seat = table.columns[int(EventColumn::Seat)].data();
+        uint8_t* card = table.columns[int(EventColumn::Card)].data();
+        uint8_t* animal = table.columns[int(EventColumn::Animal)].data();
+        uint8_t* background = table.columns[int(EventColumn::Background)].data();
+        uint8_t* matched = table.columns[int(EventColumn::Matched)].data();
+        uint8_t* effect = table.columns[int(EventColumn::Effect)].data();
+
+        for (size_t game = begin; game < end; ++game) {
+            ReplayView view = archive[game];
+            size_t row = firstRow[game];
+            int currentRound = -1;
+            int nthReveal = 0;
+            for (size_t i = 0; i < view.getNEvents(); ++i, ++row) {
+                ReplayEvent e = view.getEvent(i);
+                if (e.round != currentRound) {
+                    currentRound = e.round;
+                    nthReveal = 0;
+                }
+                bool award = e.effect() == ReplayEffect::Award;
+                round[row] = e.round;
+                reveal[row] = award ? 0 : static_cast<uint8_t>(++nthReveal);
+                seat[row] = e.seat;
+                card[row] = e.card;
+                animal[row] = award ? kReplayNoPosition : static_cast<uint8_t>(e.card / 5);
+                background[row] = award ? kReplayNoPosition : static_cast<uint8_t>(e.card % 5);
+                matched[row] = e.matched() ? 1 : 0;
+                effect[row] = static_cast<uint8_t>(e.effect());
+            }
+        }
+    });
+    return table;
+}
+
+// -------------------
+// Queries
+// -------------------
+EventQuery& EventQuery::where(EventColumn column, int value) {
+    filters.push_back({column, static_cast<uint8_t>(value)});
+    return *this;
+}
+
+EventQuery& EventQuery::groupBy(EventColumn column) {
+    grouped = true;
+    groupColumn = column;
+    return *this;
+}
+
+std::vector<GroupStats> EventQuery::run(const EventColumns& table, int nThreads) const {
+    size_t total = table.size();
+    int n = threadCount(nThreads, total / kScanBlock + 1);
+    std::vector<std::vector<GroupStats>> partial(n, std::vector<GroupStats>(256));
+
+    parallelFor(n, total, [&](int t, size_t begin, size_t end) {
+        const uint8_t* matched = table.get(EventColumn::Matched).data();
+        const uint8_t* group = table.get(groupColumn).data();
+        uint64_t counts[256] = {};
+        uint64_t hits[256] = {};
+        uint8_t mask[kScanBlock];
+
+        // Column-at-a-time filtering into a byte mask. Inlined with len the
+        // constant kScanBlock, the filter and ungrouped count loops vectorize at -O2.
+        auto scan = [&](size_t start, size_t len) {
+            std::fill(mask, mask + len, uint8_t(1));
+            for (const auto& f : filters) filterEquals(mask, table.get(f.column).data() + start, f.value, len);
+
+            const uint8_t* m = matched + start;
+            if (grouped) {
+                const uint8_t* key = group + start;
+                for (size_t k = 0; k < len; ++k) {
+                    counts[key[k]] += mask[k];
+                    hits[key[k]] += mask[k] & m[k];
+                }
+            } else {
+                uint32_t c = 0, h = 0;
+                for (size_t k = 0; k < len; ++k) {
+                    c += mask[k];
+                    h += mask[k] & m[k];
+                }
+                counts[0] += c;
+                hits[0] += h;
+            }
+        };
+        size_t start = begin;
+        for (; end - start >= kScanBlock; start += kScanBlock) scan(start, kScanBlock);
+        if (start < end) scan(start, end - start);
+
+        for (int k = 0; k < 256; ++k) {
+            partial[t][k].count = counts[k];
+            partial[t][k].matched = hits[k];
+        }
+    });
+
+    std::vector<GroupStats> result(256);
+    for (const auto& p : partial) {
+        for (int k = 0; k < 256; ++k) {
+            result[k].count += p[k].count;
+            result[k].matched += p[k].matched;
+        }
+    }
+
+    size_t used = 1;
+    for (size_t k = 0; k < result.size(); ++k) {
+        if (result[k].count) used = k + 1;
+    }
+    result.resize(used);
+    return result;
+}
+
+// -------------------
+// Query mode
+// -------------------
+static bool parseColumn(const std::string& name, EventColumn& column) {
+    for (int c = 0; c < kEventColumns; ++c) {
+        if (name == kColumnNames[c]) {
+            column = static_cast<EventColumn>(c);
+            return true;
+        }
+    }
+    return false;
+}
+
+static int findName(const char* const* names, int count, const std::string& name) {
+    for (int k = 0; k < count; ++k) {
+        if (name == names[k]) return k;
+    }
+    return -1;
+}
+
+// A number, or the name of an animal, background or effect in that column
+static int parseValue(EventColumn column, const std::string& text) {
+    int named = -1;
+    if (column == EventColumn::Animal) named = findName(kAnimalNames, 5, text);
+    else if (column == EventColumn::Background) named = findName(kBackgroundNames, 5, text);
+    else if (column == EventColumn::Effect) named = findName(kEffectNames, 7, text);
+    for (int seat = 0; column == EventColumn::Seat && seat < kQuerySeats && named < 0; ++seat) {
+        if (text == sideToString(static_cast<Side>(seat))) named = seat;
+    }
+    if (named >= 0) return named;
+    char* end = nullptr;
+    long value = std::strtol(text.c_str(), &end, 10);
+    if (text.empty() || *end != '\0' || value < 0 || value > 255) return -1;
+    return static_cast<int>(value);
+}
+
+static std::string keyName(EventColumn column, int key) {
+    if (column == EventColumn::Animal && key < 5) return kAnimalNames[key];
+    if (column == EventColumn::Background && key < 5) return kBackgroundNames[key];
+    if (column == EventColumn::Effect && key < 7) return kEffectNames[key];
+    if (column == EventColumn::Seat && key < kQuerySeats) return sideToString(static_cast<Side>(key));
+    return std::to_string(key);
+}
+
+bool EventQuery::parseArgs(int argc, char* argv[], QueryOptions& options) {
+    if (argc < 3 || std::string(argv[1]) != "--query") return false;
+    options.archivePath = argv[2];
+    for (int i = 3; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--where" && hasValue) {
+            std::string filter = argv[++i];
+            size_t equals = filter.find('=');
+            EventColumn column;
+            if (equals == std::string::npos || !parseColumn(filter.substr(0, equals), column)) return false;
+            int value = parseValue(column, filter.substr(equals + 1));
+            if (value < 0) return false;
+            options.query.where(column, value);
+        } else if (arg == "--group-by" && hasValue) {
+            EventColumn column;
+            if (!parseColumn(argv[++i], column)) return false;
+            options.query.groupBy(column);
+        } else if (arg == "--threads" && hasValue) {
+            options.threads = std::atoi(argv[++i]);
+            if (options.threads < 1) return false;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+int EventQuery::report(const QueryOptions& options, std::ostream& out) {
+    ReplayArchive archive(options.archivePath);
+    auto start = std::chrono::steady_clock::now();
+    EventColumns table = EventColumns::fromArchive(archive, options.threads);
+    auto loaded = std::chrono::steady_clock::now();
+    std::vector<GroupStats> result = options.query.run(table, options.threads);
+    auto done = std::chrono::steady_clock::now();
+
+    char line[160];
+    std::snprintf(line, sizeof(line), "%llu events in %llu games (columns %.3f s, query %.3f s)\n",
+                  static_cast<unsigned long long>(table.size()), static_cast<unsigned long long>(table.getGames()),
+                  std::chrono::duration<double>(loaded - start).count(),
+                  std::chrono::duration<double>(done - loaded).count());
+    out << line;
+
+    const EventQuery& query = options.query;
+    bool bySeat = query.isGrouped() && query.getGroupColumn() == EventColumn::Seat;
+    for (size_t key = 0; key < result.size(); ++key) {
+        const GroupStats& stats = result[key];
+        if (query.isGrouped() && stats.count == 0) continue;
+        std::string name = query.isGrouped()
+                               ? std::string(kColumnNames[static_cast<int>(query.getGroupColumn())]) + " " +
+                                     keyName(query.getGroupColumn(), static_cast<int>(key))
+                               : std::string("all");
+        std::snprintf(line, sizeof(line), "%s: %llu events, %llu matched (%.1f%%)", name.c_str(),
+                      static_cast<unsigned long long>(stats.count), static_cast<unsigned long long>(stats.matched),
+                      100.0 * stats.matchRate());
+        out << line;
+        // Per Side, the games it won of those it played
+        int seat = static_cast<int>(key);
+        if (bySeat && seat < kQuerySeats && table.getGamesPlayed(seat) > 0) {
+            std::snprintf(line, sizeof(line), ", won %llu of %llu games (%.1f%%)",
+                          static_cast<unsigned long long>(table.getGamesWon(seat)),
+                          static_cast<unsigned long long>(table.getGamesPlayed(seat)), 100.0 * table.winRate(seat));
+            out << line;
+        }
+        out << "\n";
+    }
+    return 0;
+}
@@ -1,6 +1,9 @@
 #include "RubisDeck.h"
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
-RubisDeck* RubisDeck::instance = nullptr;
+thread_local RubisDeck* RubisDeck::instance = nullptr;
 
 RubisDeck::RubisDeck() {
     // 3 with 1, 2 with 2, 1 with 3, 1 with 4
@@ -17,3 +20,32 @@ RubisDeck& RubisDeck::make_RubisDeck() {
     }
     return *instance;
 }
+
+int RubisDeck::getOrder(uint8_t* values, int capacity) const {
+    for (size_t k = 0; k < deck.size() && k < static_cast<size_t>(capacity); ++k) {
+        values[k] = static_cast<uint8_t>(static_cast<int>(*deck[k]));
+    }
+    return static_cast<int>(currentIndex);
+}
+
+void RubisDeck::setOrder(const uint8_t* values, int count, int drawn) {
+    // Rubis of equal value are interchangeable, so reorder the deck to match
+    for (size_t k = 0; k < deck.size() && k < static_cast<size_t>(count); ++k) {
+        size_t match = k;
+        while (match < deck.size() && static_cast<int>(*deck[match]) != values[k]) ++match;
+        if (match == deck.size()) throw std::invalid_argument("Rubis order does not match the deck");
+        std::swap(deck[k], deck[match]);
+    }
+    currentIndex = static_cast<size_t>(drawn);
+}
+
+bool RubisDeck::matchesOrder(const uint8_t* values, int count) const {
+    std::vector<bool> used(deck.size(), false);
+    for (size_t k = 0; k < deck.size() && k < static_cast<size_t>(count); ++k) {
+        size_t match = 0;
+        while (match < deck.size() && (used[match] || static_cast<int>(*deck[match]) != values[k])) ++match;
+        if (match == deck.size()) return false;
+        used[match] = true;
+    }
+    return true;
+}
@@ -0,0 +1,199 @@
+#include "ScriptRunner.h"
+#include "GameEngine.h"
+#include "CardDeck.h"
+#include "RubisDeck.h"
+#include "ReplayArchive.h"
+#include "Position.h"
+#include "Instrumentation.h"
+#include "Tracer.h"
+#include <chrono>
+#include <fstream>
+#include <iterator>
+#include <string_view>
+#include <stdexcept>
+#include <memory>
+
+static const uint8_t kUnreadable = 0xFF;
+
+static uint8_t parseMove(std::string_view token) {
+    Letter l;
+    Number n;
+    PositionStatus status = parsePosition(token, l, n);
+    // A hole is rejected by the engine like any other hole pick
+    if (status == PositionStatus::Hole) return static_cast<uint8_t>(Board::Geometry::kFirstHole);
+    if (status != PositionStatus::Ok) return kUnreadable;
+    return static_cast<uint8_t>(Board::Geometry::index(static_cast<int>(l), static_cast<int>(n)));
+}
+
+// Splits off the next whitespace separated token of line
+static std::string_view nextToken(std::string_view& line) {
+    size_t begin = line.find_first_not_of(" \t\r");
+    if (begin == std::string_view::npos) {
+        line = std::string_view();
+        return line;
+    }
+    size_t end = line.find_first_of(" \t\r", begin);
+    if (end == std::string_view::npos) end = line.size();
+    std::string_view token = line.substr(begin, end - begin);
+    line.remove_prefix(end);
+    return token;
+}
+
+ScriptRunner::ScriptRunner(const ScriptOptions& options) : options(options), mode(-1), powers(kStandardPowers) {
+    load();
+}
+
+void ScriptRunner::load() {
+    std::ifstream in(options.scriptPath, std::ios::binary);
+    if (!in) throw std::runtime_error("Cannot open script " + options.scriptPath);
+    std::string text((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+
+    // One pass over the buffer, no per-line copies
+    std::string_view rest(text);
+    while (!rest.empty()) {
+        size_t eol = rest.find('\n');
+        std::string_view line = rest.substr(0, eol);
+        rest.remove_prefix(eol == std::string_view::npos ? rest.size() : eol + 1);
+
+        size_t comment = line.find('#');
+        if (comment != std::string_view::npos) line = line.substr(0, comment);
+
+        std::string_view word = nextToken(line);
+        if (word.empty()) continue;
+
+        if (word == "mode") {
+            std::string_view version = nextToken(line);
+            if (version == "base") mode = 0;
+            else if (version == "expert_display") mode = 1;
+            else if (version == "expert_rules") mode = 2;
+            else throw std::runtime_error("Unknown mode: " + std::string(version));
+        } else if (word == "powers") {
+            if (!Rules::parsePowers(line, powers)) throw std::runtime_error("Bad powers line");
+        } else if (word == "players") {
+            names.clear();
+            for (std::string_view name = nextToken(line); !name.empty(); name = nextToken(line)) {
+                names.push_back(std::string(name));
+            }
+        } else {
+            for (; !word.empty(); word = nextToken(line)) moves.push_back(parseMove(word));
+        }
+    }
+
+    if (mode < 0) throw std::runtime_error("Script has no mode line");
+    if (!Rules::parsePowers(options.powers, powers)) throw std::runtime_error("Bad powers: " + options.powers);
+    if (names.size() < 2 || names.size() > static_cast<size_t>(Game::kMaxSeats))
+        throw std::runtime_error("Script needs 2-8 players");
+}
+
+bool ScriptRunner::playOne(std::ostream& out, Replay* replay, std::vector<int>& rubies) {
+    return dispatchRules(mode, [&](auto policy) { return playGame<decltype(policy)>(out, replay, rubies); });
+}
+
+template <typename Policy>
+bool ScriptRunner::playGame(std::ostream& out, Replay* replay, std::vector<int>& rubies) {
+    CardDeck& cardDeck = CardDeck::make_CardDeck();
+    RubisDeck& rubisDeck = RubisDeck::make_RubisDeck();
+    CardDeck::seed(options.seed);
+    cardDeck.shuffle();
+    RubisDeck::seed(options.seed);
+    rubisDeck.shuffle();
+
+    Game game(cardDeck, Policy::expertDisplay);
+    Rules rules(powers);
+    for (size_t i = 0; i < names.size(); ++i) {
+        game.addPlayer(Player(names[i], static_cast<Side>(i)));
+    }
+
+    GameEngine<Policy> engine(game, rules, rubisDeck);
+    engine.setRecorder(replay);
+
+    size_t next = 0;
+    bool complete = true;
+    while (complete && !engine.isGameOver()) {
+        engine.startRound();
+        if (options.render) out << "\n========== ROUND " << game.getRound() << " ==========\n";
+
+        while (!engine.isRoundOver()) {
+            if (next >= moves.size()) {
+                complete = false;
+                break;
+            }
+            uint8_t move = moves[next++];
+            // An unreadable target skips the effect, as in the console
+            if (engine.isAwaitingTarget() && move == kUnreadable) move = Board::Geometry::kFirstHole;
+            Letter l = static_cast<Letter>(Board::Geometry::rowOf(move));
+            Number n = static_cast<Number>(Board::Geometry::colOf(move));
+            if (engine.isAwaitingTarget()) {
+                engine.target(l, n);
+            } else if (move != kUnreadable) {
+                engine.pick(l, n);
+            }
+            if (options.render) out << "\n" << game << "\n";
+        }
+
+        if (complete) engine.finishRound();
+    }
+
+    rubies.clear();
+    for (const auto& p : game.getPlayers()) rubies.push_back(p.getNRubies());
+    return complete;
+}
+
+int ScriptRunner::run(std::ostream& out) {
+    std::unique_ptr<ReplayArchiveWriter> archive;
+    if (!options.archivePath.empty()) archive.reset(new ReplayArchiveWriter(options.archivePath));
+
+    Replay replay;
+    std::vector<int> rubies;
+    int completeGames = 0;
+    if (!options.tracePath.empty()) Tracer::start();
+    auto start = std::chrono::steady_clock::now();
+
+    for (int g = 1; g <= options.repeat; ++g) {
+        bool complete = playOne(out, archive ? &replay : nullptr, rubies);
+        if (complete) {
+            ++completeGames;
+            if (archive) archive->append(replay);
+        }
+
+        if (!options.quiet) {
+            out << "Game " << g << ":";
+            for (size_t i = 0; i < names.size(); ++i) out << " " << names[i] << " " << rubies[i];
+            if (!complete) out << " (incomplete: script ran out of moves)";
+            out << "\n";
+        }
+    }
+
+    if (archive) archive->close();
+    if (!options.tracePath.empty()) {
+        Tracer::stop();
+        if (!Tracer::write(options.tracePath)) out << "Cannot write trace " << options.tracePath << "\n";
+    }
+
+    auto elapsed = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+    out << options.repeat << " games, " << completeGames << " complete, "
+        << elapsed.count() / 1000.0 << " ms\n";
+    MEMO_DUMP(std::cerr);
+    return completeGames == options.repeat ? 0 : 2;
+}
+
+bool ScriptRunner::parseArgs(int argc, char* argv[], ScriptOptions& options) {
+    try {
+        for (int i = 1; i < argc; ++i) {
+            std::string arg = argv[i];
+            bool hasValue = i + 1 < argc;
+            if (arg == "--script" && hasValue) options.scriptPath = argv[++i];
+            else if (arg == "--seed" && hasValue) options.seed = static_cast<unsigned>(std::stoul(argv[++i]));
+            else if (arg == "--repeat" && hasValue) options.repeat = std::stoi(argv[++i]);
+            else if (arg == "--archive" && hasValue) options.archivePath = argv[++i];
+            else if (arg == "--trace" && hasValue) options.tracePath = argv[++i];
+            else if (arg == "--powers" && hasValue) options.powers = argv[++i];
+            else if (arg == "--render") options.render = true;
+            else if (arg == "--quiet") options.quiet = true;
+            else return false;
+        }
+    } catch (const std::exception&) {
+        return false;
+    }
+    return !options.scriptPath.empty() && options.repeat > 0;
+}
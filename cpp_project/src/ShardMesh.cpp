@@ -0,0 +1,44 @@
+#include "ShardMesh.h"
+#include "Exceptions.h"
+#include "Game.h"
+#include <cerrno>
+#include <cstring>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+ShardMesh::ShardMesh(int count)
+    : count(count), matchmaker(Game::kMaxSeats, kTicketCapacity, Matchmaker::clientLimit()) {
+    for (int k = 0; k < count * count; ++k) queues.emplace_back(new SpscQueue<Handoff>(kQueueCapacity));
+    for (int shard = 0; shard < count; ++shard) {
+        int fd = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        if (fd < 0) {
+            for (int open : wakeFds) ::close(open);
+            throw ServerError(std::string("eventfd: ") + std::strerror(errno));
+        }
+        wakeFds.push_back(fd);
+    }
+}
+
+ShardMesh::~ShardMesh() {
+    Handoff handoff;
+    for (int from = 0; from < count; ++from) {
+        for (int to = 0; to < count; ++to) {
+            while (pop(from, to, handoff)) {
+                if (handoff.ownsSocket()) ::close(handoff.fd);
+            }
+        }
+    }
+    for (int fd : wakeFds) ::close(fd);
+}
+
+bool ShardMesh::push(int from, int to, Handoff& handoff) {
+    if (!queues[from * count + to]->push(handoff)) return false;
+    wake(to);
+    return true;
+}
+
+void ShardMesh::wake(int shard) {
+    uint64_t one = 1;
+    ssize_t written = ::write(wakeFds[shard], &one, sizeof(one)); // EAGAIN: already pending
+    (void)written;
+}
@@ -0,0 +1,73 @@
+#include "ShardedServer.h"
+#include "Exceptions.h"
+#include <pthread.h>
+#include <sched.h>
+#include <thread>
+#include <vector>
+
+static int shardCount(const ServerOptions& options) {
+    if (options.shards > 0) return options.shards;
+    unsigned cores = std::thread::hardware_concurrency();
+    return cores > 0 ? static_cast<int>(cores) : 1;
+}
+
+ShardedServer::ShardedServer(const ServerOptions& options)
+    : options(options), mesh(shardCount(options)), shards(mesh.size(), nullptr), stopping(false) {}
+
+void ShardedServer::runShard(int shard, std::string& failure) {
+    // One core per shard, so its tables stay in that core's caches
+    unsigned cores = std::thread::hardware_concurrency();
+    if (cores > 0) {
+        cpu_set_t cpus;
+        CPU_ZERO(&cpus);
+        CPU_SET(static_cast<unsigned>(shard) % cores, &cpus);
+        pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+    }
+
+    // Unpublishes the shard's server before it is destroyed, however run() ends
+    struct Unpublish {
+        ShardedServer& owner;
+        int shard;
+        ~Unpublish() {
+            std::lock_guard<std::mutex> lock(owner.mutex);
+            owner.shards[shard] = nullptr;
+        }
+    };
+
+    try {
+        // Built on this thread: the decks it takes are this thread's
+        GameServer server(options, &mesh, shard);
+        Unpublish unpublish{*this, shard};
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            shards[shard] = &server;
+            if (stopping) server.stop();
+        }
+        server.run();
+    } catch (const std::exception& error) {
+        failure = error.what();
+        stop();
+    }
+}
+
+int ShardedServer::run() {
+    std::vector<std::string> failures(mesh.size());
+    std::vector<std::thread> threads;
+    for (int shard = 0; shard < mesh.size(); ++shard) {
+        threads.emplace_back(&ShardedServer::runShard, this, shard, std::ref(failures[shard]));
+    }
+    for (std::thread& thread : threads) thread.join();
+    for (const std::string& failure : failures) {
+        if (!failure.empty()) throw ServerError(failure);
+    }
+    return 0;
+}
+
+void ShardedServer::stop() {
+    std::lock_guard<std::mutex> lock(mutex);
+    stopping = true;
+    for (int shard = 0; shard < mesh.size(); ++shard) {
+        if (shards[shard]) shards[shard]->stop();
+        mesh.wake(shard);
+    }
+}
@@ -0,0 +1,149 @@
+#include "Snapshot.h"
+#include "Game.h"
+#include "CardDeck.h"
+#include "RubisDeck.h"
+#include "Exceptions.h"
+#include <cstring>
+#include <fstream>
+
+static const char kSnapshotMagic[4] = {'M', 'S', 'N', 'P'};
+static const uint8_t kSnapshotVersion = 2; // 2: eight seats
+
+static_assert(sizeof(SnapshotPlayer) == 32, "SnapshotPlayer must stay 32 bytes");
+static_assert(sizeof(GameSnapshot) == 308, "GameSnapshot must stay fixed size");
+static_assert(sizeof(GameSnapshot::layout) == Board::Geometry::kCells, "snapshots hold the standard board");
+
+GameSnapshot::GameSnapshot() {
+    std::memset(this, 0, sizeof(*this));
+    std::memcpy(magic, kSnapshotMagic, sizeof(magic));
+    version = kSnapshotVersion;
+}
+
+bool GameSnapshot::isValid() const {
+    using Geometry = Board::Geometry;
+    if (std::memcmp(magic, kSnapshotMagic, sizeof(magic)) != 0 || version != kSnapshotVersion ||
+        nPlayers > kSnapshotMaxPlayers || mode > 2 || round > 7 || rubisNext > 7 || pickedPosition >= Geometry::kCells ||
+        (turnFlags >> kSnapshotSkippedShift) > nPlayers) {
+        return false;
+    }
+    // Restoring indexes seats and cells with these; a table still empty has seat 0 on turn
+    if (turnPlayer != 0 && turnPlayer >= nPlayers) return false;
+    if (blockedPosition != kSnapshotNone &&
+        !Geometry::isCell(Geometry::rowOf(blockedPosition), Geometry::colOf(blockedPosition))) {
+        return false;
+    }
+    for (int k = 0; k < nPlayers; ++k) {
+        if (players[k].side >= kSnapshotMaxPlayers) return false; // one seat per Side
+    }
+    return true;
+}
+
+void GameSnapshot::save(const Game& game, const RubisDeck& rubisDeck) {
+    if (game.players.size() > static_cast<size_t>(kSnapshotMaxPlayers))
+        throw SnapshotError("Too many players for a snapshot");
+
+    round = static_cast<uint8_t>(game.round);
+    nPlayers = static_cast<uint8_t>(game.players.size());
+
+    using Geometry = Board::Geometry;
+    faceUpMask = game.board.getFaceUpMask();
+    for (int i = 0; i < Geometry::kRows; ++i) {
+        for (int j = 0; j < Geometry::kCols; ++j) {
+            int pos = Geometry::index(i, j);
+            if (Geometry::isHole(i, j)) {
+                layout[pos] = kSnapshotNone;
+                continue;
+            }
+            Letter l = static_cast<Letter>(i);
+            Number n = static_cast<Number>(j);
+            const Card* card = game.board.getCard(l, n);
+            layout[pos] = card ? static_cast<uint8_t>(card->getId()) : kSnapshotNone;
+        }
+    }
+
+    previousCard = game.previousCard ? static_cast<uint8_t>(game.previousCard->getId()) : kSnapshotNone;
+    currentCard = game.currentCard ? static_cast<uint8_t>(game.currentCard->getId()) : kSnapshotNone;
+    blockedPosition = game.hasBlockedCard
+        ? static_cast<uint8_t>(Geometry::index(static_cast<int>(game.blockedLetter), static_cast<int>(game.blockedNumber)))
+        : kSnapshotNone;
+
+    std::memset(players, 0, sizeof(players));
+    for (size_t k = 0; k < game.players.size(); ++k) {
+        const Player& p = game.players[k];
+        std::strncpy(players[k].name, p.name.c_str(), kSnapshotNameLength - 1);
+        players[k].side = static_cast<uint8_t>(p.side);
+        players[k].rubies = static_cast<uint8_t>(p.nRubies);
+        players[k].active = p.active;
+        players[k].displayMode = p.displayMode;
+    }
+
+    rubisNext = static_cast<uint8_t>(rubisDeck.getOrder(rubis, sizeof(rubis)));
+}
+
+void GameSnapshot::restore(Game& game, const CardDeck& cardDeck, RubisDeck& rubisDeck) const {
+    if (!isValid()) throw SnapshotError("Invalid snapshot");
+
+    auto cardFor = [&](uint8_t id) -> Card* {
+        if (id == kSnapshotNone) return nullptr;
+        Card* card = cardDeck.getCard(id);
+        if (!card) throw SnapshotError("Unknown card in snapshot");
+        return card;
+    };
+
+    // Check everything before touching the game or the shared rubis deck,
+    // so a bad blob throws with both left as they were
+    for (uint8_t id : layout) cardFor(id);
+    cardFor(previousCard);
+    cardFor(currentCard);
+    if (!rubisDeck.matchesOrder(rubis, sizeof(rubis))) throw SnapshotError("Rubis deck does not match snapshot");
+
+    game.round = round;
+    game.expertDisplay = (mode == 1);
+
+    using Geometry = Board::Geometry;
+    game.board.allFacesDown();
+    for (int pos = 0; pos < Geometry::kCells; ++pos) {
+        if (Geometry::isHole(Geometry::rowOf(pos), Geometry::colOf(pos))) continue;
+        Letter l = static_cast<Letter>(Geometry::rowOf(pos));
+        Number n = static_cast<Number>(Geometry::colOf(pos));
+        game.board.setCard(l, n, cardFor(layout[pos]));
+    }
+    game.board.turnFaceUp(faceUpMask);
+
+    game.previousCard = cardFor(previousCard);
+    game.currentCard = cardFor(currentCard);
+    game.hasBlockedCard = blockedPosition != kSnapshotNone;
+    if (game.hasBlockedCard) {
+        game.blockedLetter = static_cast<Letter>(Geometry::rowOf(blockedPosition));
+        game.blockedNumber = static_cast<Number>(Geometry::colOf(blockedPosition));
+    }
+
+    game.clearSeats();
+    for (int k = 0; k < nPlayers; ++k) {
+        char name[kSnapshotNameLength + 1] = {};
+        std::memcpy(name, players[k].name, kSnapshotNameLength);
+        Player p(name, static_cast<Side>(players[k].side));
+        p.nRubies = players[k].rubies;
+        p.active = players[k].active != 0;
+        p.displayMode = players[k].displayMode != 0;
+        game.addPlayer(p);
+    }
+
+    rubisDeck.setOrder(rubis, sizeof(rubis), rubisNext);
+}
+
+void GameSnapshot::writeFile(const std::string& path) const {
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(this), sizeof(*this));
+    if (!out) throw SnapshotError("Cannot write snapshot " + path);
+}
+
+bool GameSnapshot::readFile(const std::string& path) {
+    std::ifstream in(path, std::ios::binary);
+    if (!in) return false;
+    GameSnapshot loaded;
+    in.read(reinterpret_cast<char*>(&loaded), sizeof(loaded));
+    if (in.gcount() != static_cast<std::streamsize>(sizeof(loaded)) || !loaded.isValid()) return false;
+    *this = loaded;
+    return true;
+}
@@ -0,0 +1,201 @@
+#include "Table.h"
+#include "Card.h"
+#include "CardDeck.h"
+#include "RubisDeck.h"
+#include "Exceptions.h"
+#include <cstring>
+#include <stdexcept>
+
+static_assert(Table::kDealSize == Board::Geometry::kCells + 7, "a deal is the layout and the seven rubis");
+
+static bool isRejected(PickResult result) {
+    return result == PickResult::Hole || result == PickResult::Blocked || result == PickResult::AlreadyFaceUp;
+}
+
+// Every table gets a fresh deal from the shared deck
+static CardDeck& shuffled(CardDeck& deck) {
+    deck.shuffle();
+    return deck;
+}
+
+// A game not started yet, dealt as getDeal() described
+static GameSnapshot dealt(int mode, const uint8_t* deal) {
+    GameSnapshot snapshot;
+    snapshot.mode = static_cast<uint8_t>(mode);
+    std::memcpy(snapshot.layout, deal, sizeof(snapshot.layout));
+    std::memcpy(snapshot.rubis, deal + sizeof(snapshot.layout), sizeof(snapshot.rubis));
+    return snapshot;
+}
+
+Table::Engine Table::makeEngine(int mode, Game& game, Rules& rules, RubisDeck& rubisDeck) {
+    return dispatchRules(mode, [&](auto policy) {
+        return Engine(std::in_place_type<GameEngine<decltype(policy)>>, game, rules, rubisDeck);
+    });
+}
+
+Table::Table(int id, int mode, int seats, CardDeck& cardDeck, RubisDeck& rubisDeck)
+    : id(id), mode(mode), seats(seats), state(State::Waiting), game(shuffled(cardDeck), mode == 1),
+      rubisDeck(rubisDeck), engine(makeEngine(mode, game, rules, rubisDeck)), rubisNext(0) {
+    if (seats < 2 || seats > Game::kMaxSeats) throw std::invalid_argument("Bad table size");
+    rubisDeck.shuffle();
+    rubisDeck.getOrder(rubis, sizeof(rubis));
+    for (int seat = 0; seat < Game::kMaxSeats; ++seat) clients[seat] = -1;
+}
+
+Table::Table(int id, int mode, int seats, const uint8_t* deal, CardDeck& cardDeck, RubisDeck& rubisDeck)
+    : id(id), mode(mode), seats(seats), state(State::Waiting), game(dealt(mode, deal), cardDeck, rubisDeck),
+      rubisDeck(rubisDeck), engine(makeEngine(mode, game, rules, rubisDeck)), rubisNext(0) {
+    if (seats < 2 || seats > Game::kMaxSeats) throw std::invalid_argument("Bad table size");
+    std::memcpy(rubis, deal + Board::Geometry::kCells, sizeof(rubis));
+    for (int seat = 0; seat < Game::kMaxSeats; ++seat) clients[seat] = -1;
+}
+
+Table::Table(int id, int seats, const GameSnapshot& snapshot, CardDeck& cardDeck, RubisDeck& rubisDeck)
+    : id(id), mode(snapshot.mode), seats(seats), state(snapshot.nPlayers < seats ? State::Waiting : State::Playing),
+      game(snapshot, cardDeck, rubisDeck), rubisDeck(rubisDeck), engine(makeEngine(mode, game, rules, rubisDeck)),
+      rubisNext(snapshot.rubisNext) {
+    if (seats < 2 || seats > Game::kMaxSeats || snapshot.nPlayers > seats) throw SnapshotError("Bad table size");
+    std::memcpy(rubis, snapshot.rubis, sizeof(rubis));
+    for (int seat = 0; seat < Game::kMaxSeats; ++seat) clients[seat] = -1;
+    if (state == State::Playing) std::visit([&](auto& e) { e.restoreTurn(snapshot); }, engine);
+}
+
+void Table::save(GameSnapshot& snapshot) const {
+    snapshot = GameSnapshot();
+    snapshot.save(game, rubisDeck);
+    snapshot.mode = static_cast<uint8_t>(mode);
+    // The shared deck holds whichever order was used last
+    std::memcpy(snapshot.rubis, rubis, sizeof(rubis));
+    snapshot.rubisNext = rubisNext;
+    std::visit([&](const auto& e) { e.saveTurn(snapshot); }, engine);
+}
+
+void Table::getDeal(uint8_t* deal) const {
+    using Geometry = Board::Geometry;
+    for (int pos = 0; pos < Geometry::kCells; ++pos) {
+        int row = Geometry::rowOf(pos), col = Geometry::colOf(pos);
+        const Card* card = Geometry::isHole(row, col)
+            ? nullptr
+            : game.getBoard().getCard(static_cast<Letter>(row), static_cast<Number>(col));
+        deal[pos] = card ? static_cast<uint8_t>(card->getId()) : kSnapshotNone;
+    }
+    std::memcpy(deal + Board::Geometry::kCells, rubis, sizeof(rubis));
+}
+
+int Table::join(const std::string& name, int client) {
+    if (state != State::Waiting) return -1;
+    int seat = game.getSeatCount();
+    game.addPlayer(Player(name, static_cast<Side>(seat)));
+    clients[seat] = client;
+    if (seat + 1 == seats) {
+        state = State::Playing;
+        std::visit([](auto& e) { e.startRound(); }, engine);
+    }
+    return seat;
+}
+
+int Table::rejoin(const std::string& name, int client) {
+    for (int seat = 0; seat < game.getSeatCount(); ++seat) {
+        if (clients[seat] < 0 && game.getSeat(seat).getName() == name) {
+            clients[seat] = client;
+            return seat;
+        }
+    }
+    return -1;
+}
+
+int Table::getTurn() const {
+    return std::visit([](const auto& e) { return e.getTurn(); }, engine);
+}
+
+bool Table::isAwaitingTarget() const {
+    return std::visit([](const auto& e) { return e.isAwaitingTarget(); }, engine);
+}
+
+bool Table::act(int seat, Letter l, Number n, TableUpdate& update) {
+    if (state != State::Playing || seat != getTurn()) return false;
+
+    update = TableUpdate();
+    update.seat = seat;
+    update.position = static_cast<uint8_t>(Board::Geometry::index(static_cast<int>(l), static_cast<int>(n)));
+    bool roundOver = false;
+    std::visit([&](auto& e) {
+        update.isTarget = e.isAwaitingTarget();
+        update.result = update.isTarget ? e.target(l, n) : e.pick(l, n);
+        update.effect = e.getLastEffect();
+        update.targetApplied = e.wasTargetApplied();
+        update.skipped = e.getSkippedPlayer();
+        roundOver = e.isRoundOver();
+    }, engine);
+
+    if (isRejected(update.result)) return true;
+    if (!update.isTarget) update.card = static_cast<uint8_t>(game.getCurrentCard()->getId());
+    complete(update, roundOver);
+    return true;
+}
+
+bool Table::timeOut(bool forfeit, TableUpdate& update) {
+    if (state != State::Playing) return false;
+    int seat = getTurn();
+    if (!forfeit) {
+        // The hole is never a valid target, so a pending target is simply skipped
+        using Geometry = Board::Geometry;
+        Letter l = static_cast<Letter>(Geometry::rowOf(Geometry::kFirstHole));
+        Number n = static_cast<Number>(Geometry::colOf(Geometry::kFirstHole));
+        for (int pos = 0; pos < Geometry::kCells && !isAwaitingTarget(); ++pos) {
+            Letter row = static_cast<Letter>(Geometry::rowOf(pos));
+            Number col = static_cast<Number>(Geometry::colOf(pos));
+            if (!Geometry::isHole(Geometry::rowOf(pos), Geometry::colOf(pos)) && !game.getBoard().isFaceUp(row, col) &&
+                !game.isBlocked(row, col)) {
+                l = row;
+                n = col;
+                break;
+            }
+        }
+        act(seat, l, n, update);
+        if (!isRejected(update.result)) {
+            update.timedOut = true;
+            return true;
+        }
+    }
+
+    update = TableUpdate();
+    update.seat = seat;
+    update.timedOut = true;
+    update.position = TableUpdate::kNoPosition;
+    bool roundOver = false;
+    std::visit([&](auto& e) {
+        update.result = e.forfeit();
+        update.skipped = e.getSkippedPlayer();
+        roundOver = e.isRoundOver();
+    }, engine);
+    complete(update, roundOver);
+    return true;
+}
+
+// The board after an action, and the award when it ended the round
+void Table::complete(TableUpdate& update, bool roundOver) {
+    update.round = game.getRound();
+    update.faceUpMask = game.getBoard().getFaceUpMask();
+    update.activeSeats = game.getActiveSeats();
+    if (roundOver) finishRound(update);
+}
+
+void Table::finishRound(TableUpdate& update) {
+    // The rubis deck is shared: draw from this table's order
+    rubisDeck.setOrder(rubis, sizeof(rubis), rubisNext);
+    std::visit([&](auto& e) {
+        update.winner = e.finishRound();
+        if (e.getLastAward()) {
+            update.award = static_cast<int>(*e.getLastAward());
+            ++rubisNext;
+        }
+        if (e.isGameOver()) {
+            state = State::Over;
+            update.gameOver = true;
+        } else {
+            e.startRound();
+            update.newRound = true;
+        }
+    }, engine);
+}
@@ -0,0 +1,71 @@
+#include "Tracer.h"
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+std::atomic<bool> Tracer::enabled(false);
+std::atomic<uint32_t> Tracer::epoch(0);
+
+// Buffers outlive their threads so events of finished threads are still exported
+static std::mutex registryMutex;
+static std::vector<std::unique_ptr<TraceBuffer>> buffers;
+
+TraceBuffer& Tracer::local() {
+    thread_local TraceBuffer* buffer = nullptr;
+    if (!buffer) {
+        std::lock_guard<std::mutex> lock(registryMutex);
+        buffers.emplace_back(new TraceBuffer(static_cast<int>(buffers.size()) + 1));
+        buffer = buffers.back().get();
+    }
+    return *buffer;
+}
+
+uint64_t Tracer::now() {
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void Tracer::start() {
+    epoch.fetch_add(1, std::memory_order_acq_rel);
+    enabled.store(true, std::memory_order_relaxed);
+}
+
+void Tracer::stop() {
+    enabled.store(false, std::memory_order_relaxed);
+}
+
+bool Tracer::write(const std::string& path) {
+    std::ofstream out(path);
+    if (!out) return false;
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    // Buffers still holding an earlier run's events (no event since start()) are left out
+    uint32_t current = getEpoch();
+    uint64_t origin = UINT64_MAX;
+    uint64_t dropped = 0;
+    for (const auto& b : buffers) {
+        if (b->getEpoch() != current) continue;
+        if (b->getSize() > 0 && b->get(0).timestampNs < origin) origin = b->get(0).timestampNs;
+        dropped += b->getDropped();
+    }
+
+    out << std::fixed << std::setprecision(3);
+    out << "{\"traceEvents\":[\n";
+    bool first = true;
+    for (const auto& b : buffers) {
+        if (b->getEpoch() != current) continue;
+        size_t n = b->getSize();
+        for (size_t i = 0; i < n; ++i) {
+            const TraceEvent& e = b->get(i);
+            out << (first ? "" : ",\n") << "{\"name\":\"" << e.name << "\",\"ph\":\"" << e.phase
+                << "\",\"ts\":" << (e.timestampNs - origin) / 1000.0
+                << ",\"pid\":1,\"tid\":" << b->getThreadId() << "}";
+            first = false;
+        }
+    }
+    out << "\n],\"displayTimeUnit\":\"ns\",\"otherData\":{\"dropped\":" << dropped << "}}\n";
+    return static_cast<bool>(out);
+}
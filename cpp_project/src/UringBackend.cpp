@@ -0,0 +1,539 @@
+#include "IoBackend.h"
+#include "Exceptions.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <linux/io_uring.h>
+#include <linux/time_types.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+// io_uring through raw system calls (no liburing dependency)
+static int uringSetup(unsigned entries, io_uring_params* params) {
+    return static_cast<int>(syscall(__NR_io_uring_setup, entries, params));
+}
+
+static int uringEnter(int fd, unsigned toSubmit, unsigned minComplete, unsigned flags, const void* arg, size_t size) {
+    return static_cast<int>(syscall(__NR_io_uring_enter, fd, toSubmit, minComplete, flags, arg, size));
+}
+
+static int uringRegister(int fd, unsigned opcode, const void* arg, unsigned count) {
+    return static_cast<int>(syscall(__NR_io_uring_register, fd, opcode, arg, count));
+}
+
+static ServerError uringError(const char* what) {
+    return ServerError(std::string(what) + ": " + std::strerror(errno));
+}
+
+class UringBackend : public IoBackend {
+private:
+    static const unsigned kEntries = 4096;
+    static const unsigned kRecvBuffers = 1024; // shared by every client
+    static const unsigned kRecvSize = 2048;
+    static const unsigned kSendChunks = 512;   // registered with the ring, at most one per client in flight
+    static const unsigned kSendChunk = 4096;
+    static const uint16_t kRecvGroup = 0;
+
+    // Operation in the high half of user_data, client fd in the low half
+    enum Operation : uint64_t { Accept = 1, Recv = 2, Send = 3, Provide = 4, Wake = 5, Cancel = 6 };
+
+    struct Client {
+        bool open;       // known to the server
+        bool closing;    // shut down, released once its operations finish
+        bool receiving;  // multishot recv armed
+        bool dirty;      // listed in dirtyClients
+        bool dropping;
+        bool detaching;  // handed to another backend once its operations finish
+        int chunk;       // send chunk in flight, -1 if none
+        uint32_t chunkLength;
+        uint32_t chunkSent;
+        std::string pending;
+
+        Client()
+            : open(false), closing(false), receiving(false), dirty(false), dropping(false), detaching(false), chunk(-1),
+              chunkLength(0), chunkSent(0) {}
+    };
+
+    int listenFd;
+    int wakeFd;
+    int ringFd;
+    void* ringMap;
+    size_t ringMapSize;
+    io_uring_sqe* sqes;
+    size_t sqesSize;
+    unsigned* sqHead;
+    unsigned* sqTail;
+    unsigned sqMask;
+    unsigned sqEntries;
+    unsigned sqLocalTail; // filled entries, published to the kernel on enter
+    unsigned* cqHead;
+    unsigned* cqTail;
+    unsigned cqMask;
+    io_uring_cqe* cqes;
+
+    char* recvBuffers;
+    std::vector<uint16_t> returned; // receive buffers to hand back to the kernel
+    char* sendArena;
+    std::vector<int> freeChunks;
+
+    std::vector<Client> clients; // indexed by fd
+    std::vector<int> dirtyClients;
+    std::vector<int> dropped;
+    std::vector<int> detached;
+    bool holding; // sends are staged by release() instead of at the end of poll()
+
+    io_uring_sqe* nextSqe(Operation operation, int fd);
+    void enter(int timeoutMs);
+    void armAccept();
+    void armWake();
+    void armRecv(int fd);
+    void submitChunk(int fd);
+    void provideBuffers(uint16_t first, unsigned count);
+    void returnBuffers();
+    void complete(const io_uring_cqe& cqe, IoEvents& events);
+    void addClient(int fd, IoEvents& events);
+    void peerGone(int fd, IoEvents& events);
+    void shutdownClient(int fd);
+    void release(int fd);
+    void finishDetach(int fd);
+    void stageSends();
+    void cleanup();
+
+public:
+    UringBackend(int listenFd, int wakeFd);
+    ~UringBackend();
+
+    int poll(int timeoutMs, IoEvents& events) override;
+    void send(int client, const iovec* parts, int count) override;
+    size_t unsent(int client) const override;
+    void close(int client) override;
+    void detach(int client) override;
+    void adopt(int client, const std::string& unsent) override;
+    void hold() override { holding = true; }
+    void release() override;
+};
+
+UringBackend::UringBackend(int listenFd, int wakeFd)
+    : listenFd(listenFd), wakeFd(wakeFd), ringFd(-1), ringMap(MAP_FAILED), ringMapSize(0), sqes(nullptr), sqesSize(0),
+      sqLocalTail(0), recvBuffers(nullptr), sendArena(nullptr), holding(false) {
+    io_uring_params params{};
+    params.flags = IORING_SETUP_CQSIZE | IORING_SETUP_COOP_TASKRUN;
+    params.cq_entries = kEntries * 4; // multishot recv posts many completions per request
+    ringFd = uringSetup(kEntries, &params);
+    if (ringFd < 0 && errno == EINVAL) {
+        params = io_uring_params{};
+        params.flags = IORING_SETUP_CQSIZE;
+        params.cq_entries = kEntries * 4;
+        ringFd = uringSetup(kEntries, &params);
+    }
+    if (ringFd < 0) throw uringError("io_uring_setup");
+
+    try {
+        if (!(params.features & IORING_FEAT_SINGLE_MMAP) || !(params.features & IORING_FEAT_EXT_ARG)) {
+            errno = ENOSYS;
+            throw uringError("io_uring features");
+        }
+
+        // Submission and completion rings share one mapping
+        size_t sqSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        size_t cqSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        ringMapSize = sqSize > cqSize ? sqSize : cqSize;
+        ringMap = mmap(nullptr, ringMapSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                       IORING_OFF_SQ_RING);
+        if (ringMap == MAP_FAILED) throw uringError("mmap ring");
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        void* sqeMap = mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd,
+                            IORING_OFF_SQES);
+        if (sqeMap == MAP_FAILED) throw uringError("mmap sqes");
+        sqes = static_cast<io_uring_sqe*>(sqeMap);
+
+        char* base = static_cast<char*>(ringMap);
+        sqHead = reinterpret_cast<unsigned*>(base + params.sq_off.head);
+        sqTail = reinterpret_cast<unsigned*>(base + params.sq_off.tail);
+        sqMask = *reinterpret_cast<unsigned*>(base + params.sq_off.ring_mask);
+        sqEntries = params.sq_entries;
+        sqLocalTail = *sqTail;
+        unsigned* sqArray = reinterpret_cast<unsigned*>(base + params.sq_off.array);
+        for (unsigned i = 0; i < sqEntries; ++i) sqArray[i] = i; // entry i always sits in slot i
+        cqHead = reinterpret_cast<unsigned*>(base + params.cq_off.head);
+        cqTail = reinterpret_cast<unsigned*>(base + params.cq_off.tail);
+        cqMask = *reinterpret_cast<unsigned*>(base + params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(base + params.cq_off.cqes);
+
+        // Receive buffers: the kernel picks one per multishot completion. They are
+        // handed over with PROVIDE_BUFFERS rather than a registered buffer ring,
+        // which not every kernel that has multishot recv accepts.
+        void* recvMap = mmap(nullptr, kRecvBuffers * kRecvSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (recvMap == MAP_FAILED) throw uringError("mmap receive buffers");
+        recvBuffers = static_cast<char*>(recvMap);
+        provideBuffers(0, kRecvBuffers);
+        returned.reserve(kRecvBuffers);
+
+        // Send arena: registered once, so writes skip the per-call page pinning
+        void* arena = mmap(nullptr, kSendChunks * kSendChunk, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+        if (arena == MAP_FAILED) throw uringError("mmap send arena");
+        sendArena = static_cast<char*>(arena);
+        iovec region{sendArena, kSendChunks * kSendChunk};
+        if (uringRegister(ringFd, IORING_REGISTER_BUFFERS, &region, 1) < 0) throw uringError("register send buffers");
+        for (int chunk = kSendChunks - 1; chunk >= 0; --chunk) freeChunks.push_back(chunk);
+    } catch (...) {
+        cleanup();
+        throw;
+    }
+
+    armAccept();
+    if (wakeFd >= 0) armWake();
+}
+
+UringBackend::~UringBackend() {
+    cleanup();
+}
+
+void UringBackend::cleanup() {
+    for (size_t fd = 0; fd < clients.size(); ++fd) {
+        if (clients[fd].open || clients[fd].closing) ::close(static_cast<int>(fd)); // detaching ones too
+    }
+    clients.clear();
+    if (ringFd >= 0) ::close(ringFd); // cancels whatever is still in flight
+    ringFd = -1;
+    if (sendArena) munmap(sendArena, kSendChunks * kSendChunk);
+    if (recvBuffers) munmap(recvBuffers, kRecvBuffers * kRecvSize);
+    if (sqes) munmap(sqes, sqesSize);
+    if (ringMap != MAP_FAILED) munmap(ringMap, ringMapSize);
+    sendArena = nullptr;
+    recvBuffers = nullptr;
+    sqes = nullptr;
+    ringMap = MAP_FAILED;
+}
+
+io_uring_sqe* UringBackend::nextSqe(Operation operation, int fd) {
+    if (sqLocalTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) >= sqEntries) enter(0);
+    io_uring_sqe* sqe = &sqes[sqLocalTail & sqMask];
+    ++sqLocalTail;
+    std::memset(sqe, 0, sizeof(*sqe));
+    sqe->fd = fd;
+    sqe->user_data = (static_cast<uint64_t>(operation) << 32) | static_cast<uint32_t>(fd);
+    return sqe;
+}
+
+// Submits everything queued and waits up to timeoutMs for a completion, in one system call
+void UringBackend::enter(int timeoutMs) {
+    __atomic_store_n(sqTail, sqLocalTail, __ATOMIC_RELEASE);
+    unsigned toSubmit = sqLocalTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE);
+
+    __kernel_timespec timeout{};
+    io_uring_getevents_arg arg{};
+    unsigned flags = IORING_ENTER_GETEVENTS;
+    const void* argPtr = nullptr;
+    size_t argSize = 0;
+    if (timeoutMs >= 0) {
+        timeout.tv_sec = timeoutMs / 1000;
+        timeout.tv_nsec = (timeoutMs % 1000) * 1000000LL;
+        arg.ts = reinterpret_cast<uint64_t>(&timeout);
+        flags |= IORING_ENTER_EXT_ARG;
+        argPtr = &arg;
+        argSize = sizeof(arg);
+    }
+    bool ready = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE) != *cqHead;
+    unsigned minComplete = (timeoutMs == 0 || ready) ? 0 : 1;
+    if (uringEnter(ringFd, toSubmit, minComplete, flags, argPtr, argSize) < 0 && errno != EINTR &&
+        errno != ETIME && errno != EBUSY && errno != EAGAIN) {
+        throw uringError("io_uring_enter");
+    }
+}
+
+void UringBackend::armAccept() {
+    io_uring_sqe* sqe = nextSqe(Accept, listenFd);
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->accept_flags = SOCK_NONBLOCK | SOCK_CLOEXEC;
+}
+
+void UringBackend::armWake() {
+    io_uring_sqe* sqe = nextSqe(Wake, wakeFd);
+    sqe->opcode = IORING_OP_POLL_ADD;
+    sqe->poll32_events = POLLIN;
+    sqe->len = IORING_POLL_ADD_MULTI;
+}
+
+void UringBackend::armRecv(int fd) {
+    io_uring_sqe* sqe = nextSqe(Recv, fd);
+    sqe->opcode = IORING_OP_RECV;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = kRecvGroup;
+    clients[fd].receiving = true;
+}
+
+void UringBackend::submitChunk(int fd) {
+    Client& client = clients[fd];
+    io_uring_sqe* sqe = nextSqe(Send, fd);
+    sqe->opcode = IORING_OP_WRITE_FIXED;
+    sqe->addr = reinterpret_cast<uint64_t>(sendArena + static_cast<size_t>(client.chunk) * kSendChunk + client.chunkSent);
+    sqe->len = client.chunkLength - client.chunkSent;
+    sqe->off = static_cast<uint64_t>(-1); // sockets have no file position
+    sqe->buf_index = 0;
+}
+
+void UringBackend::provideBuffers(uint16_t first, unsigned count) {
+    io_uring_sqe* sqe = nextSqe(Provide, 0);
+    sqe->opcode = IORING_OP_PROVIDE_BUFFERS;
+    sqe->fd = static_cast<int>(count);
+    sqe->addr = reinterpret_cast<uint64_t>(recvBuffers + static_cast<size_t>(first) * kRecvSize);
+    sqe->len = kRecvSize;
+    sqe->off = first;
+    sqe->buf_group = kRecvGroup;
+}
+
+// Buffers come back in runs of consecutive ids, one request per run
+void UringBackend::returnBuffers() {
+    if (returned.empty()) return;
+    std::sort(returned.begin(), returned.end());
+    size_t start = 0;
+    for (size_t k = 1; k <= returned.size(); ++k) {
+        if (k == returned.size() || returned[k] != returned[k - 1] + 1) {
+            provideBuffers(returned[start], static_cast<unsigned>(k - start));
+            start = k;
+        }
+    }
+    returned.clear();
+}
+
+int UringBackend::poll(int timeoutMs, IoEvents& events) {
+    enter(timeoutMs);
+
+    int handled = 0;
+    while (true) {
+        unsigned head = *cqHead;
+        unsigned tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE);
+        if (head == tail) break;
+        for (; head != tail; ++head, ++handled) {
+            io_uring_cqe cqe = cqes[head & cqMask];
+            __atomic_store_n(cqHead, head + 1, __ATOMIC_RELEASE);
+            complete(cqe, events);
+        }
+    }
+
+    // A dropped client's table may queue "closed" for others, so the list can grow
+    for (size_t k = 0; k < dropped.size(); ++k) {
+        int fd = dropped[k];
+        if (!clients[fd].open) continue;
+        events.onClose(fd);
+        close(fd);
+    }
+    dropped.clear();
+    for (size_t k = 0; k < detached.size(); ++k) {
+        int fd = detached[k];
+        std::string unsent;
+        unsent.swap(clients[fd].pending);
+        clients[fd] = Client();
+        events.onDetach(fd, unsent);
+    }
+    detached.clear();
+    returnBuffers();
+    if (!holding) stageSends();
+    return handled;
+}
+
+void UringBackend::release() {
+    holding = false;
+    stageSends();
+}
+
+void UringBackend::complete(const io_uring_cqe& cqe, IoEvents& events) {
+    Operation operation = static_cast<Operation>(cqe.user_data >> 32);
+    int fd = static_cast<int>(cqe.user_data & 0xFFFFFFFF);
+    bool more = (cqe.flags & IORING_CQE_F_MORE) != 0;
+
+    if (operation == Provide || operation == Cancel) return;
+    if (operation == Accept) {
+        if (cqe.res >= 0) addClient(cqe.res, events);
+        if (!more) armAccept();
+        return;
+    }
+    if (operation == Wake) {
+        uint64_t count;
+        ssize_t got = ::read(wakeFd, &count, sizeof(count)); // resets the eventfd
+        (void)got;
+        events.onWake();
+        if (!more) armWake();
+        return;
+    }
+
+    Client& client = clients[fd];
+    if (operation == Recv) {
+        if (cqe.flags & IORING_CQE_F_BUFFER) {
+            uint16_t bid = static_cast<uint16_t>(cqe.flags >> IORING_CQE_BUFFER_SHIFT);
+            if (cqe.res > 0 && client.open && !client.closing) {
+                events.onData(fd, recvBuffers + static_cast<size_t>(bid) * kRecvSize, static_cast<size_t>(cqe.res));
+            }
+            returned.push_back(bid);
+        }
+        if (more) return;
+        clients[fd].receiving = false;
+        if (clients[fd].detaching) {
+            finishDetach(fd); // cancelled, or the peer left: the new owner finds out
+            return;
+        }
+        if ((cqe.res > 0 || cqe.res == -ENOBUFS) && clients[fd].open && !clients[fd].closing) {
+            returnBuffers(); // ended early (buffers ran out): refill, then pick up where it stopped
+            armRecv(fd);
+        } else {
+            peerGone(fd, events);
+        }
+        return;
+    }
+
+    // Send
+    if (cqe.res < 0) {
+        freeChunks.push_back(client.chunk);
+        client.chunk = -1;
+        if (client.detaching) finishDetach(fd);
+        else peerGone(fd, events);
+        return;
+    }
+    client.chunkSent += static_cast<uint32_t>(cqe.res);
+    if (client.chunkSent < client.chunkLength && !client.closing) {
+        submitChunk(fd);
+        return;
+    }
+    freeChunks.push_back(client.chunk);
+    client.chunk = -1;
+    if (client.detaching) {
+        finishDetach(fd);
+    } else if (client.closing) {
+        release(fd);
+    } else if (!client.pending.empty() && !client.dirty) {
+        client.dirty = true;
+        dirtyClients.push_back(fd);
+    }
+}
+
+void UringBackend::addClient(int fd, IoEvents& events) {
+    int yes = 1;
+    ::setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &yes, sizeof(yes)); // fails harmlessly on unix sockets
+    if (clients.size() <= static_cast<size_t>(fd)) clients.resize(fd + 1);
+    clients[fd] = Client();
+    clients[fd].open = true;
+    armRecv(fd);
+    events.onOpen(fd);
+}
+
+void UringBackend::peerGone(int fd, IoEvents& events) {
+    if (clients[fd].open && !clients[fd].closing) {
+        events.onClose(fd);
+        shutdownClient(fd);
+    }
+    release(fd);
+}
+
+void UringBackend::shutdownClient(int fd) {
+    Client& client = clients[fd];
+    client.open = false;
+    client.closing = true;
+    client.pending.clear();
+    ::shutdown(fd, SHUT_RDWR); // ends the multishot recv
+}
+
+// Closes the descriptor once no operation refers to it, so its number cannot be reused too early
+void UringBackend::release(int fd) {
+    Client& client = clients[fd];
+    if (!client.closing || client.receiving || client.chunk >= 0) return;
+    ::close(fd);
+    client = Client();
+}
+
+void UringBackend::send(int fd, const iovec* parts, int count) {
+    Client& client = clients[fd];
+    if (!client.open) return;
+    for (int k = 0; k < count; ++k) client.pending.append(static_cast<const char*>(parts[k].iov_base), parts[k].iov_len);
+    if (client.pending.size() > kMaxPending && !client.dropping) {
+        client.dropping = true;
+        dropped.push_back(fd);
+    }
+    if (!client.dirty) {
+        client.dirty = true;
+        dirtyClients.push_back(fd);
+    }
+}
+
+size_t UringBackend::unsent(int fd) const {
+    if (static_cast<size_t>(fd) >= clients.size()) return 0;
+    const Client& client = clients[fd];
+    return client.pending.size() + (client.chunk >= 0 ? client.chunkLength - client.chunkSent : 0);
+}
+
+// Copies queued bytes into registered chunks; they are submitted with the next poll's wait
+void UringBackend::stageSends() {
+    size_t kept = 0;
+    for (size_t k = 0; k < dirtyClients.size(); ++k) {
+        int fd = dirtyClients[k];
+        Client& client = clients[fd];
+        if (!client.open || client.detaching || client.pending.empty() || client.chunk >= 0) {
+            client.dirty = false;
+            continue;
+        }
+        if (freeChunks.empty()) {
+            dirtyClients[kept++] = fd; // every chunk is in flight: try again next poll
+            continue;
+        }
+        client.dirty = false;
+        client.chunk = freeChunks.back();
+        freeChunks.pop_back();
+        size_t length = client.pending.size() < kSendChunk ? client.pending.size() : kSendChunk;
+        std::memcpy(sendArena + static_cast<size_t>(client.chunk) * kSendChunk, client.pending.data(), length);
+        client.pending.erase(0, length);
+        client.chunkLength = static_cast<uint32_t>(length);
+        client.chunkSent = 0;
+        submitChunk(fd);
+    }
+    dirtyClients.resize(kept);
+}
+
+void UringBackend::close(int fd) {
+    if (static_cast<size_t>(fd) >= clients.size() || !clients[fd].open) return;
+    shutdownClient(fd);
+    release(fd);
+}
+
+void UringBackend::detach(int fd) {
+    if (static_cast<size_t>(fd) >= clients.size() || !clients[fd].open || clients[fd].detaching) return;
+    Client& client = clients[fd];
+    client.detaching = true;
+    if (client.receiving) {
+        io_uring_sqe* sqe = nextSqe(Cancel, fd);
+        sqe->opcode = IORING_OP_ASYNC_CANCEL;
+        sqe->addr = (static_cast<uint64_t>(Recv) << 32) | static_cast<uint32_t>(fd);
+    }
+    finishDetach(fd);
+}
+
+// Reported at the end of poll() once neither a recv nor a write refers to the socket
+void UringBackend::finishDetach(int fd) {
+    const Client& client = clients[fd];
+    if (client.receiving || client.chunk >= 0) return;
+    detached.push_back(fd);
+}
+
+void UringBackend::adopt(int fd, const std::string& unsent) {
+    if (clients.size() <= static_cast<size_t>(fd)) clients.resize(fd + 1);
+    clients[fd] = Client();
+    clients[fd].open = true;
+    armRecv(fd);
+    if (unsent.empty()) return;
+    clients[fd].pending = unsent;
+    clients[fd].dirty = true;
+    dirtyClients.push_back(fd);
+}
+
+std::unique_ptr<IoBackend> makeUringBackend(int listenFd, int wakeFd) {
+    return std::unique_ptr<IoBackend>(new UringBackend(listenFd, wakeFd));
+}
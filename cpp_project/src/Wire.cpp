@@ -0,0 +1,248 @@
+#include "Wire.h"
+#include "Board.h"
+#include <cstring>
+
+static void putU32(uint8_t* out, uint32_t value) {
+    out[0] = static_cast<uint8_t>(value);
+    out[1] = static_cast<uint8_t>(value >> 8);
+    out[2] = static_cast<uint8_t>(value >> 16);
+    out[3] = static_cast<uint8_t>(value >> 24);
+}
+
+static uint32_t getU32(const uint8_t* in) {
+    return static_cast<uint32_t>(in[0]) | (static_cast<uint32_t>(in[1]) << 8) |
+           (static_cast<uint32_t>(in[2]) << 16) | (static_cast<uint32_t>(in[3]) << 24);
+}
+
+// Zeroes the frame and writes its type
+static uint8_t* begin(uint8_t* frame, WireType type) {
+    std::memset(frame, 0, kWireFrameSize);
+    frame[0] = static_cast<uint8_t>(type);
+    return frame + 1;
+}
+
+void encode(const WireCreate& message, uint8_t* frame) {
+    uint8_t* p = begin(frame, WireType::Create);
+    p[0] = message.mode;
+    p[1] = message.seats;
+}
+
+bool decode(const uint8_t* frame, WireCreate& message) {
+    if (wireType(frame) != WireType::Create) return false;
+    message.mode = frame[1];
+    message.seats = frame[2];
+    return true;
+}
+
+void encode(const WireJoin& message, uint8_t* frame) {
+    uint8_t* p = begin(frame, WireType::Join);
+    putU32(p, message.table);
+    std::memcpy(p + 4, message.name, kWireNameLength);
+}
+
+bool decode(const uint8_t* frame, WireJoin& message) {
+    if (wireType(frame) != WireType::Join) return false;
+    message.table = getU32(frame + 1);
+    std::memcpy(message.name, frame + 5, kWireNameLength);
+    return true;
+}
+
+void encode(const WireQueue& message, uint8_t* frame) {
+    uint8_t* p = begin(frame, WireType::Queue);
+    p[0] = message.mode;
+    p[1] = message.seats;
+    std::memcpy(p + 2, message.name, kWireNameLength);
+}
+
+bool decode(const uint8_t* frame, WireQueue& message) {
+    if (wireType(frame) != WireType::Queue) return false;
+    message.mode = frame[1];
+    message.seats = frame[2];
+    std::memcpy(message.name, frame + 3, kWireNameLength);
+    return true;
+}
+
+void encode(const WireMove& message, uint8_t* frame) {
+    uint8_t* p = begin(frame, message.target ? WireType::Target : WireType::Pick);
+    p[0] = message.seat;
+    p[1] = message.position;
+}
+
+bool decode(const uint8_t* frame, WireMove& message) {
+    if (wireType(frame) != WireType::Pick && wireType(frame) != WireType::Target) return false;
+    if (frame[1] >= kWireMaxSeats || frame[2] >= Board::Geometry::kCells) return false;
+    message.target = wireType(frame) == WireType::Target;
+    message.seat = frame[1];
+    message.position = frame[2];
+    return true;
+}
+
+void encode(const WireTableId& message, uint8_t* frame) {
+    putU32(begin(frame, WireType::TableId), message.table);
+}
+
+bool decode(const uint8_t* frame, WireTableId& message) {
+    if (wireType(frame) != WireType::TableId) return false;
+    message.table = getU32(frame + 1);
+    return true;
+}
+
+void encode(const WireSeat& message, uint8_t* frame) {
+    uint8_t* p = begin(frame, WireType::Seat);
+    putU32(p, message.table);
+    p[4] = message.seat;
+}
+
+bool decode(const uint8_t* frame, WireSeat& message) {
+    if (wireType(frame) != WireType::Seat) return false;
+    message.table = getU32(frame + 1);
+    message.seat = frame[5];
+    return true;
+}
+
+void encode(const WireStart& message, uint8_t* frame) {
+    uint8_t* p = begin(frame, WireType::Start);
+    p[0] = message.mode;
+    p[1] = message.seats;
+}
+
+bool decode(const uint8_t* frame, WireStart& message) {
+    if (wireType(frame) != WireType::Start) return false;
+    message.mode = frame[1];
+    message.seats = frame[2];
+    return true;
+}
+
+void encode(const WireSight& message, uint8_t* frame) {
+    uint8_t* p = begin(frame, WireType::Sight);
+    p[0] = message.round;
+    p[1] = message.turn;
+    std::memcpy(p + 2, message.positions, kWireSightCards);
+    std::memcpy(p + 2 + kWireSightCards, message.cards, kWireSightCards);
+}
+
+bool decode(const uint8_t* frame, WireSight& message) {
+    if (wireType(frame) != WireType::Sight) return false;
+    message.round = frame[1];
+    message.turn = frame[2];
+    std::memcpy(message.positions, frame + 3, kWireSightCards);
+    std::memcpy(message.cards, frame + 3 + kWireSightCards, kWireSightCards);
+    return true;
+}
+
+void encode(const WireDelta& message, uint8_t* frame) {
+    uint8_t* p = begin(frame, WireType::Delta);
+    p[0] = message.seat;
+    p[1] = message.position;
+    p[2] = message.card;
+    p[3] = message.flags;
+    p[4] = message.effect;
+    p[5] = message.activeSeats;
+    p[6] = message.turn;
+    p[7] = message.skipped;
+    p[8] = message.winner;
+    p[9] = message.award;
+    p[10] = message.round;
+    putU32(p + 11, message.faceUpMask);
+}
+
+bool decode(const uint8_t* frame, WireDelta& message) {
+    if (wireType(frame) != WireType::Delta) return false;
+    const uint8_t* p = frame + 1;
+    message.seat = p[0];
+    message.position = p[1];
+    message.card = p[2];
+    message.flags = p[3];
+    message.effect = p[4];
+    message.activeSeats = p[5];
+    message.turn = p[6];
+    message.skipped = p[7];
+    message.winner = p[8];
+    message.award = p[9];
+    message.round = p[10];
+    message.faceUpMask = getU32(p + 11);
+    return true;
+}
+
+void encode(const WireOver& message, uint8_t* frame) {
+    uint8_t* p = begin(frame, WireType::Over);
+    p[0] = message.seats;
+    std::memcpy(p + 1, message.rubies, kWireMaxSeats);
+}
+
+bool decode(const uint8_t* frame, WireOver& message) {
+    if (wireType(frame) != WireType::Over || frame[1] > kWireMaxSeats) return false;
+    message.seats = frame[1];
+    std::memcpy(message.rubies, frame + 2, kWireMaxSeats);
+    return true;
+}
+
+void encode(const WireReject& message, uint8_t* frame) {
+    begin(frame, WireType::Reject)[0] = static_cast<uint8_t>(message.error);
+}
+
+bool decode(const uint8_t* frame, WireReject& message) {
+    if (wireType(frame) != WireType::Reject || frame[1] > static_cast<uint8_t>(WireError::QueueFull)) return false;
+    message.error = static_cast<WireError>(frame[1]);
+    return true;
+}
+
+void encode(const WireQueued& message, uint8_t* frame) {
+    uint8_t* p = begin(frame, WireType::Queued);
+    p[0] = message.mode;
+    p[1] = message.seats;
+}
+
+bool decode(const uint8_t* frame, WireQueued& message) {
+    if (wireType(frame) != WireType::Queued) return false;
+    message.mode = frame[1];
+    message.seats = frame[2];
+    return true;
+}
+
+void encode(const WireWatch& message, uint8_t* frame) {
+    putU32(begin(frame, WireType::Watch), message.table);
+}
+
+bool decode(const uint8_t* frame, WireWatch& message) {
+    if (wireType(frame) != WireType::Watch) return false;
+    message.table = getU32(frame + 1);
+    return true;
+}
+
+void encode(const WireBoard& message, uint8_t* frame) {
+    uint8_t* p = begin(frame, WireType::Board);
+    putU32(p, message.table);
+    p[4] = message.mode;
+    p[5] = message.seats;
+    p[6] = message.round;
+    p[7] = message.turn;
+    p[8] = message.activeSeats;
+    putU32(p + 9, message.faceUpMask);
+}
+
+bool decode(const uint8_t* frame, WireBoard& message) {
+    if (wireType(frame) != WireType::Board || frame[6] > kWireMaxSeats) return false;
+    const uint8_t* p = frame + 1;
+    message.table = getU32(p);
+    message.mode = p[4];
+    message.seats = p[5];
+    message.round = p[6];
+    message.turn = p[7];
+    message.activeSeats = p[8];
+    message.faceUpMask = getU32(p + 9);
+    return true;
+}
+
+void encode(const WireCards& message, uint8_t* frame) {
+    uint8_t* p = begin(frame, WireType::Cards);
+    p[0] = message.first;
+    std::memcpy(p + 1, message.cards, kWireBoardCards);
+}
+
+bool decode(const uint8_t* frame, WireCards& message) {
+    if (wireType(frame) != WireType::Cards || frame[1] > Board::Geometry::kCells - kWireBoardCards) return false;
+    message.first = frame[1];
+    std::memcpy(message.cards, frame + 2, kWireBoardCards);
+    return true;
+}
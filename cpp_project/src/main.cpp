@@ -4,258 +4,240 @@
 #include "CardDeck.h"
 #include "RubisDeck.h"
 #include "Board.h"
+#include "Snapshot.h"
+#include "GameEngine.h"
+#include "ScriptRunner.h"
+#include "ReplayQuery.h"
+#include "GameServer.h"
+#include "ShardedServer.h"
+#include "Position.h"
+#include "Instrumentation.h"
+#include "Tracer.h"
 #include <iostream>
 #include <vector>
 #include <string>
 #include <algorithm>
 #include <limits>
+#include <cstdio>
+#include <cstdlib>
+#include <poll.h>
+#include <unistd.h>
 
-// Helper function to safely read input and clear buffer
-bool safeReadPosition(char& letter, int& number) {
-    if (!(std::cin >> letter >> number)) {
-        // Clear error state and flush buffer
-        std::cin.clear();
-        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-        return false;
-    }
-    // Clear any remaining characters in the line
-    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-    return true;
-}
-
-int main() {
-    std::cout << "Welcome to Memoarr!\n";
+// Written after every round so a crashed session can be resumed
+static const char* kSaveFile = "memoarr.sav";
 
-    // Ask for game version
-    std::string version;
-    std::cout << "Choose game version (base/expert_display/expert_rules): ";
-    std::cin >> version;
-    bool expertDisplay = (version == "expert_display");
-    bool expertRules = (version == "expert_rules");
-
-    // Ask for number of players
-    int numPlayers;
-    std::cout << "Number of players (2-4): ";
-    std::cin >> numPlayers;
-    if (numPlayers < 2 || numPlayers > 4) {
-        std::cout << "Invalid number of players.\n";
-        return 1;
+// Asks for the target of a swap, turn-down or block power revealed at l, n
+template <typename Engine>
+static PickResult promptExpertTarget(Engine& engine, const Rules& rules, const Card& card, Letter l, Number n) {
+    AnimalPower power = rules.getPower((FaceAnimal)card);
+    switch (power) {
+        case AnimalPower::SwapAdjacent:
+            std::cout << "Octopus! Swap with an adjacent card.\n";
+            std::cout << "Current card is at " << char('A' + (int)l) << ((int)n + 1) << "\n";
+            std::cout << "Enter adjacent card position (e.g. B2) to swap with: ";
+            break;
+        case AnimalPower::TurnDown:
+            std::cout << "Penguin! Turn a visible card face down.\n";
+            std::cout << "Enter position (e.g. A1): ";
+            break;
+        default:
+            std::cout << "Walrus! Block a card for the next player.\n";
+            std::cout << "Enter position to block (e.g. A1): ";
+            break;
     }
 
-    // Ask for player names
-    std::vector<std::string> names;
-    std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear newline
-    for (int i = 0; i < numPlayers; ++i) {
-        std::string name;
-        std::cout << "Player " << (i+1) << " name: ";
-        std::getline(std::cin, name);
-        names.push_back(name);
+    Letter targetL;
+    Number targetN;
+    PositionStatus status;
+    {
+        MEMO_SCOPE(Probe::InputWait);
+        status = readPosition(std::cin, targetL, targetN);
+    }
+    if (status != PositionStatus::Ok) {
+        std::cout << "Invalid input. Effect ignored.\n";
+        // The hole is never a valid target
+        return engine.target(static_cast<Letter>(Board::Geometry::rowOf(Board::Geometry::kFirstHole)),
+                             static_cast<Number>(Board::Geometry::colOf(Board::Geometry::kFirstHole)));
     }
 
-    // Create decks
-    CardDeck& cardDeck = CardDeck::make_CardDeck();
-    RubisDeck& rubisDeck = RubisDeck::make_RubisDeck();
-
-    // Create game
-    Game game(cardDeck, expertDisplay);
-    Rules rules(expertRules);
+    PickResult result = engine.target(targetL, targetN);
+    if (!engine.wasTargetApplied()) {
+        std::cout << "Invalid target. Effect ignored.\n";
+    } else if (power == AnimalPower::SwapAdjacent) {
+        std::cout << "Cards swapped.\n";
+    } else if (power == AnimalPower::TurnDown) {
+        std::cout << "Card turned face down.\n";
+    } else {
+        std::cout << "Position " << char('A' + (int)targetL) << ((int)targetN + 1) << " blocked for next player.\n";
+    }
+    return result;
+}
 
-    // Create players
-    std::vector<Side> sides = {Side::top, Side::bottom, Side::left, Side::right};
-    for (int i = 0; i < numPlayers; ++i) {
-        Player p(names[i], sides[i]);
-        game.addPlayer(p);
+// Waits for Enter, or at most seconds when seconds > 0
+static void waitForEnter(int seconds) {
+    if (seconds <= 0) {
+        std::cin.get();
+        return;
+    }
+    if (std::cin.rdbuf()->in_avail() <= 0) {
+        pollfd input{STDIN_FILENO, POLLIN, 0};
+        if (::poll(&input, 1, seconds * 1000) == 0) {
+            std::cout << "\n";
+            return;
+        }
     }
+    // Input arrived early: an empty line is the Enter, anything else is the next move
+    if (std::cin.peek() == '\n') std::cin.get();
+}
 
+// Plays the game to the end on the console with the engine specialized for Policy.
+// The sight cards stay up for sightSeconds, or until Enter when 0.
+template <typename Policy>
+static int playConsole(Game& game, RubisDeck& rubisDeck, int sightSeconds) {
     // Display initial game
     std::cout << "\n" << game << "\n";
 
     // Game loop - 7 rounds
-    while (!rules.gameOver(game)) {
-        game.nextRound();
+    Rules rules;
+    GameEngine<Policy> engine(game, rules, rubisDeck);
+    while (!engine.isGameOver()) {
+        engine.startRound();
         std::cout << "\n========== ROUND " << game.getRound() << " ==========\n";
 
         // Pre-round reveal phase
-        std::cout << "\nRevealing cards for each player (memorize them)...\n";
-        for (const auto& p : game.getPlayers()) {
-            auto locs = game.getSightLocations(p.getSide());
-            std::cout << p.getName() << " can see: ";
-            for (auto loc : locs) {
-                std::cout << char('A' + (int)loc.first) << ((int)loc.second + 1) << " ";
-            }
-            std::cout << "\n";
-            
-            for (auto loc : locs) {
-                game.turnFaceUp(loc.first, loc.second);
+        {
+            MEMO_SCOPE(Probe::SightPhase);
+            MEMO_TRACE_SCOPE("sight_reveal");
+            std::cout << "\nRevealing cards for each player (memorize them)...\n";
+            for (int seat = 0; seat < game.getSeatCount(); ++seat) {
+                std::cout << game.getSeat(seat).getName() << " can see: ";
+                uint32_t sight = game.getSightMask(seat);
+                for (int pos = 0; pos < Board::Geometry::kCells; ++pos) {
+                    if (!(sight & (1u << pos))) continue;
+                    std::cout << char('A' + Board::Geometry::rowOf(pos)) << (Board::Geometry::colOf(pos) + 1) << " ";
+                }
+                std::cout << "\n";
+                game.revealSight(seat);
             }
+
+            std::cout << "\n" << game << "\n";
+        }
+
+        if (sightSeconds > 0) {
+            std::cout << "Cards hide in " << sightSeconds << " seconds (Enter to hide now)...";
+        } else {
+            std::cout << "Press Enter to hide cards and begin round...";
+        }
+        std::cout.flush();
+        {
+            MEMO_SCOPE(Probe::InputWait);
+            waitForEnter(sightSeconds);
         }
-        
-        std::cout << "\n" << game << "\n";
-        
-        std::cout << "Press Enter to hide cards and begin round...";
-        std::cin.get();
 
         // Hide cards again
-        for (const auto& p : game.getPlayers()) {
-            auto locs = game.getSightLocations(p.getSide());
-            for (auto loc : locs) {
-                game.turnFaceDown(loc.first, loc.second);
+        {
+            MEMO_SCOPE(Probe::SightPhase);
+            for (int seat = 0; seat < game.getSeatCount(); ++seat) {
+                game.hideSight(seat);
             }
+
+            std::cout << "\n" << game << "\n";
         }
-        
-        std::cout << "\n" << game << "\n";
-
-        // Round play with proper player rotation
-        int currentPlayerIndex = 0;
-        bool skipNextPlayer = false;
-
-        while (!rules.roundOver(game)) {
-            // Get mutable players list
-            auto& players = game.getPlayersMutable();
-            
-            // Find next active player starting from currentPlayerIndex
-            bool foundActive = false;
-            int startIndex = currentPlayerIndex;
-            
-            for (int i = 0; i < (int)players.size(); ++i) {
-                int idx = (startIndex + i) % players.size();
-                if (players[idx].isActive()) {
-                    currentPlayerIndex = idx;
-                    foundActive = true;
-                    break;
-                }
-            }
-            
-            if (!foundActive) break; // No active players
-            
-            Player& currentPlayer = players[currentPlayerIndex];
-            
-            // Handle skip from Turtle
-            if (skipNextPlayer) {
-                std::cout << "\n" << currentPlayer.getName() << " is skipped due to Turtle effect!\n";
-                skipNextPlayer = false;
-                currentPlayerIndex = (currentPlayerIndex + 1) % players.size();
-                continue;
+
+        // Round play - the engine handles rotation, Crab and Turtle
+        bool newTurn = true;
+
+        while (!engine.isRoundOver()) {
+            Player& currentPlayer = engine.getCurrentPlayer();
+            if (newTurn) {
+                std::cout << "\n>>> " << currentPlayer.getName() << "'s turn <<<\n";
+                newTurn = false;
             }
 
-            std::cout << "\n>>> " << currentPlayer.getName() << "'s turn <<<\n";
-            
-            bool playAgain = true;
-            bool isSecondTurn = false;
-
-            while (playAgain) {
-                playAgain = false; // Reset unless Crab effect
-                
-                // Get card selection
-                char letter;
-                int number;
-                Letter l;
-                Number n;
-                bool validPick = false;
-
-                while (!validPick) {
-                    std::cout << "Choose a card to reveal (e.g. A1): ";
-                    
-                    // FIXED: Safe input reading with error handling
-                    if (!safeReadPosition(letter, number)) {
-                        std::cout << "Invalid input. Please try again.\n";
-                        continue;
-                    }
-                    
-                    // Convert to uppercase if lowercase
-                    if (letter >= 'a' && letter <= 'e') {
-                        letter = letter - 'a' + 'A';
-                    }
-                    
-                    if (letter < 'A' || letter > 'E' || number < 1 || number > 5) {
-                        std::cout << "Invalid format. Use A-E and 1-5.\n";
-                        continue;
-                    }
-
-                    l = static_cast<Letter>(letter - 'A');
-                    n = static_cast<Number>(number - 1);
-
-                    // Check center
-                    if (l == Letter::C && n == Number::Three) {
-                        std::cout << "Center position is empty. Choose another.\n";
-                        continue;
-                    }
-
-                    // Check if blocked by Walrus
-                    if (game.isBlocked(l, n)) {
-                        std::cout << "That card is blocked by Walrus! Choose another.\n";
-                        continue;
-                    }
-                    
-                    // Check if already face up
-                    try {
-                        if (game.getBoard().isFaceUp(l, n)) {
-                            std::cout << "That card is already revealed. Choose a hidden card.\n";
-                            continue;
-                        }
-                        validPick = true;
-                    } catch (const std::exception& e) {
-                        std::cout << "Invalid position: " << e.what() << "\n";
-                    }
-                }
+            // Get card selection
+            Letter l;
+            Number n;
+            PickResult result;
 
-                // Clear Walrus block after valid selection
-                game.resetBlocked();
+            while (true) {
+                std::cout << "Choose a card to reveal (e.g. A1): ";
 
-                // Reveal card
-                game.turnFaceUp(l, n);
-                Card* card = game.getCard(l, n);
-                game.setCurrentCard(card);
-                
-                std::cout << "\n" << game << "\n";
+                PositionStatus status;
+                {
+                    MEMO_SCOPE(Probe::InputWait);
+                    status = readPosition(std::cin, l, n);
+                }
+                if (status == PositionStatus::EndOfInput) {
+                    std::cout << "\nInput closed, exiting.\n";
+                    MEMO_DUMP(std::cerr);
+                    return 1;
+                } else if (status == PositionStatus::BadFormat) {
+                    std::cout << "Invalid input. Please try again.\n";
+                    continue;
+                } else if (status == PositionStatus::OutOfRange) {
+                    std::cout << "Invalid format. Use A-E and 1-5.\n";
+                    continue;
+                } else if (status == PositionStatus::Hole) {
+                    std::cout << "Center position is empty. Choose another.\n";
+                    continue;
+                }
 
-                // Apply expert rules if enabled
-                ExpertEffect effect = ExpertEffect::None;
-                if (expertRules && card) {
-                    effect = rules.applyExpertRule(game, *card, currentPlayer);
-                    if (effect != ExpertEffect::None) {
-                        std::cout << "\n" << game << "\n";
-                    }
+                result = engine.pick(l, n);
+                if (result == PickResult::Hole) {
+                    std::cout << "Center position is empty. Choose another.\n";
+                } else if (result == PickResult::Blocked) {
+                    std::cout << "That card is blocked by Walrus! Choose another.\n";
+                } else if (result == PickResult::AlreadyFaceUp) {
+                    std::cout << "That card is already revealed. Choose a hidden card.\n";
+                } else {
+                    break;
                 }
+            }
+
+            std::cout << "\n" << game << "\n";
 
-                // Check validity
-                if (!rules.isValid(game)) {
-                    std::cout << "❌ MISMATCH! " << currentPlayer.getName() 
-                              << " is eliminated from this round.\n";
-                    currentPlayer.setActive(false);
+            // Expert rules: ask for the target of Octopus, Penguin and Walrus
+            if (result == PickResult::NeedsTarget) {
+                result = promptExpertTarget(engine, rules, *game.getCurrentCard(), l, n);
+                std::cout << "\n" << game << "\n";
+            } else if (engine.getLastEffect() == ExpertEffect::PlayAgain) {
+                std::cout << "Crab! You must play again.\n";
+            } else if (engine.getLastEffect() == ExpertEffect::SkipNext) {
+                std::cout << "Turtle! Next player skips their turn.\n";
+            } else if (Policy::targetEffects && rules.getPower((FaceAnimal)*game.getCurrentCard()) == AnimalPower::TurnDown) {
+                std::cout << "Penguin: No other visible cards to turn down.\n";
+            }
+
+            // Check validity
+            if (result == PickResult::Eliminated) {
+                std::cout << "❌ MISMATCH! " << currentPlayer.getName()
+                          << " is eliminated from this round.\n";
+                newTurn = true;
+            } else {
+                std::cout << "✓ Valid match!\n";
+                if (engine.getLastEffect() == ExpertEffect::PlayAgain && engine.isSecondTurn()) {
+                    std::cout << "→ Crab effect: Play again!\n";
                 } else {
-                    std::cout << "✓ Valid match!\n";
-                    
-                    // Handle special effects
-                    if (effect == ExpertEffect::PlayAgain && !isSecondTurn) {
-                        std::cout << "→ Crab effect: Play again!\n";
-                        playAgain = true;
-                        isSecondTurn = true;
-                    } else if (effect == ExpertEffect::SkipNext) {
-                        skipNextPlayer = true;
-                    }
+                    newTurn = true;
                 }
             }
-            
-            // Move to next player
-            currentPlayerIndex = (currentPlayerIndex + 1) % players.size();
+
+            if (engine.getSkippedPlayer() >= 0) {
+                std::cout << "\n" << game.getPlayers()[engine.getSkippedPlayer()].getName()
+                          << " is skipped due to Turtle effect!\n";
+            }
         }
 
         // Round over - award rubis to winner
         std::cout << "\n--- Round " << game.getRound() << " Complete ---\n";
-        
-        for (auto& p : game.getPlayersMutable()) {
-            if (p.isActive()) {
-                Rubis* rubis = rubisDeck.getNext();
-                if (rubis) {
-                    std::cout << "🏆 " << p.getName() << " wins and receives " 
-                              << *rubis << "!\n";
-                    p.addRubis(*rubis);
-                    delete rubis;
-                } else {
-                    std::cout << "⚠ No more rubies in deck!\n";
-                }
-                break;
+
+        int winner = engine.finishRound();
+        if (winner >= 0) {
+            if (engine.getLastAward()) {
+                std::cout << "🏆 " << game.getPlayers()[winner].getName() << " wins and receives "
+                          << *engine.getLastAward() << "!\n";
+            } else {
+                std::cout << "⚠ No more rubies in deck!\n";
             }
         }
 
@@ -270,7 +252,13 @@ int main() {
         for (auto& p : sortedPlayers) {
             std::cout << p.getName() << ": " << p.getNRubies() << " rubis\n";
         }
+
+        GameSnapshot snapshot;
+        snapshot.save(game, rubisDeck);
+        snapshot.mode = Policy::mode;
+        snapshot.writeFile(kSaveFile);
     }
+    std::remove(kSaveFile);
 
     // Game over - announce winner
     std::cout << "\n" << std::string(50, '=') << "\n";
@@ -302,5 +290,138 @@ int main() {
         }
     }
 
+    MEMO_DUMP(std::cerr);
     return 0;
 }
+
+int main(int argc, char* argv[]) {
+    // Server mode: game --server ADDRESS [--seed N] [--io epoll|uring] [--shards N] [--lobby-timeout S]
+    if (argc > 1 && std::string(argv[1]) == "--server") {
+        ServerOptions options;
+        if (!GameServer::parseArgs(argc, argv, options)) {
+            std::cerr << "Usage: game --server unix:PATH|HOST:PORT [--seed N] [--io epoll|uring] [--shards N]"
+                      << " [--lobby-timeout SECONDS] [--turn-timeout SECONDS] [--on-timeout pick|eliminate]"
+                      << " [--sight-time SECONDS] [--idle-timeout SECONDS] [--wal PATH]"
+                      << " [--checkpoint-interval SECONDS]\n";
+            return 1;
+        }
+        try {
+            if (options.shards != 1) {
+                ShardedServer server(options);
+                std::cerr << "Listening on " << options.address << " (" << options.io << ", "
+                          << server.getShardCount() << " shards)\n";
+                return server.run();
+            }
+            GameServer server(options);
+            std::cerr << "Listening on " << options.address << " (" << options.io << ")\n";
+            return server.run();
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    // Query mode: game --query ARCHIVE [--where COLUMN=VALUE ...] [--group-by COLUMN] [--threads N]
+    if (argc > 1 && std::string(argv[1]) == "--query") {
+        QueryOptions options;
+        if (!EventQuery::parseArgs(argc, argv, options)) {
+            std::cerr << "Usage: game --query ARCHIVE [--where COLUMN=VALUE ...] [--group-by COLUMN] [--threads N]\n"
+                      << "  COLUMN round|reveal|seat|card|animal|background|matched|effect\n";
+            return 1;
+        }
+        try {
+            return EventQuery::report(options, std::cout);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    // Console: game [--sight SECONDS]
+    int sightSeconds = 0;
+    if (argc == 3 && std::string(argv[1]) == "--sight") {
+        sightSeconds = std::atoi(argv[2]);
+        if (sightSeconds <= 0) {
+            std::cerr << "Usage: game [--sight SECONDS]\n";
+            return 1;
+        }
+    } else if (argc > 1) {
+        // Batch mode: game --script FILE [options]
+        ScriptOptions options;
+        if (!ScriptRunner::parseArgs(argc, argv, options)) {
+            std::cerr << "Usage: game --script FILE [--seed N] [--repeat N] [--render | --quiet]"
+                      << " [--archive FILE] [--trace FILE] [--powers SPEC]\n";
+            return 1;
+        }
+        try {
+            ScriptRunner runner(options);
+            return runner.run(std::cout);
+        } catch (const std::exception& e) {
+            std::cerr << "Error: " << e.what() << "\n";
+            return 1;
+        }
+    }
+
+    std::cout << "Welcome to Memoarr!\n";
+
+    // Create decks
+    CardDeck& cardDeck = CardDeck::make_CardDeck();
+    RubisDeck& rubisDeck = RubisDeck::make_RubisDeck();
+
+    // Offer to resume a game saved at the end of a round
+    GameSnapshot saved;
+    bool resume = false;
+    if (saved.readFile(kSaveFile)) {
+        std::string answer;
+        std::cout << "Resume saved game after round " << int(saved.round) << "? (y/n): ";
+        std::cin >> answer;
+        resume = (answer == "y" || answer == "Y");
+    }
+
+    bool expertDisplay = (saved.mode == 1);
+    bool expertRules = (saved.mode == 2);
+    std::vector<std::string> names;
+
+    if (!resume) {
+        // Ask for game version
+        std::string version;
+        std::cout << "Choose game version (base/expert_display/expert_rules): ";
+        std::cin >> version;
+        expertDisplay = (version == "expert_display");
+        expertRules = (version == "expert_rules");
+
+        // Ask for number of players
+        int numPlayers;
+        std::cout << "Number of players (2-" << Game::kMaxSeats << "): ";
+        std::cin >> numPlayers;
+        if (numPlayers < 2 || numPlayers > Game::kMaxSeats) {
+            std::cout << "Invalid number of players.\n";
+            return 1;
+        }
+
+        // Ask for player names
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear newline
+        for (int i = 0; i < numPlayers; ++i) {
+            std::string name;
+            std::cout << "Player " << (i+1) << " name: ";
+            std::getline(std::cin, name);
+            names.push_back(name);
+        }
+    } else {
+        std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n'); // Clear newline
+    }
+
+    // Create game
+    Game game = resume ? Game(saved, cardDeck, rubisDeck) : Game(cardDeck, expertDisplay);
+
+    // Create players
+    // Seat i sits on Side i: the four sides first, then the corners
+    for (size_t i = 0; i < names.size(); ++i) {
+        Player p(names[i], static_cast<Side>(i));
+        game.addPlayer(p);
+    }
+
+    return dispatchRules(expertRules ? 2 : (expertDisplay ? 1 : 0), [&](auto policy) {
+        return playConsole<decltype(policy)>(game, rubisDeck, sightSeconds);
+    });
+}
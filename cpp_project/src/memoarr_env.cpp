@@ -0,0 +1,65 @@
+#include "memoarr_env.h"
+#include "BatchEnv.h"
+#include <exception>
+
+// The C handle is the C++ object; no exception may cross the C boundary
+struct memoarr_env {
+    BatchEnv env;
+    memoarr_env(int nGames, int nPlayers, uint64_t seed) : env(nGames, nPlayers, seed) {}
+};
+
+memoarr_env* memoarr_env_create(int n_games, int n_players, uint64_t seed) {
+    try {
+        return new memoarr_env(n_games, n_players, seed);
+    } catch (const std::exception&) {
+        return nullptr;
+    }
+}
+
+void memoarr_env_destroy(memoarr_env* env) {
+    delete env;
+}
+
+int memoarr_env_games(const memoarr_env* env) {
+    return env->env.size();
+}
+
+int memoarr_env_players(const memoarr_env* env) {
+    return env->env.seats();
+}
+
+void memoarr_env_reset(memoarr_env* env) {
+    env->env.reset();
+}
+
+void memoarr_env_reset_done(memoarr_env* env) {
+    env->env.resetDone();
+}
+
+void memoarr_env_step(memoarr_env* env, const uint8_t* actions, float* rewards, uint8_t* dones) {
+    env->env.step(actions, rewards, dones);
+}
+
+void memoarr_env_observe(const memoarr_env* env, uint8_t* cards) {
+    env->env.observe(cards);
+}
+
+const uint32_t* memoarr_env_face_up(const memoarr_env* env) {
+    return env->env.faceUpMasks();
+}
+
+const uint8_t* memoarr_env_current_card(const memoarr_env* env) {
+    return env->env.currentCards();
+}
+
+const uint8_t* memoarr_env_active(const memoarr_env* env) {
+    return env->env.activeMasks();
+}
+
+const uint8_t* memoarr_env_turn(const memoarr_env* env) {
+    return env->env.turns();
+}
+
+const uint8_t* memoarr_env_rubies(const memoarr_env* env) {
+    return env->env.rubiesWon();
+}
@@ -0,0 +1,25 @@
+#ifndef DECKGUARD_H
+#define DECKGUARD_H
+
+#include "CardDeck.h"
+#include "RubisDeck.h"
+
+// The decks are per-thread singletons shared by every test of the binary: a test
+// that deals from them (directly, or through a Table, BatchEnv or GameServer)
+// holds one of these, so the next test finds full decks whether this one passed or not
+class DeckGuard {
+private:
+    CardDeck& cardDeck;
+    RubisDeck& rubisDeck;
+
+public:
+    DeckGuard() : cardDeck(CardDeck::make_CardDeck()), rubisDeck(RubisDeck::make_RubisDeck()) {}
+    ~DeckGuard() {
+        cardDeck.shuffle();
+        rubisDeck.shuffle();
+    }
+    DeckGuard(const DeckGuard&) = delete;
+    DeckGuard& operator=(const DeckGuard&) = delete;
+};
+
+#endif
@@ -0,0 +1,112 @@
+#include "catch2/catch.hpp"
+
+#include "BatchEnv.h"
+#include "DeckGuard.h"
+#include "Game.h"
+#include "GameEngine.h"
+#include "CardDeck.h"
+#include "RubisDeck.h"
+#include "Rules.h"
+#include "Snapshot.h"
+#include <vector>
+
+// -------------------
+// Batched environment
+// -------------------
+TEST_CASE("Batched games follow the engine rules", "[BatchEnv]") {
+    DeckGuard decks;
+    for (unsigned seed = 1; seed <= 20; ++seed) {
+        CardDeck& cardDeck = CardDeck::make_CardDeck();
+        RubisDeck& rubisDeck = RubisDeck::make_RubisDeck();
+        CardDeck::seed(seed);
+        cardDeck.shuffle();
+        RubisDeck::seed(seed);
+        rubisDeck.shuffle();
+
+        Game game(cardDeck);
+        for (int seat = 0; seat < 3; ++seat) game.addPlayer(Player("P", static_cast<Side>(seat)));
+        Rules rules;
+        GameEngine<BasePolicy> engine(game, rules, rubisDeck);
+
+        // Same deal in the environment
+        GameSnapshot deal;
+        deal.save(game, rubisDeck);
+        std::vector<uint8_t> ids;
+        for (int pos = 0; pos < BatchEnv::kCells; ++pos) {
+            if (deal.layout[pos] != kSnapshotNone) ids.push_back(deal.layout[pos]);
+        }
+        BatchEnv env(1, 3, seed);
+        env.setDeal(0, ids.data(), deal.rubis);
+
+        float rewards[3];
+        uint8_t done = 0;
+        unsigned cursor = seed;
+        while (!engine.isGameOver()) {
+            engine.startRound();
+            REQUIRE(env.faceUpMasks()[0] == 0);
+            REQUIRE(env.rounds()[0] == game.getRound());
+
+            bool roundDone = false;
+            while (!roundDone) {
+                int pos = -1;
+                for (int k = 0; k < BatchEnv::kCells && pos < 0; ++k) {
+                    int p = static_cast<int>((cursor + k) % BatchEnv::kCells);
+                    if (p != 12 && !game.getBoard().isFaceUp(static_cast<Letter>(p / 5), static_cast<Number>(p % 5))) pos = p;
+                }
+                REQUIRE(pos >= 0);
+                cursor += 7;
+
+                uint8_t action = static_cast<uint8_t>(pos);
+                engine.pick(static_cast<Letter>(pos / 5), static_cast<Number>(pos % 5));
+                env.step(&action, rewards, &done);
+
+                // The environment ends a round once every card is up, the engine's driver does it by hand
+                roundDone = engine.isRoundOver() || game.getBoard().getFaceUpMask() == Board::kCellMask;
+                if (!roundDone) {
+                    REQUIRE(env.faceUpMasks()[0] == game.getBoard().getFaceUpMask());
+                    REQUIRE(env.activeMasks()[0] == game.getActiveSeats());
+                    REQUIRE(env.turns()[0] == engine.getTurn());
+                }
+            }
+
+            int winner = engine.finishRound();
+            REQUIRE(winner >= 0);
+            REQUIRE(rewards[winner] == static_cast<float>(static_cast<int>(*engine.getLastAward())));
+            for (int seat = 0; seat < 3; ++seat) {
+                REQUIRE(env.rubiesWon()[seat] == game.getSeat(seat).getNRubies());
+            }
+        }
+        REQUIRE(done == 1);
+    }
+}
+
+TEST_CASE("Finished games stay finished until reset", "[BatchEnv]") {
+    BatchEnv env(64, 4, 42);
+    std::vector<uint8_t> actions(64), dones(64);
+    std::vector<float> rewards(64 * 4);
+    int steps = 0;
+    for (; steps < 10000; ++steps) {
+        for (int g = 0; g < 64; ++g) actions[g] = static_cast<uint8_t>((steps * 7 + g) % 25);
+        env.step(actions.data(), rewards.data(), dones.data());
+        bool all = true;
+        for (uint8_t d : dones) all = all && d;
+        if (all) break;
+    }
+    REQUIRE(steps < 10000);
+
+    // Every game handed out all seven rubis (14 in total)
+    for (int g = 0; g < 64; ++g) {
+        int total = 0;
+        for (int seat = 0; seat < 4; ++seat) total += env.rubiesWon()[g * 4 + seat];
+        REQUIRE(total == 14);
+    }
+
+    uint32_t before = env.faceUpMasks()[0];
+    env.step(actions.data(), rewards.data(), dones.data());
+    REQUIRE(env.faceUpMasks()[0] == before);
+
+    env.resetDone();
+    REQUIRE(env.doneFlags()[0] == 0);
+    REQUIRE(env.rounds()[0] == 1);
+    REQUIRE_THROWS_AS(BatchEnv(1, 9, 0), std::invalid_argument);
+}
@@ -2,6 +2,7 @@
 #include "catch2/catch.hpp"
 
 #include "Board.h"
+#include "Sight.h"
 #include "CardDeck.h"
 #include "Card.h"
 #include "Enums.h"
@@ -41,8 +42,6 @@ TEST_CASE("Card displays correct pattern", "[Card]") {
     }
     REQUIRE(row1[0] == expectedBgChar);
     REQUIRE(row1[2] == expectedBgChar);
-
-    delete c;
 }
 
 // -------------------
@@ -102,3 +101,62 @@ TEST_CASE("Board functionality", "[Board]") {
     REQUIRE_THROWS_AS(board.turnFaceDown(Letter::C, Number::Three), OutOfRange);
     REQUIRE_THROWS_AS(board.swapCards(Letter::A, Number::One, Letter::C, Number::Three), OutOfRange);
 }
+
+TEST_CASE("Sight masks flip a side's cards at once", "[Board]") {
+    Board board;
+
+    for (Side side : {Side::top, Side::bottom, Side::left, Side::right}) {
+        board.turnFaceUp(sightMask(side));
+        for (auto loc : sightLocations(side)) {
+            REQUIRE(board.isFaceUp(loc.first, loc.second));
+        }
+        REQUIRE(board.getFaceUpMask() == sightMask(side));
+        board.turnFaceDown(sightMask(side));
+        REQUIRE(board.getFaceUpMask() == 0);
+    }
+
+    // The hole never turns face up
+    board.turnFaceUp(~0u);
+    REQUIRE(board.getFaceUpMask() == Board::kCellMask);
+}
+
+TEST_CASE("Larger board geometries", "[Board]") {
+    BasicBoard<Geometry7x7> board;
+    REQUIRE(board.getCard(Letter::G, Number::Seven) == nullptr);
+    REQUIRE(board.turnFaceUp(Letter::G, Number::Seven));
+    REQUIRE(board.getFaceUpMask() == (1ull << 48));
+    REQUIRE_THROWS_AS(board.turnFaceUp(Letter::D, Number::Four), OutOfRange);
+
+    board.turnFaceUp(~0ull);
+    REQUIRE(board.getFaceUpMask() == Geometry7x7::kCellMask);
+
+    BasicBoard<Geometry6x6> small;
+    REQUIRE_THROWS_AS(small.isFaceUp(Letter::C, Number::Four), OutOfRange);
+    REQUIRE_THROWS_AS(small.isFaceUp(Letter::G, Number::One), OutOfRange);
+    REQUIRE_FALSE(small.isFaceUp(Letter::F, Number::Six));
+}
+
+TEST_CASE("Larger boards deal from decks of their geometry", "[Board]") {
+    auto deal = [](auto geometry) {
+        using G = decltype(geometry);
+        CardDeck& deck = CardDeck::make_CardDeck(G::kKinds);
+        REQUIRE(deck.getKinds() == G::kKinds);
+        deck.shuffle();
+        BasicBoard<G> board(deck);
+        uint64_t seen = 0;
+        for (int pos = 0; pos < G::kCells; ++pos) {
+            if (G::isHole(G::rowOf(pos), G::colOf(pos))) continue;
+            const Card* card = board.getCard(static_cast<Letter>(G::rowOf(pos)), static_cast<Number>(G::colOf(pos)));
+            REQUIRE(card != nullptr);
+            REQUIRE(deck.getCard(card->getId()) == card);
+            REQUIRE_FALSE((seen >> card->getId()) & 1);
+            seen |= 1ull << card->getId();
+        }
+    };
+    deal(Geometry6x6());
+    deal(Geometry7x7());
+
+    // A deck of another size would give ids the board's rules do not expect
+    REQUIRE_THROWS_AS(BasicBoard<Geometry7x7>(CardDeck::make_CardDeck()), std::invalid_argument);
+    REQUIRE_THROWS_AS(CardDeck::make_CardDeck(kFaceKinds + 1), std::invalid_argument);
+}
@@ -0,0 +1,97 @@
+#include "catch2/catch.hpp"
+
+#include "Matchmaker.h"
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+// -------------------
+// Matchmaker
+// -------------------
+TEST_CASE("Matchmaker forms tables per size and mode", "[Matchmaker]") {
+    Matchmaker matchmaker(4, 64, 64);
+    std::vector<std::vector<int>> tables;
+    auto form = [&](const Ticket* group, int seats) {
+        std::vector<int> fds;
+        for (int k = 0; k < seats; ++k) fds.push_back(group[k].fd);
+        tables.push_back(fds);
+    };
+    Ticket ticket{};
+    auto join = [&](int fd, int mode, int seats) {
+        ticket.fd = fd;
+        return matchmaker.join(mode, seats, ticket, form);
+    };
+
+    REQUIRE(join(1, 0, 3));
+    REQUIRE(join(2, 1, 3)); // another mode
+    REQUIRE(join(3, 0, 2)); // another size
+    REQUIRE_FALSE(join(1, 0, 3)); // already waiting
+    REQUIRE(join(4, 0, 3));
+    REQUIRE(tables.empty());
+    REQUIRE(join(5, 0, 3));
+    REQUIRE(tables == std::vector<std::vector<int>>{{1, 4, 5}});
+
+    // A cancelled ticket is dropped when its group is popped; the others wait on
+    REQUIRE(join(6, 0, 3));
+    REQUIRE(matchmaker.cancel(6, ticket.serial));
+    REQUIRE(join(7, 0, 3));
+    uint32_t seventh = ticket.serial;
+    REQUIRE(join(8, 0, 3));
+    REQUIRE(tables.size() == 1);
+    REQUIRE(join(9, 0, 3));
+    REQUIRE(tables.back() == std::vector<int>{7, 8, 9});
+    REQUIRE_FALSE(matchmaker.cancel(7, seventh)); // seated already
+
+    REQUIRE(join(6, 0, 2)); // cancelled clients may queue again
+    REQUIRE(tables.back() == std::vector<int>{3, 6});
+    REQUIRE_FALSE(join(10, 0, 5));
+    REQUIRE_FALSE(join(64, 0, 2));
+    REQUIRE_THROWS_AS(Matchmaker(1, 8, 8), std::invalid_argument);
+}
+
+TEST_CASE("Concurrent joins seat every client at most once", "[Matchmaker]") {
+    const int kThreads = 4;
+    const int kPerThread = 5000;
+    const int kSeats = 3;
+    Matchmaker matchmaker(4, 1024, kThreads * kPerThread);
+    std::vector<std::atomic<int>> seated(kThreads * kPerThread);
+    std::vector<char> cancelled(kThreads * kPerThread, 0);
+    std::atomic<bool> distinct(true);
+    std::atomic<int> refused(0);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < kThreads; ++t) {
+        threads.emplace_back([&, t]() {
+            std::vector<uint32_t> serials(kPerThread);
+            for (int k = 0; k < kPerThread; ++k) {
+                Ticket ticket{};
+                ticket.shard = t;
+                ticket.fd = t * kPerThread + k;
+                bool queued = matchmaker.join(1, kSeats, ticket, [&](const Ticket* group, int seats) {
+                    for (int i = 0; i < seats; ++i) {
+                        seated[group[i].fd].fetch_add(1);
+                        for (int j = 0; j < i; ++j) {
+                            if (group[i].fd == group[j].fd) distinct = false;
+                        }
+                    }
+                });
+                if (!queued) ++refused;
+                serials[k] = ticket.serial;
+                // Some leave while others are being matched
+                if (k % 7 == 3 && matchmaker.cancel(ticket.fd - 2, serials[k - 2])) cancelled[ticket.fd - 2] = 1;
+            }
+        });
+    }
+    for (std::thread& thread : threads) thread.join();
+
+    REQUIRE(distinct);
+    REQUIRE(refused == 0);
+    int waiting = 0;
+    for (size_t fd = 0; fd < seated.size(); ++fd) {
+        REQUIRE(seated[fd] <= 1);
+        if (cancelled[fd]) REQUIRE(seated[fd] == 0);
+        if (!cancelled[fd] && seated[fd] == 0) ++waiting;
+    }
+    REQUIRE(waiting < kSeats); // nobody lost: at most one incomplete group is left
+}
@@ -0,0 +1,147 @@
+#include "catch2/catch.hpp"
+
+#include "DeckGuard.h"
+#include "Game.h"
+#include "GameEngine.h"
+#include "CardDeck.h"
+#include "RubisDeck.h"
+#include "Rules.h"
+#include "Wire.h"
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <vector>
+
+// -------------------
+// Allocation counting
+// -------------------
+// Replacement global operator new/delete for the whole test binary.
+// Allocations are only counted while a test arms the counter.
+static std::atomic<bool> countAllocations(false);
+static std::atomic<size_t> allocationCount(0);
+
+void* operator new(std::size_t size) {
+    if (countAllocations.load(std::memory_order_relaxed)) allocationCount.fetch_add(1, std::memory_order_relaxed);
+    void* p = std::malloc(size ? size : 1);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](std::size_t size) {
+    return ::operator new(size);
+}
+
+void operator delete(void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p) noexcept {
+    std::free(p);
+}
+
+void operator delete(void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+void operator delete[](void* p, std::size_t) noexcept {
+    std::free(p);
+}
+
+// Counts the allocations made while running fn
+template <typename Fn>
+static size_t allocationsDuring(Fn fn) {
+    allocationCount.store(0);
+    countAllocations.store(true);
+    fn();
+    countAllocations.store(false);
+    return allocationCount.load();
+}
+
+// Deterministic legal move: the first face-down (or face-up) unblocked card after a rotating start
+static void chooseMove(const Game& game, unsigned& cursor, bool faceUp, Letter& l, Number& n) {
+    for (int k = 0; k < 25; ++k) {
+        int pos = static_cast<int>((cursor + k) % 25);
+        if (pos == 12) continue;
+        Letter pl = static_cast<Letter>(pos / 5);
+        Number pn = static_cast<Number>(pos % 5);
+        if (game.getBoard().isFaceUp(pl, pn) == faceUp && !game.isBlocked(pl, pn)) {
+            l = pl;
+            n = pn;
+            cursor += 7;
+            return;
+        }
+    }
+    l = Letter::C;
+    n = Number::Three;
+}
+
+// Plays one game; only the engine steps run with the counter armed
+template <typename Policy>
+static size_t playCounted(unsigned seed) {
+    DeckGuard decks;
+    CardDeck& cardDeck = CardDeck::make_CardDeck();
+    RubisDeck& rubisDeck = RubisDeck::make_RubisDeck();
+    CardDeck::seed(seed);
+    cardDeck.shuffle();
+    RubisDeck::seed(seed);
+    rubisDeck.shuffle();
+
+    Game game(cardDeck);
+    Rules rules;
+    game.addPlayer(Player("A", Side::top));
+    game.addPlayer(Player("B", Side::bottom));
+    game.addPlayer(Player("C", Side::left));
+    GameEngine<Policy> engine(game, rules, rubisDeck);
+
+    unsigned cursor = seed;
+    size_t allocations = 0;
+    while (!engine.isGameOver()) {
+        allocations += allocationsDuring([&] { engine.startRound(); });
+        while (!engine.isRoundOver()) {
+            Letter l;
+            Number n;
+            if (engine.isAwaitingTarget()) {
+                bool turnDown = rules.getPower((FaceAnimal)*game.getCurrentCard()) == AnimalPower::TurnDown;
+                chooseMove(game, cursor, turnDown, l, n);
+                allocations += allocationsDuring([&] { engine.target(l, n); });
+            } else {
+                chooseMove(game, cursor, false, l, n);
+                allocations += allocationsDuring([&] { engine.pick(l, n); });
+            }
+        }
+        allocations += allocationsDuring([&] { engine.finishRound(); });
+    }
+    return allocations;
+}
+
+TEST_CASE("Engine steps do not allocate after warm-up", "[NoAlloc]") {
+    // The counter itself must see allocations
+    std::vector<int> probe;
+    REQUIRE(allocationsDuring([&] { probe.push_back(1); }) == 1);
+
+    playCounted<ExpertRulesPolicy>(1); // warm-up
+
+    for (unsigned seed = 2; seed < 12; ++seed) {
+        REQUIRE(playCounted<BasePolicy>(seed) == 0);
+        REQUIRE(playCounted<ExpertRulesPolicy>(seed) == 0);
+    }
+}
+
+TEST_CASE("Wire codec does not allocate", "[NoAlloc]") {
+    uint8_t frame[kWireFrameSize];
+    WireDelta delta{};
+    delta.position = 7;
+    delta.faceUpMask = 1u << 7;
+    WireDelta decoded{};
+    WireMove move{false, 1, 3};
+    size_t allocations = allocationsDuring([&] {
+        for (int i = 0; i < 1000; ++i) {
+            encode(delta, frame);
+            decode(frame, decoded);
+            encode(move, frame);
+            decode(frame, move);
+        }
+    });
+    REQUIRE(allocations == 0);
+    REQUIRE(decoded.faceUpMask == delta.faceUpMask);
+}
@@ -0,0 +1,41 @@
+#include "catch2/catch.hpp"
+
+#include "Position.h"
+#include <sstream>
+
+// -------------------
+// Position Parser Tests
+// -------------------
+TEST_CASE("Position parser", "[Position]") {
+    Letter l = Letter::A;
+    Number n = Number::One;
+
+    REQUIRE(parsePosition("B4", l, n) == PositionStatus::Ok);
+    REQUIRE(l == Letter::B);
+    REQUIRE(n == Number::Four);
+
+    // Case, surrounding blanks and a blank between letter and number are accepted
+    REQUIRE(parsePosition(" e 5\r", l, n) == PositionStatus::Ok);
+    REQUIRE(l == Letter::E);
+    REQUIRE(n == Number::Five);
+
+    REQUIRE(parsePosition("c3", l, n) == PositionStatus::Hole);
+    REQUIRE(parsePosition("F1", l, n) == PositionStatus::OutOfRange);
+    REQUIRE(parsePosition("A6", l, n) == PositionStatus::OutOfRange);
+    REQUIRE(parsePosition("A0", l, n) == PositionStatus::OutOfRange);
+    REQUIRE(parsePosition("A123456789", l, n) == PositionStatus::OutOfRange);
+    REQUIRE(parsePosition("", l, n) == PositionStatus::BadFormat);
+    REQUIRE(parsePosition("1A", l, n) == PositionStatus::BadFormat);
+    REQUIRE(parsePosition("A", l, n) == PositionStatus::BadFormat);
+    REQUIRE(parsePosition("A1x", l, n) == PositionStatus::BadFormat);
+
+    // Failed parses leave the outputs untouched
+    REQUIRE(l == Letter::E);
+    REQUIRE(n == Number::Five);
+
+    std::istringstream in("d2\nnope\n");
+    REQUIRE(readPosition(in, l, n) == PositionStatus::Ok);
+    REQUIRE(l == Letter::D);
+    REQUIRE(readPosition(in, l, n) == PositionStatus::BadFormat);
+    REQUIRE(readPosition(in, l, n) == PositionStatus::EndOfInput);
+}
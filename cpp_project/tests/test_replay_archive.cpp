@@ -0,0 +1,99 @@
+#include "catch2/catch.hpp"
+
+#include "Replay.h"
+#include "ReplayArchive.h"
+#include "Exceptions.h"
+#include <cstdio>
+#include <string>
+
+// -------------------
+// Replay Archive Tests
+// -------------------
+TEST_CASE("Replay archive round trip", "[ReplayArchive]") {
+    std::string path = "test_replays.marc";
+    std::remove(path.c_str());
+
+    Replay replay(3, 2);
+    for (int cell = 0; cell < kReplayCells; ++cell) {
+        if (cell != 12) replay.setLayout(cell, cell);
+    }
+    replay.setRubies(1, 4);
+    replay.addEvent({1, 0, 7, 7, ReplayEvent::makeFlags(true, ReplayEffect::Block), 3});
+    replay.addEvent({1, 1, 8, 9, ReplayEvent::makeFlags(false, ReplayEffect::None), kReplayNoPosition});
+
+    {
+        ReplayArchiveWriter writer(path);
+        writer.append(replay);
+        writer.close();
+    }
+    {
+        // Reopening appends after the existing records
+        ReplayArchiveWriter writer(path);
+        REQUIRE(writer.getGameCount() == 1);
+        Replay empty(2, 0);
+        writer.append(empty);
+    }
+
+    ReplayArchive archive(path);
+    REQUIRE(archive.size() == 2);
+
+    ReplayView first = archive[0];
+    REQUIRE(first.getNPlayers() == 3);
+    REQUIRE(first.getMode() == 2);
+    REQUIRE(first.getLayout(12) == kReplayNoPosition);
+    REQUIRE(first.getLayout(24) == 24);
+    REQUIRE(first.getRubies(1) == 4);
+    REQUIRE(first.getNEvents() == 2);
+    REQUIRE(first.getEvent(0).matched());
+    REQUIRE(first.getEvent(0).effect() == ReplayEffect::Block);
+    REQUIRE(first.getEvent(0).target == 3);
+    REQUIRE_FALSE(first.getEvent(1).matched());
+
+    int count = 0;
+    for (ReplayView view : archive) {
+        REQUIRE(view.size() == archive[count].size());
+        ++count;
+    }
+    REQUIRE(count == 2);
+    REQUIRE(archive[1].getNEvents() == 0);
+    REQUIRE_THROWS_AS(archive[2], OutOfRange);
+
+    {
+        // Records flushed by a writer that has not closed (or crashed) leave the stored games as they were
+        ReplayArchiveWriter writer(path);
+        for (int i = 0; i < 40000; ++i) writer.append(replay);
+        ReplayArchive during(path);
+        REQUIRE(during.size() == 2);
+        REQUIRE(during[0].getNEvents() == 2);
+        REQUIRE(during[0].getEvent(1).position == 8);
+    }
+    ReplayArchive after(path);
+    REQUIRE(after.size() == 40002);
+    count = 0;
+    for (ReplayView view : after) count += static_cast<int>(view.getNEvents());
+    REQUIRE(count == 2 * 40001);
+
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Replay archive rejects records that do not fit", "[ReplayArchive]") {
+    std::string path = "test_replays_bad.marc";
+    std::remove(path.c_str());
+    {
+        ReplayArchiveWriter writer(path);
+        writer.append(Replay(2, 0));
+    }
+    // A zero size would never advance, a huge one would read past the mapping
+    for (uint32_t size : {0u, 0x7FFFFFFFu}) {
+        std::FILE* f = std::fopen(path.c_str(), "r+b");
+        std::fseek(f, sizeof(ArchiveHeader), SEEK_SET);
+        std::fwrite(&size, sizeof(size), 1, f);
+        std::fclose(f);
+
+        ReplayArchive archive(path);
+        REQUIRE(archive.size() == 1);
+        REQUIRE_THROWS_AS(archive[0], ArchiveError);
+        REQUIRE_THROWS_AS(*archive.begin(), ArchiveError);
+    }
+    std::remove(path.c_str());
+}
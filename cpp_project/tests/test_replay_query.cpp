@@ -0,0 +1,74 @@
+#include "catch2/catch.hpp"
+
+#include "Replay.h"
+#include "ReplayArchive.h"
+#include "ReplayQuery.h"
+#include <cstdio>
+#include <string>
+
+// -------------------
+// Event query Tests
+// -------------------
+TEST_CASE("Event queries filter and group an archive's events", "[ReplayQuery]") {
+    std::string path = "test_query.marc";
+    std::remove(path.c_str());
+
+    const uint8_t kNone = kReplayNoPosition;
+    const uint8_t walrus = 4 * 5 + 1, crab = 0 * 5 + 1, penguin = 1 * 5 + 3;
+    {
+        ReplayArchiveWriter writer(path);
+        // Three seats: a Walrus matched on reveal 2, a crab elimination, seat 2 wins the round
+        Replay first(3, 2);
+        first.addEvent({1, 0, 0, crab, ReplayEvent::makeFlags(true, ReplayEffect::None), kNone});
+        first.addEvent({1, 0, 1, walrus, ReplayEvent::makeFlags(true, ReplayEffect::Block), 7});
+        first.addEvent({1, 1, 2, crab, ReplayEvent::makeFlags(false, ReplayEffect::None), kNone});
+        first.addEvent({1, 2, kNone, 3, ReplayEvent::makeFlags(true, ReplayEffect::Award), kNone});
+        // Round 2: a Walrus eliminates on reveal 1, seat 0 wins
+        first.addEvent({2, 1, 3, walrus, ReplayEvent::makeFlags(false, ReplayEffect::None), kNone});
+        first.addEvent({2, 0, kNone, 2, ReplayEvent::makeFlags(true, ReplayEffect::Award), kNone});
+        first.setRubies(0, 2);
+        first.setRubies(2, 3);
+        writer.append(first);
+        // Two seats: a penguin, then seat 0 wins
+        Replay second(2, 0);
+        second.addEvent({1, 1, 4, penguin, ReplayEvent::makeFlags(true, ReplayEffect::None), kNone});
+        second.addEvent({1, 0, kNone, 4, ReplayEvent::makeFlags(true, ReplayEffect::Award), kNone});
+        second.setRubies(0, 4);
+        writer.append(second);
+    }
+
+    ReplayArchive archive(path);
+    EventColumns table = EventColumns::fromArchive(archive, 2);
+    REQUIRE(table.size() == 8);
+    REQUIRE(table.getGames() == 2);
+    REQUIRE(table.getGamesPlayed(0) == 2);
+    REQUIRE(table.getGamesPlayed(2) == 1);
+    REQUIRE(table.getGamesPlayed(3) == 0);
+
+    // Filtered: Walrus reveals, one matched of two
+    std::vector<GroupStats> walruses = EventQuery().where(EventColumn::Animal, 4).run(table, 2);
+    REQUIRE(walruses.size() == 1);
+    REQUIRE(walruses[0].count == 2);
+    REQUIRE(walruses[0].matched == 1);
+    REQUIRE(EventQuery().where(EventColumn::Animal, 4).where(EventColumn::Reveal, 2).run(table)[0].count == 1);
+
+    // Grouped: rounds won by seat, over the games each seat played
+    std::vector<GroupStats> wins = EventQuery().where(EventColumn::Effect, 6).groupBy(EventColumn::Seat).run(table, 2);
+    REQUIRE(wins.size() == 3);
+    REQUIRE(wins[0].count == 2);
+    REQUIRE(wins[1].count == 0);
+    REQUIRE(wins[2].count == 1);
+    // Games won by Side: the most rubies at the end, not the most rounds
+    REQUIRE(table.getGamesWon(0) == 1);
+    REQUIRE(table.winRate(0) == Approx(0.5));
+    REQUIRE(table.getGamesWon(1) == 0);
+    REQUIRE(table.winRate(2) == Approx(1.0));
+
+    // Eliminations by round
+    std::vector<GroupStats> rounds = EventQuery().where(EventColumn::Matched, 0).groupBy(EventColumn::Round).run(table);
+    REQUIRE(rounds.size() == 3);
+    REQUIRE(rounds[1].count == 1);
+    REQUIRE(rounds[2].count == 1);
+
+    std::remove(path.c_str());
+}
@@ -0,0 +1,72 @@
+#include "catch2/catch.hpp"
+
+#include "Rules.h"
+#include "Game.h"
+#include "CardDeck.h"
+#include "DeckGuard.h"
+
+// -------------------
+// Animal power tables
+// -------------------
+TEST_CASE("Power specs reassign animal powers", "[Rules]") {
+    AnimalPowers powers = kStandardPowers;
+    REQUIRE(Rules::parsePowers("crab=skip_next, turtle=play_again walrus=none", powers));
+    REQUIRE(powers[static_cast<int>(FaceAnimal::Crab)] == AnimalPower::SkipNext);
+    REQUIRE(powers[static_cast<int>(FaceAnimal::Turtle)] == AnimalPower::PlayAgain);
+    REQUIRE(powers[static_cast<int>(FaceAnimal::Walrus)] == AnimalPower::None);
+    REQUIRE(powers[static_cast<int>(FaceAnimal::Octopus)] == AnimalPower::SwapAdjacent);
+
+    REQUIRE(Rules::parsePowers("", powers));
+    REQUIRE_FALSE(Rules::parsePowers("crab", powers));
+    REQUIRE_FALSE(Rules::parsePowers("lobster=swap", powers));
+    REQUIRE_FALSE(Rules::parsePowers("crab=fly", powers));
+}
+
+TEST_CASE("Effects follow the power table", "[Rules]") {
+    DeckGuard decks;
+    CardDeck& cardDeck = CardDeck::make_CardDeck();
+    cardDeck.shuffle();
+    Game game(cardDeck);
+
+    AnimalPowers powers = kStandardPowers;
+    powers[static_cast<int>(FaceAnimal::Crab)] = AnimalPower::Block;
+    powers[static_cast<int>(FaceAnimal::Walrus)] = AnimalPower::SkipNext;
+    Rules rules(powers);
+
+    const Card* crab = nullptr;
+    const Card* walrus = nullptr;
+    for (int pos = 0; pos < 25; ++pos) {
+        if (pos == 12) continue;
+        const Card* card = game.getCard(static_cast<Letter>(pos / 5), static_cast<Number>(pos % 5));
+        if ((FaceAnimal)*card == FaceAnimal::Crab) crab = card;
+        if ((FaceAnimal)*card == FaceAnimal::Walrus) walrus = card;
+    }
+    REQUIRE(crab != nullptr);
+    REQUIRE(walrus != nullptr);
+
+    REQUIRE(rules.applyExpertRule(*walrus) == ExpertEffect::SkipNext);
+    REQUIRE_FALSE(rules.needsTarget(game, *walrus));
+    REQUIRE(rules.applyExpertRule(*crab) == ExpertEffect::None);
+    REQUIRE(rules.needsTarget(game, *crab));
+    REQUIRE(rules.applyTarget(game, *crab, Letter::A, Number::One, Letter::B, Number::Two));
+    REQUIRE(game.isBlocked(Letter::B, Number::Two));
+    REQUIRE_FALSE(rules.applyTarget(game, *walrus, Letter::A, Number::One, Letter::B, Number::Two));
+}
+
+TEST_CASE("A round ends once every card is face up", "[Rules]") {
+    DeckGuard decks;
+    CardDeck& cardDeck = CardDeck::make_CardDeck();
+    cardDeck.shuffle();
+    Game game(cardDeck);
+    game.addPlayer(Player("A", Side::top));
+    game.addPlayer(Player("B", Side::bottom));
+    Rules rules;
+    REQUIRE_FALSE(rules.roundOver(game));
+
+    game.setSightMask(0, Board::kCellMask);
+    game.revealSight(0);
+    REQUIRE(game.getActiveCount() == 2);
+    REQUIRE(rules.roundOver(game));
+    REQUIRE(Rules::roundEnds(1, 0));
+    REQUIRE_FALSE(Rules::roundEnds(2, Board::kCellMask & ~1u));
+}
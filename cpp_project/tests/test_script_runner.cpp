@@ -0,0 +1,54 @@
+#include "catch2/catch.hpp"
+
+#include "DeckGuard.h"
+#include "ScriptRunner.h"
+#include <cstdio>
+#include <fstream>
+#include <numeric>
+#include <sstream>
+#include <string>
+#include <vector>
+
+static void writeScript(const std::string& path, const std::string& moves) {
+    std::ofstream out(path);
+    out << "# two seats, base rules\nmode base\nplayers Ann Bob\n" << moves << "\n";
+}
+
+// -------------------
+// Scripted games
+// -------------------
+TEST_CASE("Scripted games report their rubies and whether they completed", "[ScriptRunner]") {
+    DeckGuard decks;
+    const std::string path = "test_script.txt";
+    std::string sweep;
+    for (char row = 'A'; row <= 'E'; ++row) {
+        for (char col = '1'; col <= '5'; ++col) sweep += std::string{row, col, ' '};
+    }
+    std::string moves;
+    for (int k = 0; k < 40; ++k) moves += sweep + "\n";
+
+    ScriptOptions options;
+    options.scriptPath = path;
+    options.seed = 7;
+    options.quiet = true;
+    std::ostringstream out;
+
+    // Enough moves: seven rounds, every rubis awarded (3x1, 2x2, 3 and 4)
+    writeScript(path, moves);
+    std::vector<int> rubies, again;
+    ScriptRunner runner(options);
+    REQUIRE(runner.playOne(out, nullptr, rubies));
+    REQUIRE(rubies.size() == 2);
+    REQUIRE(std::accumulate(rubies.begin(), rubies.end(), 0) == 14);
+    REQUIRE(runner.playOne(out, nullptr, again));
+    REQUIRE(again == rubies); // the same seed deals the same game
+    REQUIRE(runner.run(out) == 0);
+
+    // A script that stops early is incomplete
+    writeScript(path, "A1 B2");
+    ScriptRunner shortRunner(options);
+    REQUIRE_FALSE(shortRunner.playOne(out, nullptr, rubies));
+    REQUIRE(std::accumulate(rubies.begin(), rubies.end(), 0) < 14);
+    REQUIRE(shortRunner.run(out) == 2);
+    std::remove(path.c_str());
+}
@@ -0,0 +1,475 @@
+#include "catch2/catch.hpp"
+
+#include "DeckGuard.h"
+#include "GameServer.h"
+#include "ShardMesh.h"
+#include <arpa/inet.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+static const char* kTestSocket = "/tmp/memoarr_test_server.sock";
+
+// Blocking client whose reads pump the server in between
+struct TestClient {
+    int fd;
+    std::string buffered;
+
+    TestClient() : fd(::socket(AF_UNIX, SOCK_STREAM, 0)) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strcpy(addr.sun_path, kTestSocket);
+        ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    }
+    explicit TestClient(int port) : fd(::socket(AF_INET, SOCK_STREAM, 0)) {
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(port));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    }
+    ~TestClient() { ::close(fd); }
+
+    void say(const std::string& line) { ::send(fd, (line + "\n").data(), line.size() + 1, MSG_NOSIGNAL); }
+
+    // Next line, or "" if the server had nothing more to say
+    template <typename Server>
+    std::string line(Server& server) {
+        for (int tries = 0; tries < 50; ++tries) {
+            size_t eol = buffered.find('\n');
+            if (eol != std::string::npos) {
+                std::string text = buffered.substr(0, eol);
+                buffered.erase(0, eol + 1);
+                return text;
+            }
+            server.poll(1);
+            char chunk[512];
+            ssize_t n = ::recv(fd, chunk, sizeof(chunk), MSG_DONTWAIT);
+            if (n > 0) buffered.append(chunk, static_cast<size_t>(n));
+        }
+        return "";
+    }
+};
+
+// -------------------
+// Multi-table server
+// -------------------
+TEST_CASE("Tables play to the end over a local socket", "[Server]") {
+    DeckGuard decks;
+    ServerOptions options;
+    options.address = std::string("unix:") + kTestSocket;
+    options.io = GENERATE(as<std::string>{}, "epoll", "uring");
+    GameServer server(options);
+
+    for (int game = 0; game < 2; ++game) {
+        TestClient clients[2];
+        clients[0].say("create base 2");
+        REQUIRE(clients[0].line(server) == "table 0"); // the finished table's id is reused
+        clients[0].say("join 0 Ann");
+        REQUIRE(clients[0].line(server) == "seat 0");
+        clients[1].say("join 0 Bob");
+        REQUIRE(clients[1].line(server) == "seat 1");
+        REQUIRE(server.getTableCount() == 1);
+
+        // Every seat sees every broadcast; seat 0's copy drives the moves
+        bool faceUp[25] = {};
+        std::string over;
+        for (int steps = 0; steps < 1000 && over.empty(); ++steps) {
+            std::string text = clients[0].line(server);
+            REQUIRE(!text.empty());
+            if (text.compare(0, 6, "round ") == 0) {
+                std::memset(faceUp, 0, sizeof(faceUp));
+            } else if (text.compare(0, 7, "reveal ") == 0) {
+                faceUp[(text[9] - 'A') * 5 + (text[10] - '1')] = true;
+            } else if (text.compare(0, 5, "over ") == 0) {
+                over = text;
+            } else if (text.compare(0, 5, "turn ") == 0) {
+                int seat = text[5] - '0';
+                clients[1 - seat].say("A1");
+                int pos = 0;
+                while (pos == 12 || faceUp[pos]) ++pos;
+                clients[seat].say(std::string{static_cast<char>('A' + pos / 5), static_cast<char>('1' + pos % 5)});
+            }
+        }
+        REQUIRE(!over.empty());
+
+        // All seven rubis were handed out
+        int a = 0, b = 0;
+        REQUIRE(std::sscanf(over.c_str(), "over %d %d", &a, &b) == 2);
+        REQUIRE(a + b == 14);
+        REQUIRE(server.getTableCount() == 0);
+
+        // Out of turn picks were refused, and the other seat got the same result
+        int refused = 0;
+        std::string last;
+        for (std::string text = clients[1].line(server); !text.empty(); text = clients[1].line(server)) {
+            if (text == "error not your turn") ++refused;
+            last = text;
+        }
+        REQUIRE(refused > 0);
+        REQUIRE(last == over);
+    }
+}
+
+TEST_CASE("A client leaving closes its table", "[Server]") {
+    DeckGuard decks;
+    ServerOptions options;
+    options.address = std::string("unix:") + kTestSocket;
+    GameServer server(options);
+
+    TestClient ann;
+    ann.say("create expert_rules 3");
+    REQUIRE(ann.line(server) == "table 0");
+    ann.say("join 0 Ann");
+    REQUIRE(ann.line(server) == "seat 0");
+    {
+        TestClient bob;
+        bob.say("join 0 Bob");
+        REQUIRE(bob.line(server) == "seat 1");
+        bob.say("join 0 Bob");
+        REQUIRE(bob.line(server) == "error already seated");
+    }
+    REQUIRE(ann.line(server) == "closed");
+    REQUIRE(server.getTableCount() == 0);
+
+    ann.say("A1");
+    REQUIRE(ann.line(server) == "error not playing");
+    ann.say("create poker 2");
+    REQUIRE(ann.line(server).compare(0, 12, "error usage:") == 0);
+}
+
+TEST_CASE("Spectators follow a table without a seat", "[Server]") {
+    DeckGuard decks;
+    ServerOptions options;
+    options.address = std::string("unix:") + kTestSocket;
+    options.io = GENERATE(as<std::string>{}, "epoll", "uring");
+    GameServer server(options);
+    TestClient ann, bob, sam, tia;
+    ann.say("create base 2");
+    REQUIRE(ann.line(server) == "table 0");
+    sam.say("watch 0");
+    REQUIRE(sam.line(server) == "board base 2 waiting");
+    ann.say("join 0 Ann");
+    REQUIRE(ann.line(server) == "seat 0");
+    bob.say("join 0 Bob");
+    REQUIRE(bob.line(server) == "seat 1");
+    REQUIRE(sam.line(server) == "start base Ann Bob");
+    REQUIRE(sam.line(server) == "round 1");
+
+    // Seats and spectators read the same lines, sights aside
+    std::string text = ann.line(server);
+    while (!text.empty() && text != "turn 0") text = ann.line(server);
+    ann.say("A1");
+    std::string reveal = ann.line(server);
+    REQUIRE(reveal.compare(0, 12, "reveal 0 A1 ") == 0);
+    REQUIRE(sam.line(server) == reveal);
+    REQUIRE(sam.line(server) == "turn 1");
+
+    // A late spectator starts from the board as it is
+    tia.say("watch 0");
+    REQUIRE(tia.line(server) == "board base 2 round 1 turn 1 A1=" + reveal.substr(12, reveal.find(' ', 12) - 12));
+    tia.say("join 0 Tia");
+    REQUIRE(tia.line(server) == "error table is full"); // still watching
+
+    ::close(bob.fd);
+    bob.fd = -1;
+    REQUIRE(sam.line(server) == "closed");
+    REQUIRE(tia.line(server) == "closed");
+    REQUIRE(server.getTableCount() == 0);
+    sam.say("watch 0");
+    REQUIRE(sam.line(server) == "error no such table");
+}
+
+TEST_CASE("Seats out of time are played for, idle games are closed", "[Server]") {
+    DeckGuard decks;
+    ServerOptions options;
+    options.address = std::string("unix:") + kTestSocket;
+    options.turnTimeout = 1;
+    options.idleTimeout = 2;
+    options.onTimeout = GENERATE(as<std::string>{}, "pick", "eliminate");
+    GameServer server(options);
+
+    TestClient ann, bob;
+    ann.say("create base 2");
+    REQUIRE(ann.line(server) == "table 0");
+    ann.say("join 0 Ann");
+    REQUIRE(ann.line(server) == "seat 0");
+    bob.say("join 0 Bob");
+    REQUIRE(bob.line(server) == "seat 1");
+    std::string text = ann.line(server);
+    while (!text.empty() && text != "turn 0") text = ann.line(server);
+    REQUIRE(text == "turn 0");
+
+    // Nobody moves: after a second the table plays seat 0's turn
+    text.clear();
+    for (int wait = 0; wait < 100 && text.empty(); ++wait) text = ann.line(server);
+    if (options.onTimeout == "pick") {
+        REQUIRE(text == "timeout 0");
+        REQUIRE(ann.line(server).compare(0, 12, "reveal 0 A1 ") == 0);
+    } else {
+        REQUIRE(text == "timeout 0 eliminated");
+        REQUIRE(ann.line(server).compare(0, 8, "award 1 ") == 0);
+    }
+
+    // Only the table moved since the start: the game is closed as idle
+    for (int wait = 0; wait < 200 && text != "closed"; ++wait) text = ann.line(server);
+    REQUIRE(text == "closed");
+    REQUIRE(server.getTableCount() == 0);
+}
+
+TEST_CASE("Tables come back from the move log after a restart", "[Server]") {
+    DeckGuard decks;
+    const char* kLog = "/tmp/memoarr_test_server.wal";
+    ::unlink(kLog);
+    ServerOptions options;
+    options.address = std::string("unix:") + kTestSocket;
+    options.io = GENERATE(as<std::string>{}, "epoll", "uring");
+    options.wal = kLog;
+    {
+        GameServer server(options);
+        TestClient ann, bob, cy;
+        ann.say("create base 2");
+        REQUIRE(ann.line(server) == "table 0");
+        cy.say("create expert_rules 3");
+        REQUIRE(cy.line(server) == "table 1");
+        cy.say("join 1 Cy");
+        REQUIRE(cy.line(server) == "seat 0");
+        ann.say("join 0 Ann");
+        REQUIRE(ann.line(server) == "seat 0");
+        bob.say("join 0 Bob");
+        REQUIRE(bob.line(server) == "seat 1");
+        std::string text = ann.line(server);
+        while (!text.empty() && text != "turn 0") text = ann.line(server);
+        REQUIRE(text == "turn 0");
+        ann.say("A1");
+        REQUIRE(ann.line(server).compare(0, 12, "reveal 0 A1 ") == 0);
+        REQUIRE(ann.line(server) == "turn 1");
+    }
+
+    // Gone as if it had crashed: no table was closed, the log has every move
+    {
+        GameServer server(options);
+        REQUIRE(server.getTableCount() == 2);
+        TestClient bob, dan;
+        bob.say("join 0 Bob");
+        REQUIRE(bob.line(server) == "seat 1");
+        REQUIRE(bob.line(server).compare(0, 6, "sight ") == 0);
+        REQUIRE(bob.line(server) == "turn 1");
+        bob.say("A1");
+        REQUIRE(bob.line(server) == "error face up");
+        bob.say("B1");
+        REQUIRE(bob.line(server).compare(0, 12, "reveal 1 B1 ") == 0);
+        dan.say("join 0 Dan");
+        REQUIRE(dan.line(server) == "error table is full");
+        dan.say("join 1 Dan");
+        REQUIRE(dan.line(server) == "seat 1"); // Cy keeps seat 0 of the waiting table
+    }
+
+    // A commit cut short ends the log where it was torn
+    std::FILE* file = std::fopen(kLog, "ab");
+    std::fwrite("\x20\0\0\0torn", 1, 8, file);
+    std::fclose(file);
+    GameServer server(options);
+    REQUIRE(server.getTableCount() == 2);
+    TestClient cy;
+    cy.say("join 1 Cy");
+    REQUIRE(cy.line(server) == "seat 0");
+    ::unlink(kLog);
+}
+
+TEST_CASE("A checkpoint takes the place of the log it covers", "[Server]") {
+    DeckGuard decks;
+    const char* kLog = "/tmp/memoarr_test_checkpoint.wal";
+    const std::string kCheckpoint = std::string(kLog) + ".ckpt";
+    ::unlink(kLog);
+    ::unlink(kCheckpoint.c_str());
+    ServerOptions options;
+    options.address = std::string("unix:") + kTestSocket;
+    options.io = GENERATE(as<std::string>{}, "epoll", "uring");
+    options.wal = kLog;
+    options.checkpointInterval = 1;
+    bool matched = false; // the move after the checkpoint
+    {
+        GameServer server(options);
+        TestClient ann, bob, cy;
+        cy.say("create expert_rules 3");
+        REQUIRE(cy.line(server) == "table 0");
+        cy.say("join 0 Cy");
+        REQUIRE(cy.line(server) == "seat 0");
+        ann.say("create base 2");
+        REQUIRE(ann.line(server) == "table 1");
+        ann.say("join 1 Ann");
+        REQUIRE(ann.line(server) == "seat 0");
+        bob.say("join 1 Bob");
+        REQUIRE(bob.line(server) == "seat 1");
+        std::string text = ann.line(server);
+        while (!text.empty() && text != "turn 0") text = ann.line(server);
+        REQUIRE(text == "turn 0");
+        ann.say("A1");
+        REQUIRE(ann.line(server).compare(0, 12, "reveal 0 A1 ") == 0);
+        REQUIRE(ann.line(server) == "turn 1");
+
+        // Everything so far is in the checkpoint: the log keeps its header only
+        struct stat st{};
+        for (int wait = 0; wait < 300 && (::stat(kLog, &st) != 0 || st.st_size != 64); ++wait) server.poll(10);
+        REQUIRE(st.st_size == 64);
+        REQUIRE(::access(kCheckpoint.c_str(), F_OK) == 0);
+        bob.say("B1");
+        text = bob.line(server);
+        while (!text.empty() && text.compare(0, 9, "reveal 1 ") != 0) text = bob.line(server);
+        REQUIRE(text.compare(0, 12, "reveal 1 B1 ") == 0);
+        matched = text.compare(text.size() - 7, 7, "matched") == 0;
+    }
+
+    // The checkpoint brings the tables back, the log the move after it
+    GameServer server(options);
+    REQUIRE(server.getTableCount() == 2);
+    TestClient ann, dan;
+    ann.say("join 1 Ann");
+    REQUIRE(ann.line(server) == "seat 0");
+    REQUIRE(ann.line(server).compare(0, 6, "sight ") == 0);
+    REQUIRE(ann.line(server) == "turn 0");
+    ann.say("A1");
+    if (matched) {
+        REQUIRE(ann.line(server) == "error face up"); // from the checkpoint
+        ann.say("B1");
+        REQUIRE(ann.line(server) == "error face up"); // from the log
+    } else {
+        REQUIRE(ann.line(server).compare(0, 12, "reveal 0 A1 ") == 0); // Bob lost the round: a new board
+    }
+    dan.say("join 0 Dan");
+    REQUIRE(dan.line(server) == "seat 1"); // Cy keeps seat 0 of the waiting table
+    ::unlink(kLog);
+    ::unlink(kCheckpoint.c_str());
+}
+
+TEST_CASE("A move log keeps the commits made while it is truncated", "[Server]") {
+    const char* kLog = "/tmp/memoarr_test_truncate.wal";
+    ::unlink(kLog);
+    uint64_t mark;
+    {
+        MoveLog log(kLog, 0, 1);
+        log.appendMove(0, 0, 1);
+        log.appendMove(0, 1, 2);
+        mark = log.mark();
+        log.appendMove(0, 0, 3);
+        log.commit();
+        log.beginTruncate();
+        log.appendMove(0, 1, 4); // while the tail is copied
+        log.commit();
+        log.copyTail();
+        log.appendMove(0, 0, 6); // renamed, not switched yet
+        log.commit();
+        log.endTruncate();
+        REQUIRE_FALSE(log.isTruncating());
+        log.appendMove(0, 1, 7);
+    }
+
+    MoveLog log(kLog, 0, 1);
+    REQUIRE(log.getBase() == mark);
+    LogRecord record;
+    const uint8_t* payload;
+    uint64_t position;
+    std::vector<int> moves;
+    for (uint64_t expected = mark; log.next(record, payload, position); expected += sizeof(record)) {
+        REQUIRE(position == expected);
+        moves.push_back(record.value);
+    }
+    REQUIRE(moves == std::vector<int>{3, 4, 6, 7});
+    ::unlink(kLog);
+}
+
+// Two shards polled from one thread, each on its own port so every client
+// knows which shard it lands on
+struct TwoShards {
+    GameServer& first;
+    GameServer& second;
+    int poll(int timeoutMs) { return first.poll(timeoutMs) + second.poll(0); }
+};
+
+TEST_CASE("A client joining another shard's table is handed over", "[Server]") {
+    DeckGuard decks;
+    ShardMesh mesh(2);
+    ServerOptions options;
+    options.io = GENERATE(as<std::string>{}, "epoll", "uring");
+    options.address = "127.0.0.1:7341";
+    GameServer first(options, &mesh, 0);
+    options.address = "127.0.0.1:7342";
+    GameServer second(options, &mesh, 1);
+    TwoShards shards{first, second};
+
+    TestClient ann(7341), bob(7342), cy(7342);
+    ann.say("create base 2");
+    REQUIRE(ann.line(shards) == "table 0");
+    cy.say("create base 2");
+    REQUIRE(cy.line(shards) == "table 1"); // ids encode the owning shard
+    ann.say("join 0 Ann");
+    REQUIRE(ann.line(shards) == "seat 0");
+
+    // Bob moves to shard 0; the line sent right behind his join goes with him
+    bob.say("join 0 Bob\njoin 0 Bob");
+    REQUIRE(bob.line(shards) == "seat 1");
+    REQUIRE(bob.line(shards) == "start base Ann Bob");
+    std::string text = bob.line(shards);
+    while (!text.empty() && text != "error already seated") text = bob.line(shards);
+    REQUIRE(text == "error already seated");
+    REQUIRE(first.getTableCount() == 1);
+    REQUIRE(second.getTableCount() == 1);
+
+    // Turns are served by shard 0 for both seats
+    std::string turn = ann.line(shards);
+    while (!turn.empty() && turn.compare(0, 5, "turn ") != 0) turn = ann.line(shards);
+    REQUIRE(turn.size() == 6);
+    TestClient& mover = turn[5] == '0' ? ann : bob;
+    mover.say("A1");
+    text = bob.line(shards);
+    while (!text.empty() && text.compare(0, 7, "reveal ") != 0) text = bob.line(shards);
+    REQUIRE(text.compare(0, 12, std::string("reveal ") + turn[5] + " A1 ") == 0);
+}
+
+TEST_CASE("Queued clients are matched across shards", "[Server]") {
+    DeckGuard decks;
+    ShardMesh mesh(2);
+    ServerOptions options;
+    options.address = "127.0.0.1:7343";
+    GameServer first(options, &mesh, 0);
+    options.address = "127.0.0.1:7344";
+    GameServer second(options, &mesh, 1);
+    TwoShards shards{first, second};
+
+    // Bob completes the pair on shard 1, which opens the table and fetches Ann
+    TestClient ann(7343), bob(7344);
+    ann.say("play base 2 Ann");
+    REQUIRE(ann.line(shards) == "queued");
+    bob.say("play base 2 Bob");
+    REQUIRE(bob.line(shards) == "queued");
+    REQUIRE(bob.line(shards) == "seat 0");
+    REQUIRE(ann.line(shards) == "seat 1");
+    REQUIRE(ann.line(shards) == "start base Bob Ann");
+    REQUIRE(bob.line(shards) == "start base Bob Ann");
+    REQUIRE(first.getTableCount() == 0);
+    REQUIRE(second.getTableCount() == 1);
+    ann.say("play base 2 Ann");
+    std::string text = ann.line(shards);
+    while (!text.empty() && text != "error already seated") text = ann.line(shards);
+    REQUIRE(text == "error already seated");
+
+    // A client who left is not matched
+    {
+        TestClient cy(7343);
+        cy.say("play expert_rules 2 Cy");
+        REQUIRE(cy.line(shards) == "queued");
+    }
+    TestClient dan(7344);
+    dan.say("play expert_rules 2 Dan");
+    REQUIRE(dan.line(shards) == "queued");
+    REQUIRE(dan.line(shards) == "");
+    dan.say("play expert_rules 9 Dan");
+    REQUIRE(dan.line(shards) == "error already seated");
+}
+
@@ -0,0 +1,189 @@
+#include "catch2/catch.hpp"
+
+#include "Game.h"
+#include "CardDeck.h"
+#include "DeckGuard.h"
+#include "RubisDeck.h"
+#include "Snapshot.h"
+#include "Table.h"
+#include "Exceptions.h"
+#include <algorithm>
+#include <cstdio>
+#include <vector>
+
+// -------------------
+// Snapshot Tests
+// -------------------
+TEST_CASE("Snapshot restores a game in progress", "[Snapshot]") {
+    DeckGuard decks;
+    CardDeck& cardDeck = CardDeck::make_CardDeck();
+    RubisDeck& rubisDeck = RubisDeck::make_RubisDeck();
+    cardDeck.shuffle();
+    rubisDeck.shuffle();
+
+    Game game(cardDeck, true);
+    game.addPlayer(Player("Ann", Side::top));
+    game.addPlayer(Player("Bob", Side::bottom));
+    game.nextRound();
+    game.turnFaceUp(Letter::A, Number::One);
+    game.setCurrentCard(game.getCard(Letter::A, Number::One));
+    game.setBlockedCard(Letter::B, Number::Two);
+    game.setPlayerActive(Side::bottom, false);
+    game.addRubisToPlayer(Side::top, *rubisDeck.getNext());
+
+    GameSnapshot snapshot;
+    snapshot.save(game, rubisDeck);
+    snapshot.turnPlayer = 1;
+
+    std::string path = "test_game.sav";
+    snapshot.writeFile(path);
+    GameSnapshot loaded;
+    REQUIRE(loaded.readFile(path));
+    std::remove(path.c_str());
+    REQUIRE(loaded.turnPlayer == 1);
+
+    // Drawing after the save must be undone by the restore
+    int nextValue = *rubisDeck.getNext();
+    Game restored(loaded, cardDeck, rubisDeck);
+    REQUIRE(int(*rubisDeck.getNext()) == nextValue);
+
+    for (int i = 0; i < 5; ++i) {
+        for (int j = 0; j < 5; ++j) {
+            if (i == 2 && j == 2) continue;
+            Letter l = static_cast<Letter>(i);
+            Number n = static_cast<Number>(j);
+            REQUIRE(restored.getCard(l, n) == game.getCard(l, n));
+            REQUIRE(restored.getBoard().isFaceUp(l, n) == game.getBoard().isFaceUp(l, n));
+        }
+    }
+    REQUIRE(restored.getRound() == 1);
+    REQUIRE(restored.isExpertDisplay() == false); // mode is set by the front end
+    REQUIRE(restored.getCurrentCard() == game.getCurrentCard());
+    REQUIRE(restored.getPreviousCard() == nullptr);
+    REQUIRE(restored.isBlocked(Letter::B, Number::Two));
+    REQUIRE(restored.getPlayers().size() == 2);
+    REQUIRE(restored.getPlayer(Side::top).getName() == "Ann");
+    REQUIRE(restored.getPlayer(Side::top).getNRubies() == game.getPlayer(Side::top).getNRubies());
+    REQUIRE(restored.getPlayer(Side::bottom).isActive() == false);
+
+    // Out of range seats and cells, as a corrupt file could hold
+    GameSnapshot corrupt = loaded;
+    corrupt.turnPlayer = 2;
+    REQUIRE_FALSE(corrupt.isValid());
+    corrupt = loaded;
+    corrupt.blockedPosition = 12; // the hole
+    REQUIRE_FALSE(corrupt.isValid());
+    corrupt.blockedPosition = 25;
+    REQUIRE_FALSE(corrupt.isValid());
+    corrupt.blockedPosition = kSnapshotNone;
+    REQUIRE(corrupt.isValid());
+
+    // Bad cards or rubis throw before the shared rubis deck is reordered
+    uint8_t before[sizeof(loaded.rubis)];
+    uint8_t after[sizeof(loaded.rubis)];
+    int drawn = rubisDeck.getOrder(before, sizeof(before));
+    corrupt = loaded;
+    corrupt.currentCard = 200;
+    REQUIRE_THROWS_AS(Game(corrupt, cardDeck, rubisDeck), SnapshotError);
+    corrupt = loaded;
+    const uint8_t reordered[sizeof(corrupt.rubis)] = {4, 3, 2, 2, 1, 1, 9}; // last rubis unknown
+    std::copy(reordered, reordered + sizeof(reordered), corrupt.rubis);
+    REQUIRE_THROWS_AS(Game(corrupt, cardDeck, rubisDeck), SnapshotError);
+    REQUIRE(rubisDeck.getOrder(after, sizeof(after)) == drawn);
+    REQUIRE(std::equal(before, before + sizeof(before), after));
+
+    loaded.magic[0] = 'X';
+    REQUIRE_THROWS_AS(Game(loaded, cardDeck, rubisDeck), SnapshotError);
+}
+
+TEST_CASE("Eight seats keep their activity and sight", "[Snapshot]") {
+    DeckGuard decks;
+    CardDeck& cardDeck = CardDeck::make_CardDeck();
+    RubisDeck& rubisDeck = RubisDeck::make_RubisDeck();
+    cardDeck.shuffle();
+    rubisDeck.shuffle();
+
+    Game game(cardDeck);
+    for (int seat = 0; seat < Game::kMaxSeats; ++seat) {
+        game.addPlayer(Player("P" + std::to_string(seat), static_cast<Side>(seat)));
+    }
+    REQUIRE_THROWS(game.addPlayer(Player("Extra", Side::top)));
+    game.nextRound();
+    REQUIRE(game.getActiveCount() == 8);
+
+    game.setSeatActive(0, false);
+    game.setPlayerActive(Side::bottomLeft, false);
+    REQUIRE(game.getActiveCount() == 6);
+    REQUIRE(game.nextActiveSeat(0) == 1);
+    REQUIRE(game.nextActiveSeat(7) == 1);
+    REQUIRE(game.getPlayer(Side::topRight).getName() == "P5");
+    REQUIRE(game.getSightMask(4) == sightMask(Side::topLeft));
+
+    GameSnapshot snapshot;
+    snapshot.save(game, rubisDeck);
+    Game restored(snapshot, cardDeck, rubisDeck);
+    REQUIRE(restored.getSeatCount() == 8);
+    REQUIRE(restored.getActiveSeats() == game.getActiveSeats());
+    REQUIRE(restored.getPlayer(Side::bottomLeft).isActive() == false);
+}
+
+// Move k of a scripted game: the first cell from a k-dependent start that the
+// table takes, or a forfeit when it takes none
+static void playStep(Table& table, int k, TableUpdate& update) {
+    int seat = table.getTurn();
+    for (int j = 0; j < Board::Geometry::kCells; ++j) {
+        int pos = (k * 7 + j) % Board::Geometry::kCells;
+        int row = Board::Geometry::rowOf(pos), col = Board::Geometry::colOf(pos);
+        if (Board::Geometry::isHole(row, col)) continue;
+        table.act(seat, static_cast<Letter>(row), static_cast<Number>(col), update);
+        if (update.result != PickResult::Hole && update.result != PickResult::Blocked &&
+            update.result != PickResult::AlreadyFaceUp) {
+            return;
+        }
+    }
+    table.timeOut(true, update);
+}
+
+TEST_CASE("A table saved between any two moves plays on as the original", "[Snapshot]") {
+    DeckGuard decks;
+    CardDeck& cardDeck = CardDeck::make_CardDeck();
+    RubisDeck& rubisDeck = RubisDeck::make_RubisDeck();
+    int awaitingTarget = 0;
+    for (int round = 0; round < 4; ++round) {
+        Table table(0, 2, 3, cardDeck, rubisDeck);
+        table.join("Ann", -1);
+        table.join("Bob", -1);
+        table.join("Cy", -1);
+
+        std::vector<GameSnapshot> saves;
+        std::vector<TableUpdate> trace;
+        while (table.getState() == Table::State::Playing) {
+            saves.emplace_back();
+            table.save(saves.back());
+            awaitingTarget += table.isAwaitingTarget();
+            trace.emplace_back();
+            playStep(table, static_cast<int>(trace.size() - 1), trace.back());
+        }
+
+        for (size_t k = 0; k < saves.size(); ++k) {
+            Table restored(1, 3, saves[k], cardDeck, rubisDeck);
+            REQUIRE(restored.getState() == Table::State::Playing);
+            for (size_t i = k; i < trace.size(); ++i) {
+                TableUpdate update;
+                playStep(restored, static_cast<int>(i), update);
+                REQUIRE(update.seat == trace[i].seat);
+                REQUIRE(update.isTarget == trace[i].isTarget);
+                REQUIRE(update.result == trace[i].result);
+                REQUIRE(update.position == trace[i].position);
+                REQUIRE(update.card == trace[i].card);
+                REQUIRE(update.effect == trace[i].effect);
+                REQUIRE(update.skipped == trace[i].skipped);
+                REQUIRE(update.faceUpMask == trace[i].faceUpMask);
+                REQUIRE(update.winner == trace[i].winner);
+                REQUIRE(update.award == trace[i].award);
+            }
+            REQUIRE(restored.getState() == Table::State::Over);
+        }
+    }
+    REQUIRE(awaitingTarget > 0); // some saves were taken in the middle of an expert turn
+}
@@ -0,0 +1,43 @@
+#include "catch2/catch.hpp"
+
+#include "SpectatorRing.h"
+#include <cstdint>
+#include <string>
+
+// -------------------
+// Spectator ring
+// -------------------
+TEST_CASE("Readers get every byte once, or learn they fell a ring behind", "[SpectatorRing]") {
+    SpectatorRing ring(64);
+    std::string published;
+    uint64_t reader = 0;
+    auto take = [&](uint64_t& position) {
+        iovec parts[2];
+        int count = ring.read(position, parts);
+        std::string got;
+        for (int k = 0; k < count; ++k) got.append(static_cast<const char*>(parts[k].iov_base), parts[k].iov_len);
+        if (count >= 0) position = ring.getHead();
+        return count < 0 ? std::string("lost") : got;
+    };
+
+    // Messages of every length wrap around the end; a reader keeping up sees them whole
+    for (int k = 0; k < 40; ++k) {
+        std::string message(static_cast<size_t>(1 + k % 23), static_cast<char>('a' + k % 26));
+        ring.publish(message.data(), message.size());
+        published += message;
+        REQUIRE(take(reader) == message);
+    }
+    REQUIRE(ring.getHead() == published.size());
+    REQUIRE(take(reader).empty());
+
+    // Exactly a ring behind is still readable, one byte more is not
+    uint64_t slow = ring.getHead();
+    std::string next(64, 'x');
+    ring.publish(next.data(), 40);
+    ring.publish(next.data() + 40, 24);
+    uint64_t late = slow;
+    REQUIRE(take(slow) == next);
+    ring.publish("y", 1);
+    REQUIRE(take(late) == "lost");
+    REQUIRE(late == ring.getHead() - 65);
+}
@@ -0,0 +1,46 @@
+#include "catch2/catch.hpp"
+
+#include "TimerWheel.h"
+#include <cstdint>
+#include <vector>
+
+// -------------------
+// Timer wheel
+// -------------------
+TEST_CASE("Timers fire once, on the first advance past their deadline", "[TimerWheel]") {
+    const uint64_t start = 1000003;
+    TimerWheel wheel(start, 10);
+    std::vector<TimerNode> nodes(20000);
+    std::vector<uint64_t> firedAt(nodes.size(), 0);
+
+    // Deadlines from now to about a day out, so every level of the wheel is used
+    uint64_t seed = 88172645463325252ull;
+    for (size_t k = 0; k < nodes.size(); ++k) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        uint64_t range = k % 4 == 0 ? 90000000 : (k % 4 == 1 ? 600000 : (k % 4 == 2 ? 5000 : 300));
+        nodes[k].owner = static_cast<int>(k);
+        wheel.schedule(nodes[k], start + seed % range);
+    }
+    for (size_t k = 0; k < nodes.size(); k += 3) wheel.cancel(nodes[k]);
+    nodes[1].owner = 1;
+    wheel.schedule(nodes[1], start + 20); // rescheduled: only the new deadline counts
+
+    uint64_t now = start;
+    uint64_t previous = 0;
+    while (wheel.size() > 0) {
+        int wait = wheel.untilNextTick(now);
+        REQUIRE(wait >= 0);
+        previous = now;
+        now += static_cast<uint64_t>(wait) + 1 + now % 997; // sometimes long pauses
+        wheel.advance(now, [&](TimerNode& node) {
+            REQUIRE(firedAt[node.owner] == 0);
+            REQUIRE(node.due <= now);
+            REQUIRE(node.due + 10 > previous); // at most a tick late for the previous advance
+            firedAt[node.owner] = now;
+        });
+    }
+    for (size_t k = 0; k < nodes.size(); ++k) REQUIRE((firedAt[k] != 0) == (k % 3 != 0));
+    REQUIRE(nodes[1].due == start + 20);
+}
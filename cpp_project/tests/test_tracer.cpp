@@ -0,0 +1,83 @@
+#include "catch2/catch.hpp"
+
+#include "Tracer.h"
+#include <cstdio>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Value of "key": in one exported event line
+static std::string field(const std::string& line, const std::string& key) {
+    size_t at = line.find("\"" + key + "\":");
+    if (at == std::string::npos) return "";
+    at += key.size() + 3;
+    size_t end = line.find_first_of(",}", at);
+    std::string value = line.substr(at, end - at);
+    if (!value.empty() && value.front() == '"') value = value.substr(1, value.size() - 2);
+    return value;
+}
+
+// -------------------
+// Tracer Tests
+// -------------------
+TEST_CASE("The tracer writes balanced begin and end events", "[Tracer]") {
+    const std::string path = "test_trace.json";
+
+    // A scope begun before start() ends without a begin in the new run: it is left out
+    Tracer::start();
+    {
+        TraceScope stale("stale");
+        Tracer::start();
+        TraceScope outer("outer");
+        { TraceScope inner("inner"); }
+        std::thread worker([] {
+            TraceScope pick("pick");
+            { TraceScope resolve("resolve"); }
+        });
+        worker.join();
+    }
+    Tracer::stop();
+    { TraceScope ignored("ignored"); } // not recording
+    REQUIRE(Tracer::write(path));
+
+    std::ifstream in(path);
+    std::string line;
+    REQUIRE(std::getline(in, line));
+    REQUIRE(line == "{\"traceEvents\":[");
+    std::map<std::string, std::vector<std::string>> open; // by tid
+    std::map<std::string, double> last;
+    int begins = 0, ends = 0;
+    bool closed = false;
+    while (std::getline(in, line)) {
+        if (line.compare(0, 2, "],") == 0) {
+            REQUIRE(field(line, "dropped") == "0");
+            closed = true;
+            break;
+        }
+        std::string name = field(line, "name"), phase = field(line, "ph"), tid = field(line, "tid");
+        REQUIRE(name != "stale");
+        REQUIRE(name != "ignored");
+        double ts = std::stod(field(line, "ts"));
+        REQUIRE(ts >= last[tid]);
+        last[tid] = ts;
+        if (phase == "B") {
+            open[tid].push_back(name);
+            ++begins;
+        } else {
+            REQUIRE(phase == "E");
+            REQUIRE_FALSE(open[tid].empty());
+            REQUIRE(open[tid].back() == name);
+            open[tid].pop_back();
+            ++ends;
+        }
+    }
+    REQUIRE(closed);
+    REQUIRE(begins == 4);
+    REQUIRE(ends == 4);
+    for (const auto& scopes : open) REQUIRE(scopes.second.empty());
+    REQUIRE(last.size() == 2); // this thread and the worker
+    std::remove(path.c_str());
+}
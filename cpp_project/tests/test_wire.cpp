@@ -0,0 +1,231 @@
+#include "catch2/catch.hpp"
+
+#include "DeckGuard.h"
+#include "GameServer.h"
+#include "Wire.h"
+#include <cstring>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// -------------------
+// Wire codec
+// -------------------
+TEST_CASE("Wire frames round trip", "[Wire]") {
+    uint8_t frame[kWireFrameSize];
+
+    WireDelta delta{};
+    delta.seat = 2;
+    delta.position = 24;
+    delta.card = 19;
+    delta.flags = kDeltaFaceUp | kDeltaEliminated;
+    delta.activeSeats = 0x0B;
+    delta.turn = 3;
+    delta.skipped = kWireNone;
+    delta.winner = 1;
+    delta.award = 4;
+    delta.round = 7;
+    delta.faceUpMask = 0x1FFEFFF;
+    encode(delta, frame);
+    REQUIRE(wireType(frame) == WireType::Delta);
+    REQUIRE(frame[12] == 0xFF); // faceUpMask, little-endian
+    WireDelta decoded;
+    REQUIRE(decode(frame, decoded));
+    REQUIRE((decoded.seat == 2 && decoded.position == 24 && decoded.card == 19));
+    REQUIRE((decoded.flags == delta.flags && decoded.activeSeats == 0x0B && decoded.turn == 3));
+    REQUIRE((decoded.skipped == kWireNone && decoded.winner == 1 && decoded.award == 4 && decoded.round == 7));
+    REQUIRE(decoded.faceUpMask == 0x1FFEFFFu);
+    WireMove wrong;
+    REQUIRE_FALSE(decode(frame, wrong));
+
+    WireJoin join{};
+    join.table = 70000;
+    std::memcpy(join.name, "Pat", 3);
+    encode(join, frame);
+    WireJoin joined;
+    REQUIRE(decode(frame, joined));
+    REQUIRE(joined.table == 70000);
+    REQUIRE(std::strncmp(joined.name, "Pat", kWireNameLength) == 0);
+
+    encode(WireMove{true, 1, 13}, frame);
+    WireMove move;
+    REQUIRE(decode(frame, move));
+    REQUIRE((move.target && move.seat == 1 && move.position == 13));
+    frame[2] = 25; // off the board
+    REQUIRE_FALSE(decode(frame, move));
+
+    WireQueue queue{};
+    queue.mode = 2;
+    queue.seats = 4;
+    std::memcpy(queue.name, "Quinn", 5);
+    encode(queue, frame);
+    WireQueue queued;
+    REQUIRE(decode(frame, queued));
+    REQUIRE((queued.mode == 2 && queued.seats == 4));
+    REQUIRE(std::strncmp(queued.name, "Quinn", kWireNameLength) == 0);
+
+    WireBoard board{};
+    board.table = 9;
+    board.mode = 2;
+    board.seats = 4;
+    board.round = 3;
+    board.turn = 1;
+    board.activeSeats = 0x0D;
+    board.faceUpMask = 0x1000001;
+    encode(board, frame);
+    WireBoard boardBack;
+    REQUIRE(decode(frame, boardBack));
+    REQUIRE((boardBack.table == 9 && boardBack.mode == 2 && boardBack.seats == 4 && boardBack.round == 3));
+    REQUIRE((boardBack.turn == 1 && boardBack.activeSeats == 0x0D && boardBack.faceUpMask == 0x1000001u));
+
+    WireCards cards{};
+    cards.first = 13;
+    std::memset(cards.cards, kWireNone, kWireBoardCards);
+    cards.cards[11] = 24;
+    encode(cards, frame);
+    WireCards cardsBack;
+    REQUIRE(decode(frame, cardsBack));
+    REQUIRE((cardsBack.first == 13 && cardsBack.cards[0] == kWireNone && cardsBack.cards[11] == 24));
+
+    REQUIRE(isWireType(frame[0]));
+    REQUIRE_FALSE(isWireType('c')); // "create ..." keeps the text protocol
+}
+
+// Blocking binary client that pumps the server while it waits
+struct WireClient {
+    int fd;
+
+    explicit WireClient(const char* path) : fd(::socket(AF_UNIX, SOCK_STREAM, 0)) {
+        sockaddr_un addr{};
+        addr.sun_family = AF_UNIX;
+        std::strcpy(addr.sun_path, path);
+        ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr));
+    }
+    ~WireClient() { ::close(fd); }
+
+    void write(const uint8_t* frame) { ::send(fd, frame, kWireFrameSize, MSG_NOSIGNAL); }
+
+    bool read(GameServer& server, uint8_t* frame) {
+        size_t got = 0;
+        for (int tries = 0; tries < 50 && got < kWireFrameSize; ++tries) {
+            server.poll(1);
+            ssize_t n = ::recv(fd, frame + got, kWireFrameSize - got, MSG_DONTWAIT);
+            if (n > 0) got += static_cast<size_t>(n);
+        }
+        return got == kWireFrameSize;
+    }
+};
+
+TEST_CASE("Binary clients play a whole game, watched by a spectator", "[Wire][Server]") {
+    DeckGuard decks;
+    const char* path = "/tmp/memoarr_test_wire.sock";
+    ServerOptions options;
+    options.address = std::string("unix:") + path;
+    options.io = GENERATE(as<std::string>{}, "epoll", "uring");
+    GameServer server(options);
+    WireClient clients[3] = {WireClient(path), WireClient(path), WireClient(path)};
+    uint8_t frame[kWireFrameSize];
+
+    encode(WireCreate{2, 3}, frame);
+    clients[0].write(frame);
+    WireTableId table;
+    REQUIRE(clients[0].read(server, frame));
+    REQUIRE(decode(frame, table));
+
+    // The spectator sees an empty table, then every frame the seats share
+    WireClient watcher(path);
+    encode(WireWatch{table.table}, frame);
+    watcher.write(frame);
+    WireBoard board;
+    REQUIRE(watcher.read(server, frame));
+    REQUIRE(decode(frame, board));
+    REQUIRE((board.table == table.table && board.mode == 2 && board.seats == 3 && board.round == 0));
+    for (int part = 0; part < 2; ++part) {
+        WireCards cards;
+        REQUIRE(watcher.read(server, frame));
+        REQUIRE(decode(frame, cards));
+        REQUIRE(cards.first == part * 13);
+        for (int k = 0; k < kWireBoardCards; ++k) REQUIRE(cards.cards[k] == kWireNone);
+    }
+
+    for (int seat = 0; seat < 3; ++seat) {
+        WireJoin join{};
+        join.table = table.table;
+        join.name[0] = static_cast<char>('A' + seat);
+        encode(join, frame);
+        clients[seat].write(frame);
+        WireSeat seated;
+        REQUIRE(clients[seat].read(server, frame));
+        REQUIRE(decode(frame, seated));
+        REQUIRE(seated.seat == seat);
+    }
+    WireStart start;
+    WireSight sight;
+    for (int seat = 0; seat < 3; ++seat) {
+        REQUIRE(clients[seat].read(server, frame));
+        REQUIRE(decode(frame, start));
+        REQUIRE(clients[seat].read(server, frame));
+        REQUIRE(decode(frame, sight));
+        REQUIRE(sight.round == 1);
+    }
+    REQUIRE(watcher.read(server, frame));
+    REQUIRE(decode(frame, start));
+
+    // Every seat reads every delta; moves are the first face-down (or, for
+    // turn-down targets, any face-up) position
+    int turn = sight.turn;
+    bool awaiting = false;
+    uint32_t faceUp = 0;
+    WireOver over{};
+    for (int steps = 0; steps < 2000; ++steps) {
+        int position = 0;
+        while (position == 12 || (((faceUp >> position) & 1) != 0) != awaiting) position = (position + 1) % 25;
+        encode(WireMove{awaiting, static_cast<uint8_t>(turn), static_cast<uint8_t>(position)}, frame);
+        clients[turn].write(frame);
+
+        WireDelta delta{};
+        bool rejected = false;
+        for (int seat = 0; seat < 3; ++seat) {
+            REQUIRE(clients[seat].read(server, frame));
+            if (wireType(frame) == WireType::Reject) {
+                rejected = true; // blocked by Walrus: the frame went to the mover alone
+                break;
+            }
+            REQUIRE(decode(frame, delta));
+        }
+        if (rejected) {
+            faceUp |= 1u << position;
+            continue;
+        }
+        REQUIRE(delta.position == position);
+        uint8_t seen[kWireFrameSize];
+        encode(delta, frame);
+        REQUIRE(watcher.read(server, seen));
+        REQUIRE(std::memcmp(seen, frame, kWireFrameSize) == 0);
+        turn = delta.turn;
+        awaiting = (delta.flags & kDeltaAwaitingTarget) != 0;
+        faceUp = delta.faceUpMask;
+        if (delta.flags & kDeltaGameOver) {
+            for (int seat = 0; seat < 3; ++seat) {
+                REQUIRE(clients[seat].read(server, frame));
+                REQUIRE(decode(frame, over));
+            }
+            REQUIRE(watcher.read(server, frame));
+            REQUIRE(decode(frame, over));
+            break;
+        }
+        if (delta.flags & kDeltaRoundOver) {
+            for (int seat = 0; seat < 3; ++seat) {
+                REQUIRE(clients[seat].read(server, frame));
+                REQUIRE(decode(frame, sight));
+                REQUIRE(sight.round == delta.round + 1);
+            }
+            turn = sight.turn;
+            faceUp = 0;
+        }
+    }
+
+    REQUIRE(over.seats == 3);
+    REQUIRE(over.rubies[0] + over.rubies[1] + over.rubies[2] == 14);
+    REQUIRE(server.getTableCount() == 0);
+}